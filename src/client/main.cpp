@@ -0,0 +1,99 @@
+// Thin client for 'impala -server <socket>'.
+// Forwards the working directory and the command line to the server and replays its output and exit status.
+// Deliberately does not link against libimpala or Thorin so that its own startup stays negligible.
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <climits>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "impala/wire.h"
+
+using namespace std;
+using impala::read_all;
+using impala::write_all;
+
+static bool read_u32(int fd, uint32_t& u) {
+    if (!read_all(fd, &u, sizeof(u)))
+        return false;
+    u = ntohl(u);
+    return true;
+}
+
+static bool read_string(int fd, string& str) {
+    uint32_t size;
+    if (!read_u32(fd, size))
+        return false;
+    str.resize(size);
+    return size == 0 || read_all(fd, &str[0], size);
+}
+
+int main(int argc, char** argv) {
+    string socket_path;
+    if (auto env = getenv("IMPALA_SOCKET"))
+        socket_path = env;
+
+    vector<string> strings;
+    char cwd[PATH_MAX];
+    if (getcwd(cwd, sizeof(cwd)) == nullptr) {
+        cerr << "impala-client: cannot determine working directory" << endl;
+        return EXIT_FAILURE;
+    }
+    strings.emplace_back(cwd);
+    strings.emplace_back("impala");
+
+    for (int i = 1; i < argc; ++i) {
+        if ((!strcmp(argv[i], "-socket") || !strcmp(argv[i], "--socket")) && i + 1 < argc)
+            socket_path = argv[++i];
+        else
+            strings.emplace_back(argv[i]);
+    }
+
+    if (socket_path.empty()) {
+        cerr << "usage: " << argv[0] << " -socket <socket> [impala options] file..." << endl;
+        cerr << "       the socket may also be given via IMPALA_SOCKET; use -shutdown to stop the server" << endl;
+        return EXIT_FAILURE;
+    }
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        cerr << "impala-client: socket path '" << socket_path << "' is too long" << endl;
+        return EXIT_FAILURE;
+    }
+    strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0 || connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        cerr << "impala-client: cannot connect to '" << socket_path << "'; is 'impala -server " << socket_path << "' running?" << endl;
+        return EXIT_FAILURE;
+    }
+
+    uint32_t num = htonl(uint32_t(strings.size()));
+    bool ok = write_all(sock, &num, sizeof(num));
+    for (const auto& str : strings)
+        ok = ok && write_all(sock, str.c_str(), str.size() + 1);
+
+    uint32_t status;
+    string out, err;
+    ok = ok && read_u32(sock, status) && read_string(sock, out) && read_string(sock, err);
+    close(sock);
+
+    if (!ok) {
+        cerr << "impala-client: lost connection to server" << endl;
+        return EXIT_FAILURE;
+    }
+
+    cout << out << flush;
+    cerr << err << flush;
+    return int(int32_t(status));
+}
@@ -1,11 +1,20 @@
 #include "impala/ast.h"
 
+#include "impala/stats.h"
+
 using namespace thorin;
 
 namespace impala {
 
 //------------------------------------------------------------------------------
 
+ASTNode::ASTNode(Location location)
+    : location_(location)
+{
+    if (auto stats = session_state().stats)
+        stats->ast_node(this);
+}
+
 const char* Visibility::str() {
     if (visibility_ == Pub)  return "pub ";
     if (visibility_ == Priv) return "priv ";
@@ -29,6 +38,13 @@ const FnASTType* FnASTType::ret_fn_ast_type() const {
     return nullptr;
 }
 
+std::string ModuleDecl::filename() const {
+    std::string dir = location().filename();
+    auto i = dir.find_last_of("\\/");
+    dir = i == std::string::npos ? std::string() : dir.substr(0, i + 1);
+    return dir + symbol().str() + ".impala";
+}
+
 PrimTypeTag LiteralExpr::literal2type() const {
     switch (tag()) {
 #define IMPALA_LIT(itype, atype) \
@@ -36,6 +36,7 @@ class LocalDecl;
 class Param;
 class Ptrn;
 class Stmt;
+struct Intrinsic;
 
 class NameSema;
 class InferSema;
@@ -144,9 +145,7 @@ public:
     ASTNode(const ASTNode&) = delete;
     ASTNode(ASTNode&&) = delete;
 
-    ASTNode(Location location)
-        : location_(location)
-    {}
+    ASTNode(Location location);
 
 #ifndef NDEBUG
     virtual ~ASTNode() { assert(location_.is_set()); }
@@ -201,6 +200,7 @@ public:
         Symbol symbol() const { return identifier()->symbol(); }
         const Decl* decl() const { return decl_; }
         void bind(NameSema&) const;
+        void bind(const Module*, Symbol module_symbol) const;
         std::ostream& stream(std::ostream&) const override;
 
     private:
@@ -297,10 +297,11 @@ class PtrASTType : public ASTType {
 public:
     enum Tag { Borrowed, Mut, Owned };
 
-    PtrASTType(Location location, Tag tag, int addr_space, const ASTType* referenced_ast_type)
+    PtrASTType(Location location, Tag tag, int addr_space, const ASTType* referenced_ast_type, int align = 0)
         : ASTType(location)
         , tag_(tag)
         , addr_space_(addr_space)
+        , align_(align)
         , referenced_ast_type_(referenced_ast_type)
     {}
 
@@ -308,6 +309,8 @@ public:
     std::string prefix() const;
     const ASTType* referenced_ast_type() const { return referenced_ast_type_.get(); }
     int addr_space() const { return addr_space_; }
+    /// What the target is aligned to as given by <tt>#[align(N)]</tt>, or 0 for its natural alignment.
+    int align() const { return align_; }
 
     void bind(NameSema&) const override;
     std::ostream& stream(std::ostream&) const override;
@@ -318,6 +321,7 @@ private:
 
     Tag tag_;
     int addr_space_;
+    int align_;
     std::unique_ptr<const ASTType> referenced_ast_type_;
 };
 
@@ -642,6 +646,14 @@ public:
     Param(Location location, size_t handle, const Identifier* id, const ASTType* ast_type)
         : LocalDecl(location, handle, /*mut*/ false, id, ast_type)
     {}
+
+    /// Whether type analysis proved that nothing else reaches the memory of this <tt>&mut</tt> or @c ~ parameter during a call; see @c noalias_params.
+    bool is_exclusive() const { return is_exclusive_; }
+
+private:
+    mutable bool is_exclusive_ = true;
+
+    friend class TypeSema;
 };
 
 class Fn : public ASTTypeParamList {
@@ -764,12 +776,21 @@ private:
     mutable Symbol2Item symbol2item_;
 };
 
+/**
+ * <tt>mod foo;</tt> refers to the file <tt>foo.impala</tt> next to the declaring file.
+ * The file is only loaded once a path like <tt>foo::bar</tt> refers into it and is then bound in a scope of its own;
+ * only its @c pub items are visible from the outside.
+ * Several declarations of the same file share the module which is analyzed and emitted only once - by its first declaration.
+ */
 class ModuleDecl : public TypeDeclItem {
 public:
     ModuleDecl(Location location, Visibility vis, const Identifier* id, ASTTypeParams&& ast_type_params)
         : TypeDeclItem(location, vis, id, std::move(ast_type_params))
     {}
 
+    std::string filename() const;
+    /// The loaded @p Module or @c nullptr if nothing refers into it.
+    const Module* module() const { return module_; }
     void bind(NameSema&) const override;
     std::ostream& stream(std::ostream&) const override;
 
@@ -778,6 +799,12 @@ private:
     const Type* infer_head(InferSema&) const override;
     void check(TypeSema&) const override;
     void emit(CodeGen&) const override;
+
+    mutable const Module* module_ = nullptr;
+    mutable std::unique_ptr<const Module> owned_module_;
+    mutable std::string loaded_filename_; ///< @p Location%s of the loaded @p Module point into this string.
+
+    friend class NameSema;
 };
 
 class ExternBlock : public Item {
@@ -857,9 +884,10 @@ private:
 class StructDecl : public TypeDeclItem {
 public:
     StructDecl(Location location, Visibility vis, const Identifier* id,
-               ASTTypeParams&& ast_type_params, FieldDecls&& field_decls)
+               ASTTypeParams&& ast_type_params, FieldDecls&& field_decls, int align = 0)
         : TypeDeclItem(location, vis, id, std::move(ast_type_params))
         , field_decls_(std::move(field_decls))
+        , align_(align)
     {}
 
     size_t num_field_decls() const { return field_decls_.size(); }
@@ -869,6 +897,8 @@ public:
     const FieldDecl* field_decl(Symbol symbol) const { return thorin::find(field_table_, symbol); }
     const FieldDecl* field_decl(const Identifier* ident) const { return field_decl(ident->symbol()); }
     const StructType* struct_type() const { return type_->as<StructType>(); }
+    /// Given by <tt>#[align(N)]</tt>, or 0 for the natural alignment of the fields.
+    int align() const { return align_; }
 
     void bind(NameSema&) const override;
     std::ostream& stream(std::ostream&) const override;
@@ -881,6 +911,7 @@ private:
 
     FieldDecls field_decls_;
     mutable FieldTable field_table_;
+    int align_;
 };
 
 class EnumDecl : public TypeDeclItem {
@@ -898,12 +929,15 @@ private:
 class StaticItem : public ValueItem {
 public:
     StaticItem(Location location, Visibility vis, bool mut, const Identifier* id,
-               const ASTType* ast_type, const Expr* init)
+               const ASTType* ast_type, const Expr* init, int align = 0)
         : ValueItem(location, vis, mut, id, std::move(ast_type))
         , init_(dock(init_, init))
+        , align_(align)
     {}
 
     const Expr* init() const { return init_.get(); }
+    /// Given by <tt>#[align(N)]</tt> - only a mutable one lives in memory - or 0 for the natural alignment of its type.
+    int align() const { return align_; }
 
     void bind(NameSema&) const override;
     std::ostream& stream(std::ostream&) const override;
@@ -915,21 +949,27 @@ private:
     thorin::Value emit(CodeGen&, const thorin::Def* init) const override;
 
     std::unique_ptr<const Expr> init_;
+    int align_;
 };
 
 class FnDecl : public ValueItem, public Fn {
 public:
     FnDecl(Location location, Visibility vis, bool is_extern, Symbol abi, Symbol export_name,
-           const Identifier* id, ASTTypeParams&& ast_type_params, Params&& params, const Expr* body)
+           const Identifier* id, ASTTypeParams&& ast_type_params, Params&& params, const Expr* body, bool must_vectorize = false)
         : ValueItem(location, vis, /*mut*/ false, id, /*ast_type*/ nullptr)
         , Fn(std::move(ast_type_params), std::move(params), body)
         , abi_(abi)
         , export_name_(export_name)
         , is_extern_(is_extern)
+        , must_vectorize_(must_vectorize)
     {}
 
     bool is_extern() const { return is_extern_; }
     Symbol abi() const { return abi_; }
+    /// Marked <tt>#[must_vectorize]</tt>: it is an error if LLVM does not vectorize every loop in it.
+    bool must_vectorize() const { return must_vectorize_; }
+    /// The intrinsic it declares in an <tt>extern "thorin"</tt> block; set by NameSema.
+    const Intrinsic* intrinsic() const { return intrinsic_; }
 
     const FnType* fn_type() const override {
         auto t = type();
@@ -950,6 +990,8 @@ private:
     Symbol abi_;
     Symbol export_name_;
     bool is_extern_ = false;
+    bool must_vectorize_ = false;
+    mutable const Intrinsic* intrinsic_ = nullptr;
 };
 
 class TraitDecl : public Item, public ASTTypeParamList {
@@ -1652,6 +1694,8 @@ public:
     };
 
     const Expr* lhs() const { return lhs_.get(); }
+    /// The intrinsic it calls, if any; set by InferSema.
+    const Intrinsic* intrinsic() const { return intrinsic_; }
 
     void write() const override;
     bool has_side_effect() const override;
@@ -1667,6 +1711,7 @@ private:
     const thorin::Def* remit(CodeGen&, State, Location) const;
 
     std::unique_ptr<const Expr> lhs_;
+    mutable const Intrinsic* intrinsic_ = nullptr;
 
     friend class CodeGen;
 };
@@ -1758,18 +1803,21 @@ private:
 class WhileExpr : public Expr {
 public:
     WhileExpr(Location location, const LocalDecl* continue_decl, const Expr* cond,
-              const Expr* body, const LocalDecl* break_decl)
+              const Expr* body, const LocalDecl* break_decl, bool must_vectorize = false)
         : Expr(location)
         , continue_decl_(continue_decl)
         , cond_(dock(cond_, cond))
         , body_(dock(body_, body))
         , break_decl_(break_decl)
+        , must_vectorize_(must_vectorize)
     {}
 
     const Expr* cond() const { return cond_.get(); }
     const BlockExprBase* body() const { return body_.get()->as<BlockExprBase>(); }
     const LocalDecl* break_decl() const { return break_decl_.get(); }
     const LocalDecl* continue_decl() const { return continue_decl_.get(); }
+    /// Marked <tt>#[must_vectorize]</tt>: it is an error if LLVM does not vectorize this loop.
+    bool must_vectorize() const { return must_vectorize_; }
 
     bool has_side_effect() const override;
     void bind(NameSema&) const override;
@@ -1785,20 +1833,26 @@ private:
     std::unique_ptr<const Expr> cond_;
     std::unique_ptr<const Expr> body_;
     std::unique_ptr<const LocalDecl> break_decl_;
+    bool must_vectorize_;
 };
 
 class ForExpr : public Expr {
 public:
-    ForExpr(Location location, const Expr* fn_expr, const Expr* expr, const LocalDecl* break_decl)
+    ForExpr(Location location, const Expr* fn_expr, const Expr* expr, const LocalDecl* break_decl, bool must_vectorize = false)
         : Expr(location)
         , fn_expr_(dock(fn_expr_, fn_expr))
         , expr_(dock(expr_, expr))
         , break_decl_(break_decl)
+        , must_vectorize_(must_vectorize)
     {}
 
     const FnExpr* fn_expr() const { return fn_expr_.get()->as<FnExpr>(); }
     const Expr* expr() const { return expr_.get(); }
     const LocalDecl* break_decl() const { return break_decl_.get(); }
+    /// Marked <tt>#[must_vectorize]</tt>: it is an error if LLVM does not vectorize this loop.
+    bool must_vectorize() const { return must_vectorize_; }
+    /// The intrinsic it iterates with, if any; set by InferSema.
+    const Intrinsic* intrinsic() const { return intrinsic_; }
 
     bool has_side_effect() const override;
     void bind(NameSema&) const override;
@@ -1812,6 +1866,8 @@ private:
     std::unique_ptr<const Expr> fn_expr_;
     std::unique_ptr<const Expr> expr_;
     std::unique_ptr<const LocalDecl> break_decl_;
+    bool must_vectorize_;
+    mutable const Intrinsic* intrinsic_ = nullptr;
 };
 
 //------------------------------------------------------------------------------
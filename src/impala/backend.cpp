@@ -0,0 +1,356 @@
+#include "impala/backend.h"
+
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+
+#ifdef LLVM_SUPPORT
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringSet.h>
+#include <llvm/Analysis/ModuleSummaryAnalysis.h>
+#include <llvm/Analysis/ProfileSummaryInfo.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/CFG.h>
+#include <llvm/IR/DebugInfoMetadata.h>
+#include <llvm/IR/DiagnosticHandler.h>
+#include <llvm/IR/DiagnosticInfo.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/IRReader/IRReader.h>
+#include <llvm/Linker/Linker.h>
+#include <llvm/MC/SubtargetFeature.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/Target/TargetOptions.h>
+#include <llvm/Transforms/IPO/Internalize.h>
+#include <llvm/Transforms/Utils/SplitModule.h>
+#endif
+
+#include "impala/vectorizereport.h"
+
+namespace impala {
+
+#ifdef LLVM_SUPPORT
+
+std::unique_ptr<llvm::Module> load_llvm(llvm::LLVMContext& context, const std::string& filename) {
+    llvm::SMDiagnostic diag;
+    auto module = llvm::parseIRFile(filename, diag, context);
+    if (module == nullptr) {
+        std::string msg;
+        llvm::raw_string_ostream os(msg);
+        diag.print("impala", os);
+        throw std::runtime_error(os.str());
+    }
+    return module;
+}
+
+static std::unique_ptr<llvm::TargetMachine> create_target_machine(llvm::Module& module, int opt) {
+    // target registration is not thread-safe, but partitions create their target machines concurrently
+    static std::once_flag initialized;
+    std::call_once(initialized, [] {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+    });
+
+    auto triple = module.getTargetTriple().empty() ? llvm::sys::getDefaultTargetTriple() : module.getTargetTriple();
+    std::string error;
+    auto target = llvm::TargetRegistry::lookupTarget(triple, error);
+    if (target == nullptr)
+        throw std::runtime_error("cannot create target for '" + triple + "': " + error);
+
+    llvm::SubtargetFeatures features;
+    llvm::StringMap<bool> host_features;
+    if (llvm::sys::getHostCPUFeatures(host_features)) {
+        for (const auto& feature : host_features)
+            features.AddFeature(feature.first(), feature.second);
+    }
+
+    auto level = opt == 0 ? llvm::CodeGenOpt::None : opt == 1 ? llvm::CodeGenOpt::Less : opt == 3 ? llvm::CodeGenOpt::Aggressive : llvm::CodeGenOpt::Default;
+    std::unique_ptr<llvm::TargetMachine> machine(target->createTargetMachine(
+        triple, llvm::sys::getHostCPUName(), features.getString(), llvm::TargetOptions(), llvm::Reloc::PIC_, llvm::None, level));
+
+    module.setTargetTriple(triple);
+    module.setDataLayout(machine->createDataLayout());
+    return machine;
+}
+
+/// Links the runtime modules into @p module, keeping only what the program uses - and keeping that private.
+static void link(llvm::Module& module, const BackendOptions& options) {
+    llvm::Linker linker(module);
+    for (const auto& filename : options.bitcode) {
+        auto runtime = load_llvm(module.getContext(), filename);
+        bool failed = linker.linkInModule(std::move(runtime), llvm::Linker::LinkOnlyNeeded, [] (llvm::Module& module, const llvm::StringSet<>& linked) {
+            llvm::internalizeModule(module, [&] (const llvm::GlobalValue& global) {
+                return !global.hasName() || !linked.count(global.getName());
+            });
+        });
+        if (failed)
+            throw std::runtime_error("cannot link '" + filename + "'");
+    }
+}
+
+/// Marks the parameters in @c BackendOptions::noalias - those that are still pointers in a function defined in @p module.
+static void annotate(llvm::Module& module, const BackendOptions& options) {
+    for (const auto& p : options.noalias) {
+        auto function = module.getFunction(p.first);
+        if (function == nullptr || function->isDeclaration())
+            continue;
+        for (auto i : p.second) {
+            if (i < function->arg_size() && function->getArg(i)->getType()->isPointerTy())
+                function->addParamAttr(i, llvm::Attribute::NoAlias);
+        }
+    }
+}
+
+/// Debug locations of all instructions in the loop with @p header: the blocks that are reachable from it and reach it again.
+static std::vector<VectorizeReport::Position> loop_positions(const llvm::BasicBlock* header) {
+    std::unordered_set<const llvm::BasicBlock*> reachable, reaching;
+    std::vector<const llvm::BasicBlock*> queue = {header};
+    while (!queue.empty()) {
+        auto block = queue.back();
+        queue.pop_back();
+        for (auto succ : llvm::successors(block)) {
+            if (reachable.insert(succ).second)
+                queue.push_back(succ);
+        }
+    }
+    queue = {header};
+    while (!queue.empty()) {
+        auto block = queue.back();
+        queue.pop_back();
+        for (auto pred : llvm::predecessors(block)) {
+            if (reaching.insert(pred).second)
+                queue.push_back(pred);
+        }
+    }
+
+    std::vector<VectorizeReport::Position> positions;
+    for (const auto& block : *header->getParent()) {
+        if (&block != header && (!reachable.count(&block) || !reaching.count(&block)))
+            continue;
+        for (const auto& instruction : block) {
+            if (auto location = instruction.getDebugLoc().get())
+                positions.push_back({location->getFilename().str(), location->getLine(), location->getColumn()});
+        }
+    }
+    return positions;
+}
+
+/// Hands the remarks of LLVM's loop and SLP vectorizers to a @c VectorizeReport; all other diagnostics take their usual route.
+class VectorizeRemarks : public llvm::DiagnosticHandler {
+public:
+    VectorizeRemarks(VectorizeReport& report)
+        : report_(report)
+    {}
+
+    bool isAnalysisRemarkEnabled(llvm::StringRef pass) const override { return is_vectorizer(pass); }
+    bool isMissedOptRemarkEnabled(llvm::StringRef pass) const override { return is_vectorizer(pass); }
+    bool isPassedOptRemarkEnabled(llvm::StringRef pass) const override { return is_vectorizer(pass); }
+    bool isAnyRemarkEnabled() const override { return true; }
+
+    bool handleDiagnostics(const llvm::DiagnosticInfo& info) override {
+        auto remark = llvm::dyn_cast<llvm::DiagnosticInfoOptimizationBase>(&info);
+        if (remark == nullptr || !is_vectorizer(remark->getPassName()))
+            return false;
+
+        auto kind = llvm::isa<llvm::OptimizationRemark>(&info)       ? VectorizeReport::Remark::Passed
+                  : llvm::isa<llvm::OptimizationRemarkMissed>(&info) ? VectorizeReport::Remark::Missed
+                  :                                                    VectorizeReport::Remark::Analysis;
+        bool slp = remark->getPassName() == "slp-vectorizer";
+
+        // the loop vectorizer reports on the header of a loop - its location alone may well be in the iterator function
+        std::vector<VectorizeReport::Position> positions;
+        auto ir = llvm::dyn_cast<llvm::DiagnosticInfoIROptimization>(&info);
+        if (!slp && ir != nullptr && ir->getCodeRegion() != nullptr) {
+            if (auto header = llvm::dyn_cast<llvm::BasicBlock>(ir->getCodeRegion()))
+                positions = loop_positions(header);
+        }
+        if (positions.empty() && remark->isLocationAvailable()) {
+            auto location = remark->getLocation();
+            positions.push_back({location.getRelativePath().str(), location.getLine(), location.getColumn()});
+        }
+
+        report_.remark(slp, kind, remark->getMsg(), positions);
+        return true;
+    }
+
+private:
+    static bool is_vectorizer(llvm::StringRef pass) { return pass == "loop-vectorize" || pass == "slp-vectorizer"; }
+
+    VectorizeReport& report_;
+};
+
+static void optimize(llvm::Module& module, llvm::TargetMachine& machine, int opt, bool thinlto_prelink, VectorizeReport* report) {
+    if (llvm::verifyModule(module, &llvm::errs()))
+        throw std::runtime_error("broken module after linking runtime bitcode");
+
+    // as Clang does: vectorize at -O2, -O3 and -Os
+    bool vectorize = opt >= 2 || opt == -1;
+    if (report != nullptr) {
+        if (!vectorize)
+            report->not_run("LLVM's vectorizers only run at -O2, -O3 and -Os");
+        module.getContext().setDiagnosticHandler(std::make_unique<VectorizeRemarks>(*report));
+    }
+
+    llvm::LoopAnalysisManager lam;
+    llvm::FunctionAnalysisManager fam;
+    llvm::CGSCCAnalysisManager cgam;
+    llvm::ModuleAnalysisManager mam;
+    llvm::PipelineTuningOptions tuning;
+    tuning.LoopVectorization = vectorize;
+    tuning.SLPVectorization = vectorize;
+    llvm::PassBuilder builder(&machine, tuning);
+    builder.registerModuleAnalyses(mam);
+    builder.registerCGSCCAnalyses(cgam);
+    builder.registerFunctionAnalyses(fam);
+    builder.registerLoopAnalyses(lam);
+    builder.crossRegisterProxies(lam, fam, cgam, mam);
+
+    auto level = opt == -1 ? llvm::OptimizationLevel::Os
+               : opt ==  1 ? llvm::OptimizationLevel::O1
+               : opt ==  2 ? llvm::OptimizationLevel::O2
+               : opt ==  3 ? llvm::OptimizationLevel::O3
+               :             llvm::OptimizationLevel::O0;
+
+    auto passes = level == llvm::OptimizationLevel::O0 ? builder.buildO0DefaultPipeline(level, thinlto_prelink)
+                : thinlto_prelink                      ? builder.buildThinLTOPreLinkDefaultPipeline(level)
+                :                                        builder.buildPerModuleDefaultPipeline(level);
+    passes.run(module, mam);
+}
+
+static std::unique_ptr<llvm::raw_fd_ostream> open(const std::string& filename) {
+    std::error_code error;
+    auto stream = std::make_unique<llvm::raw_fd_ostream>(filename, error, llvm::sys::fs::OF_None);
+    if (error)
+        throw std::runtime_error("cannot open file " + filename + " for writing: " + error.message());
+    return stream;
+}
+
+static void write_object(llvm::Module& module, llvm::TargetMachine& machine, const std::string& obj_file) {
+    auto stream = open(obj_file);
+    llvm::legacy::PassManager codegen;
+    if (machine.addPassesToEmitFile(codegen, *stream, nullptr, llvm::CGFT_ObjectFile))
+        throw std::runtime_error("target cannot emit object files");
+    codegen.run(module);
+}
+
+static std::string partition_name(const std::string& obj_file, int i) {
+    auto dot = obj_file.find_last_of('.');
+    auto slash = obj_file.find_last_of("\\/");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return obj_file + "." + std::to_string(i);
+    return obj_file.substr(0, dot) + "." + std::to_string(i) + obj_file.substr(dot);
+}
+
+/**
+ * Splits @p module into @c options.jobs partitions and optimizes and code-generates each one in its own thread.
+ * Local symbols referenced across partitions are externalized and every partition declares what it uses from the others.
+ * Each thread needs its own @c LLVMContext, so partitions travel between threads as bitcode.
+ */
+static std::vector<std::string> emit_partitions(llvm::Module& module, const std::string& obj_file, const BackendOptions& options) {
+    std::vector<llvm::SmallString<0>> partitions;
+    llvm::SplitModule(module, unsigned(options.jobs), [&] (std::unique_ptr<llvm::Module> partition) {
+        partitions.emplace_back();
+        llvm::raw_svector_ostream os(partitions.back());
+        llvm::WriteBitcodeToFile(*partition, os);
+    }, /*PreserveLocals*/ false);
+
+    std::vector<std::string> obj_files;
+    std::vector<std::exception_ptr> errors(partitions.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 0, e = partitions.size(); i != e; ++i) {
+        obj_files.push_back(partition_name(obj_file, int(i)));
+        threads.emplace_back([&, i] {
+            try {
+                llvm::LLVMContext context;
+                llvm::MemoryBufferRef buffer(llvm::StringRef(partitions[i].data(), partitions[i].size()), obj_files[i]);
+                auto partition = llvm::parseBitcodeFile(buffer, context);
+                if (!partition)
+                    throw std::runtime_error("cannot read partition: " + llvm::toString(partition.takeError()));
+
+                auto machine = create_target_machine(**partition, options.opt);
+                optimize(**partition, *machine, options.opt, false, options.vectorize_report);
+                write_object(**partition, *machine, obj_files[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+    for (const auto& error : errors) {
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    return obj_files;
+}
+
+std::vector<std::string> emit_object(const std::string& ll_file, const std::string& obj_file, const BackendOptions& options) {
+    llvm::LLVMContext context;
+    auto module = load_llvm(context, ll_file);
+    auto machine = create_target_machine(*module, options.opt);
+    link(*module, options);
+    annotate(*module, options);
+
+    if (options.jobs > 1)
+        return emit_partitions(*module, obj_file, options);
+
+    optimize(*module, *machine, options.opt, false, options.vectorize_report);
+    write_object(*module, *machine, obj_file);
+    return {obj_file};
+}
+
+void optimize_llvm(const std::string& ll_file, const BackendOptions& options) {
+    llvm::LLVMContext context;
+    auto module = load_llvm(context, ll_file);
+    auto machine = create_target_machine(*module, options.opt);
+    link(*module, options);
+    annotate(*module, options);
+    optimize(*module, *machine, options.opt, false, options.vectorize_report);
+    module->print(*open(ll_file), nullptr);
+}
+
+void emit_bitcode(const std::string& ll_file, const std::string& bc_file, const BackendOptions& options) {
+    llvm::LLVMContext context;
+    auto module = load_llvm(context, ll_file);
+    auto machine = create_target_machine(*module, options.opt);
+    link(*module, options);
+    annotate(*module, options);
+    optimize(*module, *machine, options.opt, true, options.vectorize_report);
+
+    llvm::ProfileSummaryInfo profile(*module);
+    auto summary = llvm::buildModuleSummaryIndex(*module, nullptr, &profile);
+    auto stream = open(bc_file);
+    llvm::WriteBitcodeToFile(*module, *stream, false, &summary);
+}
+
+#else
+
+std::vector<std::string> emit_object(const std::string&, const std::string&, const BackendOptions&) {
+    throw std::logic_error("-emit-obj requires an impala built with LLVM support");
+}
+
+void optimize_llvm(const std::string&, const BackendOptions&) {
+    throw std::logic_error("-vectorize-report and #[must_vectorize] require an impala built with LLVM support");
+}
+
+void emit_bitcode(const std::string&, const std::string&, const BackendOptions&) {
+    throw std::logic_error("-emit-bc requires an impala built with LLVM support");
+}
+
+#endif
+
+}
@@ -0,0 +1,64 @@
+#ifndef IMPALA_BACKEND_H
+#define IMPALA_BACKEND_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef LLVM_SUPPORT
+#include <memory>
+
+namespace llvm {
+class LLVMContext;
+class Module;
+}
+#endif
+
+namespace impala {
+
+class VectorizeReport;
+
+/**
+ * In-process LLVM pipeline that picks up the module written by @c thorin::emit_llvm.
+ * Runtime bitcode given in @c bitcode is linked in before optimization; its definitions are internalized
+ * so that small helpers such as @c print_int or @c anydsl_alloc can be inlined into Impala code and dropped afterwards.
+ */
+struct BackendOptions {
+    int opt = 0;                      ///< As for @c thorin::emit_llvm: 0 to 3, -1 optimizes for size.
+    std::vector<std::string> bitcode; ///< Runtime modules (<tt>.bc</tt> or <tt>.ll</tt>) to link and optimize together with the program.
+    /**
+     * With more than one job, @c emit_object splits the program along function - i.e. top-level continuation - boundaries
+     * into that many partitions which are optimized and code-generated concurrently.
+     * The split only depends on the program, so the output is deterministic.
+     */
+    int jobs = 1;
+    /// If set, optimization enables LLVM's loop and SLP vectorizer remarks and reports them here; see @c VectorizeReport.
+    VectorizeReport* vectorize_report = nullptr;
+    /**
+     * Parameters - by index - of the functions - by symbol - that no other pointer aliases during a call; see @c impala::noalias_params.
+     * Thorin cannot carry this to its LLVM output, so they are marked @c noalias before optimization.
+     */
+    std::map<std::string, std::vector<unsigned>> noalias;
+};
+
+/**
+ * Links and optimizes @p ll_file and writes native object code for the host to @p obj_file.
+ * With several @c BackendOptions::jobs, partition @c i goes to @p obj_file with <tt>.i</tt> inserted before the extension.
+ * Returns the names of all written object files.
+ */
+std::vector<std::string> emit_object(const std::string& ll_file, const std::string& obj_file, const BackendOptions&);
+
+/// Links and optimizes @p ll_file and writes it back; for when nothing else optimizes in process but a @c VectorizeReport is wanted.
+void optimize_llvm(const std::string& ll_file, const BackendOptions&);
+
+/// Links and optimizes @p ll_file for a later ThinLTO link and writes bitcode including a module summary to @p bc_file.
+void emit_bitcode(const std::string& ll_file, const std::string& bc_file, const BackendOptions&);
+
+#ifdef LLVM_SUPPORT
+/// Parses the LLVM IR or bitcode in @p filename; throws @c std::runtime_error with LLVM's diagnostic if that fails.
+std::unique_ptr<llvm::Module> load_llvm(llvm::LLVMContext&, const std::string& filename);
+#endif
+
+}
+
+#endif
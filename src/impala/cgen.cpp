@@ -268,7 +268,10 @@ public:
 
                 o << "    " << ctype_pref << ' ' << field->symbol().str() << ctype_suf << ";\n";
             }
-            o << "};\n" << std::endl;
+            o << "}";
+            if (st->align() != 0)
+                o << " __attribute__((aligned(" << st->align() << ")))";
+            o << ";\n" << std::endl;
         }
 
         return true;
@@ -300,6 +303,11 @@ public:
                     return false;
                 }
 
+                // the parameters that are marked noalias hold C callers to the same rule; see noalias_params
+                auto ptr_type = fn_type->op(i)->isa<PtrType>();
+                if (ptr_type != nullptr && (ptr_type->is_mut() || ptr_type->isa<OwnedPtrType>()) && fn->body() != nullptr && fn->param(i)->is_exclusive())
+                    ctype_pref += " __restrict";
+
                 o << ctype_pref << ' ' << fn->param(i)->symbol().str() << ctype_suf;
 
                 if (i < fn_type->num_ops() - 2)
@@ -0,0 +1,191 @@
+#include "impala/costreport.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef LLVM_SUPPORT
+#include <llvm/IR/DebugInfoMetadata.h>
+#include <llvm/IR/Module.h>
+#endif
+
+#include "thorin/world.h"
+
+#include "impala/ast.h"
+#include "impala/backend.h"
+#include "impala/impala.h"
+
+namespace impala {
+
+CostReport::Timer::Timer(Phase phase, const FnDecl* fn_decl)
+    : report_(session_state().cost_report)
+    , phase_(phase)
+{
+    if (report_ != nullptr)
+        report_->frames_.push_back({&report_->entry(fn_decl), Clock::now(), Clock::duration::zero()});
+}
+
+CostReport::Timer::~Timer() {
+    if (report_ == nullptr)
+        return;
+
+    auto frame = report_->frames_.back();
+    report_->frames_.pop_back();
+    auto elapsed = Clock::now() - frame.start;
+    frame.entry->ms[phase_] += std::chrono::duration<double, std::milli>(elapsed - frame.children).count();
+    if (!report_->frames_.empty())
+        report_->frames_.back().children += elapsed;
+}
+
+auto CostReport::entry(const FnDecl* fn_decl) -> Entry& {
+    auto i = entries_.find(fn_decl);
+    if (i == entries_.end()) {
+        i = entries_.emplace(fn_decl, Entry()).first;
+        i->second.fn_decl = fn_decl;
+        files_.clear();
+    }
+    return i->second;
+}
+
+void CostReport::index() {
+    if (!files_.empty())
+        return;
+
+    for (auto& p : entries_) {
+        auto filename = p.first->location().filename();
+        if (filename != nullptr)
+            files_[filename].push_back(&p.second);
+    }
+
+    for (auto& p : files_) {
+        std::sort(p.second.begin(), p.second.end(), [] (const Entry* a, const Entry* b) {
+            return a->fn_decl->location().front_line() < b->fn_decl->location().front_line();
+        });
+    }
+}
+
+auto CostReport::attribute(const std::string& filename, unsigned line) -> Entry* {
+    auto file = files_.find(filename);
+    if (file == files_.end()) {
+        // debug info may spell the path differently
+        file = std::find_if(files_.begin(), files_.end(), [&] (const std::pair<const std::string, std::vector<Entry*>>& p) {
+            return basename(p.first) == basename(filename);
+        });
+        if (file == files_.end())
+            return nullptr;
+    }
+
+    // ranges nest, so the last function starting at or before line that still contains it is the innermost one
+    const auto& entries = file->second;
+    auto i = std::upper_bound(entries.begin(), entries.end(), line, [] (unsigned line, const Entry* entry) {
+        return line < entry->fn_decl->location().front_line();
+    });
+    while (i != entries.begin()) {
+        auto entry = *--i;
+        if (line <= entry->fn_decl->location().back_line())
+            return entry;
+    }
+    return nullptr;
+}
+
+void CostReport::count_defs(const thorin::World& world) {
+    index();
+
+    auto count = [&] (const thorin::Def* def) {
+        const thorin::Location& location = def->debug();
+        if (location.filename() != nullptr) {
+            if (auto entry = attribute(location.filename(), location.front_line())) {
+                ++entry->defs;
+                return;
+            }
+        }
+        ++unattributed_defs_;
+    };
+
+    for (auto continuation : world.continuations())
+        count(continuation);
+    for (auto primop : world.primops())
+        count(primop);
+}
+
+#ifdef LLVM_SUPPORT
+
+void CostReport::count_llvm(const std::string& ll_file) {
+    index();
+
+    llvm::LLVMContext context;
+    auto module = load_llvm(context, ll_file);
+
+    for (const auto& function : *module) {
+        for (const auto& block : function) {
+            for (const auto& instruction : block) {
+                auto location = instruction.getDebugLoc().get();
+                Entry* entry = nullptr;
+                if (location != nullptr) {
+                    std::string filename = location->getFilename().str();
+                    entry = attribute(filename, location->getLine());
+                    if (entry == nullptr && !location->getDirectory().empty())
+                        entry = attribute(location->getDirectory().str() + "/" + filename, location->getLine());
+                }
+                ++(entry != nullptr ? entry->llvm : unattributed_llvm_);
+            }
+        }
+    }
+    llvm_counted_ = true;
+}
+
+#else
+
+void CostReport::count_llvm(const std::string&) {}
+
+#endif
+
+void CostReport::write(std::ostream& os) const {
+    std::vector<const Entry*> entries;
+    for (const auto& p : entries_)
+        entries.push_back(&p.second);
+    std::sort(entries.begin(), entries.end(), [] (const Entry* a, const Entry* b) {
+        if (a->total_ms() != b->total_ms()) return a->total_ms() > b->total_ms();
+        if (a->llvm != b->llvm) return a->llvm > b->llvm;
+        return a->defs > b->defs;
+    });
+
+    auto flags = os.flags();
+    auto precision = os.precision();
+    os << std::left << std::setw(40) << "location" << std::setw(24) << "function" << std::right
+       << std::setw(10) << "infer ms" << std::setw(10) << "check ms" << std::setw(10) << "emit ms" << std::setw(10) << "total ms"
+       << std::setw(10) << "defs" << std::setw(10) << "llvm" << std::endl;
+    os << std::fixed << std::setprecision(3);
+    for (auto entry : entries) {
+        auto location = entry->fn_decl->location();
+        std::ostringstream where;
+        where << (location.filename() != nullptr ? location.filename() : "<unknown>") << ':' << location.front_line();
+        os << std::left << std::setw(40) << where.str() << std::setw(24) << entry->fn_decl->symbol().str() << std::right
+           << std::setw(10) << entry->ms[Infer] << std::setw(10) << entry->ms[Check] << std::setw(10) << entry->ms[Emit]
+           << std::setw(10) << entry->total_ms() << std::setw(10) << entry->defs;
+        if (llvm_counted_)
+            os << std::setw(10) << entry->llvm;
+        else
+            os << std::setw(10) << '-';
+        os << std::endl;
+    }
+    os << std::left << std::setw(64) << "<unattributed>" << std::right << std::setw(50) << unattributed_defs_;
+    if (llvm_counted_)
+        os << std::setw(10) << unattributed_llvm_;
+    else
+        os << std::setw(10) << '-';
+    os << std::endl;
+    os.flags(flags);
+    os.precision(precision);
+}
+
+CostReportScope::CostReportScope(CostReport* report)
+    : prev_(session_state().cost_report)
+{
+    session_state().cost_report = report;
+}
+
+CostReportScope::~CostReportScope() { session_state().cost_report = prev_; }
+
+}
@@ -0,0 +1,89 @@
+#ifndef IMPALA_COSTREPORT_H
+#define IMPALA_COSTREPORT_H
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace thorin { class World; }
+
+namespace impala {
+
+class FnDecl;
+
+/**
+ * Attributes compile cost to the source functions that cause it.
+ * Front-end time is measured per @c FnDecl for inference, checking and emission; nested functions are subtracted from their parents.
+ * Back-end size is counted per originating @c FnDecl via debug locations: Thorin defs - including specializations, which keep the
+ * location of what they were cloned from - and LLVM instructions.
+ * Install it in the current @c SessionState via @c CostReportScope; @c CostReport::Timer is a no-op otherwise.
+ */
+class CostReport {
+public:
+    enum Phase { Infer, Check, Emit, Num_Phases };
+
+    /// Measures the enclosing scope as @p phase of @p fn_decl if a @c CostReport is installed.
+    class Timer {
+    public:
+        Timer(Phase phase, const FnDecl* fn_decl);
+        ~Timer();
+
+    private:
+        CostReport* report_;
+        Phase phase_;
+    };
+
+    /// Attributes all continuations and primops of @p world.
+    void count_defs(const thorin::World& world);
+    /// Attributes the instructions of the LLVM module in @p ll_file; needs debug locations - see @c thorin::emit_llvm.
+    void count_llvm(const std::string& ll_file);
+    /// Writes one line per function, most expensive first.
+    void write(std::ostream&) const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entry {
+        const FnDecl* fn_decl;
+        double ms[Num_Phases] = {};
+        size_t defs = 0;
+        size_t llvm = 0;
+
+        double total_ms() const { return ms[Infer] + ms[Check] + ms[Emit]; }
+    };
+
+    struct Frame {
+        Entry* entry;
+        Clock::time_point start;
+        Clock::duration children;
+    };
+
+    Entry& entry(const FnDecl*);
+    /// Sorts all entries by file and first line for @c attribute.
+    void index();
+    /// The innermost function whose source range contains @p line of @p filename - or @c nullptr.
+    Entry* attribute(const std::string& filename, unsigned line);
+
+    std::unordered_map<const FnDecl*, Entry> entries_;
+    std::unordered_map<std::string, std::vector<Entry*>> files_;
+    std::vector<Frame> frames_;
+    size_t unattributed_defs_ = 0;
+    size_t unattributed_llvm_ = 0;
+    bool llvm_counted_ = false;
+};
+
+/// Installs @p report - which may be @c nullptr - in the current @c SessionState for the lifetime of the scope.
+class CostReportScope {
+public:
+    CostReportScope(CostReport* report);
+    ~CostReportScope();
+
+private:
+    CostReport* prev_;
+};
+
+}
+
+#endif
@@ -1,4 +1,7 @@
-#include "impala/ast.h"
+#include "impala/emit.h"
+
+#include <algorithm>
+#include <unordered_map>
 
 #include "thorin/irbuilder.h"
 #include "thorin/continuation.h"
@@ -7,93 +10,15 @@
 #include "thorin/world.h"
 #include "thorin/util/array.h"
 
+#include "impala/costreport.h"
+#include "impala/intrinsics.h"
+#include "impala/pebudget.h"
+#include "impala/vectorizereport.h"
+
 using namespace thorin;
 
 namespace impala {
 
-class CodeGen : public IRBuilder {
-public:
-    CodeGen(World& world)
-        : IRBuilder(world)
-    {}
-
-    const Def* frame() const { assert(cur_fn); return cur_fn->frame(); }
-    /// Enter \p x and perform \p get_value to collect return value.
-    const Def* converge(const Expr* expr, JumpTarget& x) {
-        emit_jump(expr, x);
-        if (enter(x))
-            return cur_bb->get_value(1, convert(expr->type()));
-        return nullptr;
-    }
-
-    void emit_jump_boolean(bool val, JumpTarget& x, const thorin::Location& loc) {
-        if (is_reachable()) {
-            cur_bb->set_value(1, world().literal(val, loc));
-            jump(x, loc);
-        }
-    }
-
-    Continuation* create_continuation(const LocalDecl* decl) {
-        auto result = continuation(convert(decl->type())->as<thorin::FnType>(), decl->debug());
-        result->param(0)->debug().set("mem");
-        decl->value_ = Value::create_val(*this, result);
-        return result;
-    }
-
-    void set_continuation(Continuation* continuation) {
-        cur_bb = continuation;
-        set_mem(continuation->param(0));
-    }
-
-    void jump_to_continuation(Continuation* continuation, const thorin::Location& loc) {
-        if (is_reachable())
-            cur_bb->jump(continuation, {get_mem()}, loc);
-        set_continuation(continuation);
-    }
-
-    Value lemit(const Expr* expr) { return expr->lemit(*this); }
-    const Def* remit(const Expr* expr) { return expr->remit(*this); }
-    const Def* remit(const Expr* expr, MapExpr::State state, Location eval_loc) {
-        return expr->as<MapExpr>()->remit(*this, state, eval_loc);
-    }
-    void emit_jump(const Expr* expr, JumpTarget& x) { if (is_reachable()) expr->emit_jump(*this, x); }
-    void emit_branch(const Expr* expr, JumpTarget& t, JumpTarget& f) { expr->emit_branch(*this, t, f); }
-    void emit(const Stmt* stmt) { if (is_reachable()) stmt->emit(*this); }
-    void emit(const Item* item) {
-        assert(!item->done_);
-        item->emit(*this);
-#ifndef NDEBUG
-        item->done_ = true;
-#endif
-    }
-    void emit(const Ptrn* ptrn, const thorin::Def* def) { ptrn->emit(*this, def); }
-    Value emit(const Decl* decl) {
-        assert(decl->value_.tag() != thorin::Value::Empty);
-        return decl->value_;
-    }
-    Value emit(const Decl* decl, const Def* init) {
-        if (!decl->value_)
-            decl->value_ = decl->emit(*this, init);
-        return decl->value_;
-    }
-    const thorin::Type* convert(const Type* type) {
-        if (auto t = thorin_type(type))
-            return t;
-        auto t = convert_rec(type);
-        return thorin_type(type) = t;
-    }
-
-    void convert_ops(const Type*, std::vector<const thorin::Type*>& nops);
-    const thorin::Type* convert_rec(const Type*);
-
-    const thorin::Type*& thorin_type(const Type* type) { return impala2thorin_[type]; }
-    const thorin::StructType*& thorin_struct_type(const StructType* type) { return struct_type_impala2thorin_[type]; }
-
-    const Fn* cur_fn = nullptr;
-    TypeMap<const thorin::Type*> impala2thorin_;
-    GIDMap<const StructType*, const thorin::StructType*> struct_type_impala2thorin_;
-};
-
 /*
  * Type
  */
@@ -125,12 +50,15 @@ const thorin::Type* CodeGen::convert_rec(const Type* type) {
         convert_ops(tuple_type, nops);
         return world().tuple_type(nops);
     } else if (auto struct_type = type->isa<StructType>()) {
-        auto s = world().struct_type(struct_type->struct_decl()->symbol().str(), struct_type->num_ops());
+        auto align = struct_type->struct_decl()->align();
+        auto s = world().struct_type(struct_type->struct_decl()->symbol().str(), struct_type->num_ops() + (align != 0 ? 1 : 0));
         thorin_struct_type(struct_type) = s;
         thorin_type(type) = s;
         size_t i = 0;
         for (const auto& op : struct_type->ops())
             thorin_struct_type(struct_type)->set(i++, convert(op));
+        if (align != 0)
+            thorin_struct_type(struct_type)->set(i, align_type(align));
         thorin_type(type) = nullptr; // will be set again by CodeGen's wrapper
         return thorin_struct_type(struct_type);
     } else if (auto ptr_type = type->isa<PtrType>()) {
@@ -192,6 +120,7 @@ void Fn::emit_body(CodeGen& cg, Location location) const {
         auto p = continuation()->param(i++);
         p->debug().set(param->symbol().str());
         cg.emit(param.get(), p);
+        cg.assume_aligned(param->type(), p, param->location());
     }
     assert(i == continuation()->num_params());
     if (continuation()->num_params() != 0 && continuation()->params().back()->type()->isa<thorin::FnType>())
@@ -226,16 +155,10 @@ void Module::emit(CodeGen& cg) const {
         cg.emit(item.get());
 }
 
-static bool is_primop(const Symbol& name) {
-    if      (name == "select")   return true;
-    else if (name == "sizeof")   return true;
-    else if (name == "bitcast")  return true;
-    return false;
-}
-
 Value FnDecl::emit(CodeGen& cg, const Def*) const {
+    CostReport::Timer timer(CostReport::Emit, this);
     // no code is emitted for primops
-    if (is_extern() && abi() == "\"thorin\"" && is_primop(symbol()))
+    if (intrinsic() != nullptr && intrinsic()->primop)
         return value_;
 
     // create thorin function
@@ -248,6 +171,11 @@ Value FnDecl::emit(CodeGen& cg, const Def*) const {
         continuation()->make_external();
     }
 
+    if (must_vectorize()) {
+        if (auto report = session_state().vectorize_report)
+            report->must_vectorize(this);
+    }
+
     if (body())
         emit_body(cg, location());
     return value_;
@@ -261,12 +189,14 @@ void ExternBlock::emit(CodeGen& cg) const {
             continuation->cc() = thorin::CC::C;
         else if (abi() == "\"device\"")
             continuation->cc() = thorin::CC::Device;
-        else if (abi() == "\"thorin\"" && continuation) // no continuation for primops
+        else if (abi() == "\"thorin\"" && continuation && fn_decl->intrinsic()->emit == nullptr) // no continuation for primops; the others call what they emit
             continuation->set_intrinsic();
     }
 }
 
-void ModuleDecl::emit(CodeGen&) const {
+void ModuleDecl::emit(CodeGen& cg) const {
+    if (owned_module_)
+        cg.emit(owned_module_.get());
 }
 
 void ImplItem::emit(CodeGen& cg) const {
@@ -290,7 +220,13 @@ Value StaticItem::emit(CodeGen& cg, const Def* init) const {
     init = !this->init() ? cg.world().bottom(cg.convert(type()), location()) : cg.remit(this->init());
     if (!is_mut())
         return Value::create_val(cg, init);
-    return Value::create_ptr(cg, cg.world().global(init, true, debug()));
+    if (align() == 0)
+        return Value::create_ptr(cg, cg.world().global(init, true, debug()));
+
+    // the global is the value followed by a field of no size that aligns it
+    auto& w = cg.world();
+    auto global = w.global(w.tuple({init, w.bottom(cg.align_type(align()), location())}, location()), true, debug());
+    return Value::create_ptr(cg, w.lea(global, w.literal_qu32(0, location()), location()));
 }
 
 void StructDecl::emit(CodeGen& cg) const {
@@ -346,7 +282,10 @@ const Def* StrExpr::remit(CodeGen& cg) const {
 const Def* CastExpr::remit(CodeGen& cg) const {
     auto def = cg.remit(src());
     auto thorin_type = cg.convert(type());
-    return cg.world().convert(thorin_type, def, location());
+    auto result = cg.world().convert(thorin_type, def, location());
+    auto src_ptr_type = src()->type()->isa<PtrType>();
+    cg.assume_aligned(type(), result, location(), src_ptr_type != nullptr ? src_ptr_type->align() : 0);
+    return result;
 }
 
 Value Ref2ValueExpr::lemit(CodeGen& cg) const {
@@ -527,10 +466,13 @@ const Def* SimdExpr::remit(CodeGen& cg) const {
 }
 
 const Def* StructExpr::remit(CodeGen& cg) const {
-    Array<const Def*> defs(num_elems());
+    auto struct_type = cg.convert(type())->as<thorin::StructType>();
+    Array<const Def*> defs(struct_type->num_ops());
     for (const auto& elem : elems())
         defs[elem->field_decl()->index()] = cg.remit(elem->expr());
-    return cg.world().struct_agg(cg.convert(type())->as<thorin::StructType>(), defs, location());
+    if (defs.size() != num_elems()) // the field of #[align(N)]
+        defs.back() = cg.world().bottom(struct_type->ops().back(), location());
+    return cg.world().struct_agg(struct_type, defs, location());
 }
 
 Value TypeAppExpr::lemit(CodeGen&) const { THORIN_UNREACHABLE; }
@@ -547,54 +489,45 @@ Value MapExpr::lemit(CodeGen& cg) const {
 
 const Def* MapExpr::remit(CodeGen& cg) const { return remit(cg, None, Location()); }
 
+/// Whether to specialize the @c @ annotation at @p location; @p callee is the annotated function expression, if any.
+static bool specialize(const Location& location, const Expr* callee) {
+    auto budget = session_state().pe_budget;
+    if (budget == nullptr)
+        return true;
+
+    const FnDecl* fn_decl = nullptr;
+    if (auto path = callee != nullptr ? callee->isa<PathExpr>() : nullptr) {
+        if (path->value_decl() != nullptr)
+            fn_decl = path->value_decl()->isa<FnDecl>();
+    }
+    return budget->specialize(location, fn_decl);
+}
+
 const Def* MapExpr::remit(CodeGen& cg, State state, Location eval_loc) const {
     auto ltype = unpack_ref_type(lhs()->type());
 
     if (auto fn_type = ltype->isa<FnType>()) {
         const Def* dst = nullptr;
 
-        // Handle primops here
-        if (auto type_expr = lhs()->isa<TypeAppExpr>()) { // Bitcast, sizeof and select are all polymorphic
-            if (auto path = type_expr->lhs()->isa<PathExpr>()) {
-                if (auto fn_decl = path->value_decl()->isa<FnDecl>()) {
-                    if (fn_decl->is_extern() && fn_decl->abi() == "\"thorin\"") {
-                        auto name = fn_decl->fn_symbol().remove_quotation();
-                        if (name == "bitcast") {
-                            return cg.world().bitcast(cg.convert(type_expr->type_arg(0)), cg.remit(arg(0)), eval_loc);
-                        } else if (name == "select") {
-                            return cg.world().select(cg.remit(arg(0)), cg.remit(arg(1)), cg.remit(arg(2)), eval_loc);
-                        } else if (name == "sizeof") {
-                            return cg.world().size_of(cg.convert(type_expr->type_arg(0)), eval_loc);
-                        } else if (name == "reserve_shared") {
-                            auto ptr_type = cg.convert(type());
-                            auto fn_type = cg.world().fn_type({
-                                cg.world().mem_type(), cg.world().type_qs32(),
-                                cg.world().fn_type({ cg.world().mem_type(), ptr_type }) });
-                            auto cont = cg.world().continuation(fn_type, {location(), "reserve_shared"});
-                            cont->set_intrinsic();
-                            dst = cont;
-                        } else if (name == "atomic") {
-                            auto poly_type = cg.convert(type());
-                            auto ptr_type = cg.convert(arg(1)->type());
-                            auto fn_type = cg.world().fn_type({
-                                cg.world().mem_type(), cg.world().type_pu32(), ptr_type, poly_type,
-                                cg.world().fn_type({ cg.world().mem_type(), poly_type }) });
-                            auto cont = cg.world().continuation(fn_type, {location(), "atomic"});
-                            cont->set_intrinsic();
-                            dst = cont;
-                        } else if (name == "cmpxchg") {
-                            auto ptr_type = cg.convert(arg(0)->type());
-                            auto poly_type = ptr_type->as<thorin::PtrType>()->pointee();
-                            auto fn_type = cg.world().fn_type({
-                                cg.world().mem_type(), ptr_type, poly_type, poly_type,
-                                cg.world().fn_type({ cg.world().mem_type(), poly_type, cg.world().type_bool() }) });
-                            auto cont = cg.world().continuation(fn_type, {location(), "cmpxchg"});
-                            cont->set_intrinsic();
-                            dst = cont;
-                        }
-                    }
-                }
+        if (intrinsic_ != nullptr && intrinsic_->emit != nullptr) {
+            IntrinsicCall call(cg.world(), location(), this);
+            if (auto type_app = lhs()->isa<TypeAppExpr>()) {
+                for (auto type_arg : type_app->type_args())
+                    call.type_args.push_back(cg.convert(type_arg));
+            }
+            for (const auto& arg : args())
+                call.arg_types.push_back(cg.convert(arg->type()));
+            call.type = cg.convert(type());
+
+            if (intrinsic_->primop) {
+                for (const auto& arg : args())
+                    call.args.push_back(cg.remit(arg.get()));
+                call.mem = cg.get_mem();
+                auto result = intrinsic_->emit(call);
+                cg.set_mem(call.mem);
+                return result;
             }
+            dst = intrinsic_->emit(call);
         }
 
         dst = dst ? dst : cg.remit(lhs());
@@ -611,6 +544,9 @@ const Def* MapExpr::remit(CodeGen& cg, State state, Location eval_loc) const {
         if (ret_type)
             cg.set_mem(cg.cur_bb->param(0));
 
+        if (state == Run && !specialize(eval_loc, lhs()))
+            state = None;
+
         if (state != None) {
             auto eval = state == Run ? &thorin::World::run : &thorin::World::hlt;
             auto cont = old_bb->args().back();
@@ -641,6 +577,9 @@ const Def* BlockExprBase::remit(CodeGen& cg) const {
 }
 
 const Def* RunBlockExpr::remit(CodeGen& cg) const {
+    if (!specialize(location(), nullptr))
+        return BlockExprBase::remit(cg);
+
     if (cg.is_reachable()) {
         World& w = cg.world();
         auto lrun = w.basicblock({location(), "run_block"});
@@ -688,6 +627,9 @@ const Def* WhileExpr::remit(CodeGen& cg) const {
 }
 
 void WhileExpr::emit_jump(CodeGen& cg, JumpTarget& exit_bb) const {
+    if (auto report = session_state().vectorize_report)
+        report->loop(location(), "while", must_vectorize());
+
     JumpTarget head_bb({cond()->location().front(), "while_head"});
     JumpTarget body_bb({body()->location().front(), "while_body"});
     auto continue_continuation = cg.create_continuation(continue_decl());
@@ -704,7 +646,335 @@ void WhileExpr::emit_jump(CodeGen& cg, JumpTarget& exit_bb) const {
     cg.enter(exit_bb);
 }
 
+/**
+ * Emits the body of a loop over @c vectorize for @c width consecutive indices at once.
+ * What varies with the index - the index itself, the variables of the body and what is computed from them - is a simd vector of the lanes;
+ * arrays are loaded and stored at the loop index with LLVM's masked vector loads and stores. Only the lanes under the mask run.
+ * What does not vary is emitted as usual, once for all lanes. TypeSema has ruled out anything else; see @c check_lanes.
+ */
+class LaneEmitter {
+public:
+    /// The lanes start at @p index; with an @p upper bound, those at or beyond it are masked off.
+    LaneEmitter(CodeGen& cg, const FnExpr* fn_expr, uint64_t width, const Def* index, const Def* upper, Location location)
+        : cg_(cg)
+        , w_(cg.world())
+        , fn_expr_(fn_expr)
+        , width_(width)
+        , index_(index)
+    {
+        std::vector<const Def*> iota;
+        for (uint64_t i = 0; i != width; ++i)
+            iota.push_back(w_.literal_qs32(int32_t(i), location));
+        auto indices = w_.binop(ArithOp_add, splat(index, location), w_.vector(iota, location), location);
+        masked_ = upper != nullptr;
+        mask_ = masked_ ? w_.binop(Cmp_lt, indices, splat(upper, location), location) : splat(w_.literal(true, location), location);
+        if (fn_expr->num_params() > 1)
+            lanes_[fn_expr->param(0)] = indices;
+    }
+
+    void emit() {
+        auto body = fn_expr_->body();
+        if (auto block = body->isa<BlockExprBase>()) {
+            for (const auto& stmt : block->stmts()) {
+                if (auto let = stmt->isa<LetStmt>()) {
+                    auto type = vector_type(let->ptrn()->type());
+                    lanes_[let->ptrn()->as<IdPtrn>()->local()] = let->init() ? lanes(let->init()) : w_.bottom(type, let->location());
+                } else {
+                    assign(stmt->as<ExprStmt>()->expr());
+                }
+            }
+            body = block->expr();
+        }
+        assign(body);
+    }
+
+private:
+    const Def* splat(const Def* def, Location location) { return w_.vector(std::vector<const Def*>(width_, def), location); }
+
+    const thorin::Type* vector_type(const Type* type) {
+        return w_.type(cg_.convert(type)->as<thorin::PrimType>()->primtype_tag(), width_);
+    }
+
+    bool varies(const Expr* expr) const {
+        if (auto path = expr->isa<PathExpr>())
+            return lanes_.count(path->value_decl()) != 0;
+        if (auto cast = expr->isa<CastExpr>())
+            return varies(cast->src());
+        if (auto prefix = expr->isa<PrefixExpr>())
+            return varies(prefix->rhs());
+        if (auto infix = expr->isa<InfixExpr>())
+            return varies(infix->lhs()) || varies(infix->rhs());
+        if (auto map = expr->isa<MapExpr>())
+            return varies(map->lhs()) || std::any_of(map->args().begin(), map->args().end(), [&] (const std::unique_ptr<const Expr>& arg) { return varies(arg.get()); });
+        return false;
+    }
+
+    /// The simd vector of the lanes of @p expr.
+    const Def* lanes(const Expr* expr) {
+        auto location = expr->location();
+        if (!varies(expr))
+            return splat(cg_.remit(expr), location);
+        if (auto path = expr->isa<PathExpr>())
+            return lanes_[path->value_decl()];
+        if (auto cast = expr->isa<CastExpr>()) {
+            if (cast->isa<Ref2ValueExpr>() && cast->src()->isa<MapExpr>())
+                return load(cast->src()->as<MapExpr>());
+            auto def = lanes(cast->src());
+            auto type = vector_type(cast->type());
+            return def->type() == type ? def : w_.convert(type, def, location);
+        }
+        if (auto prefix = expr->isa<PrefixExpr>()) {
+            auto rhs = lanes(prefix->rhs());
+            switch (prefix->tag()) {
+                case PrefixExpr::SUB: return w_.arithop_minus(rhs, location);
+                case PrefixExpr::NOT: return w_.arithop_not(rhs, location);
+                default:              return rhs;
+            }
+        }
+        if (auto infix = expr->isa<InfixExpr>())
+            return binop((TokenTag) infix->tag(), lanes(infix->lhs()), lanes(infix->rhs()), infix->lhs()->type(), location);
+        return load(expr->as<MapExpr>());
+    }
+
+    const Def* binop(TokenTag op, const Def* lhs, const Def* rhs, const Type* type, Location location) {
+        auto tag = Token::to_binop(op);
+        // masked-off lanes hold anything, but must not divide by zero
+        if (masked_ && is_int(unpack_ref_type(type)) && (tag == ArithOp_div || tag == ArithOp_rem))
+            rhs = w_.select(mask_, rhs, splat(w_.one(cg_.convert(unpack_ref_type(type)), location), location), location);
+        return w_.binop(tag, lhs, rhs, location);
+    }
+
+    /// A statement: an assignment to a variable or to an array element, or nothing.
+    void assign(const Expr* expr) {
+        auto infix = expr->isa<InfixExpr>();
+        if (infix == nullptr)
+            return;
+
+        auto op = (TokenTag) infix->tag();
+        auto location = infix->location();
+        auto value = lanes(infix->rhs());
+        if (auto path = infix->lhs()->isa<PathExpr>()) {
+            auto& var = lanes_[path->value_decl()];
+            if (op != Token::ASGN)
+                value = binop(Token::separate_assign(op), var, value, infix->lhs()->type(), location);
+            var = value;
+        } else {
+            auto map = infix->lhs()->as<MapExpr>();
+            if (op != Token::ASGN)
+                value = binop(Token::separate_assign(op), load(map), value, infix->lhs()->type(), location);
+            store(map, value);
+        }
+    }
+
+    /// The loop index, plus or minus what does not vary, at which the lanes of @p expr start.
+    const Def* first_index(const Expr* expr) {
+        while (expr->isa<Ref2ValueExpr>() || expr->isa<ImplicitCastExpr>())
+            expr = expr->as<CastExpr>()->src();
+        auto infix = expr->isa<InfixExpr>();
+        if (infix == nullptr)
+            return index_;
+        auto tag = Token::to_binop((TokenTag) infix->tag());
+        if (varies(infix->lhs()))
+            return w_.binop(tag, first_index(infix->lhs()), cg_.remit(infix->rhs()), infix->location());
+        return w_.binop(tag, cg_.remit(infix->lhs()), first_index(infix->rhs()), infix->location());
+    }
+
+    /// The arguments of LLVM's masked load and store that address the array elements @p map subscripts for the lanes; sets @p name to what LLVM calls the instance.
+    std::vector<const Def*> address(const MapExpr* map, const char* op, std::string& name) {
+        auto location = map->location();
+        auto elem_type = unpack_ref_type(map->type());
+        auto elem = w_.lea(cg_.lemit(map->lhs()).def(), first_index(map->arg(0)), location);
+        auto addr_space = elem->type()->as<thorin::PtrType>()->addr_space();
+        auto suffix = "v" + std::to_string(width_) + llvm_suffix(elem_type);
+        name = std::string("llvm.masked.") + op + "." + suffix + ".p" + std::to_string(int(addr_space)) + suffix;
+        return {
+            w_.bitcast(w_.ptr_type(vector_type(elem_type), 1, -1, addr_space), elem, location),
+            w_.literal_qs32(std::max(1, num_bits(elem_type) / 8), location),
+            mask_
+        };
+    }
+
+    const Def* load(const MapExpr* map) {
+        auto location = map->location();
+        auto type = vector_type(unpack_ref_type(map->type()));
+        std::string name;
+        auto args = address(map, "load", name);
+        args.push_back(w_.bottom(type, location)); // what masked-off lanes hold
+        std::vector<const thorin::Type*> param_types = { w_.mem_type() };
+        for (auto arg : args)
+            param_types.push_back(arg->type());
+        param_types.push_back(w_.fn_type({ w_.mem_type(), type }));
+
+        args.insert(args.begin(), cg_.get_mem());
+        auto result = cg_.call(llvm_intrinsic(w_, location, name, w_.fn_type(param_types)), args, type, Debug(location, "vectorize_load"));
+        cg_.set_mem(cg_.cur_bb->param(0));
+        return result;
+    }
+
+    void store(const MapExpr* map, const Def* value) {
+        auto location = map->location();
+        std::string name;
+        auto args = address(map, "store", name);
+        args.insert(args.begin(), value);
+        std::vector<const thorin::Type*> param_types = { w_.mem_type() };
+        for (auto arg : args)
+            param_types.push_back(arg->type());
+        param_types.push_back(w_.fn_type({ w_.mem_type() }));
+
+        args.insert(args.begin(), cg_.get_mem());
+        cg_.call(llvm_intrinsic(w_, location, name, w_.fn_type(param_types)), args, w_.tuple_type({}), Debug(location, "vectorize_store"));
+        cg_.set_mem(cg_.cur_bb->param(0));
+    }
+
+    CodeGen& cg_;
+    thorin::World& w_;
+    const FnExpr* fn_expr_;
+    uint64_t width_;
+    const Def* index_;
+    const Def* mask_;
+    bool masked_;
+    std::unordered_map<const Decl*, const Def*> lanes_;
+};
+
+/**
+ * Lowers <tt>for i in vectorize(width, lower, upper) { ... }</tt> in the front end rather than with Thorin's vectorizer.
+ * The kernel runs the body on simd vectors of @c width lanes - see @c LaneEmitter - as long as all of them are below @c upper;
+ * the remaining indices run once more with the lanes at or beyond @c upper masked off.
+ * TypeSema has ruled out dependencies between iterations.
+ */
+static void emit_vectorized(CodeGen& cg, const ForExpr* for_expr, const MapExpr* map_expr, Continuation* break_continuation) {
+    auto& w = cg.world();
+    auto location = for_expr->location();
+    auto fn_expr = for_expr->fn_expr();
+    auto width = map_expr->arg(0)->as<LiteralExpr>()->get_u64();
+    auto lower = cg.remit(map_expr->arg(1));
+    auto upper = cg.remit(map_expr->arg(2));
+    if (auto report = session_state().vectorize_report)
+        report->vectorized(location, "vectorized by the front end (vectorization width: " + std::to_string(width) + ")");
+
+    auto head = w.continuation(w.fn_type({w.mem_type(), w.type_qs32()}), {location, "vectorize_head"});
+    cg.cur_bb->jump(head, {cg.get_mem(), lower}, location);
+    cg.set_continuation(head);
+    auto index = head->param(1);
+    auto next = w.binop(ArithOp_add, index, w.literal_qs32(int32_t(width), location), location);
+
+    JumpTarget kernel_bb({location, "vectorize_kernel"});
+    JumpTarget tail_bb({location, "vectorize_tail"});
+    JumpTarget lanes_bb({location, "vectorize_mask"});
+    JumpTarget exit_bb({location, "vectorize_exit"});
+    cg.branch(w.binop(Cmp_le, next, upper, location), kernel_bb, tail_bb, location);
+    if (cg.enter(kernel_bb)) {
+        LaneEmitter(cg, fn_expr, width, index, nullptr, location).emit();
+        cg.cur_bb->jump(head, {cg.get_mem(), next}, location);
+    }
+
+    cg.enter(tail_bb);
+    cg.branch(w.binop(Cmp_lt, index, upper, location), lanes_bb, exit_bb, location);
+    if (cg.enter(lanes_bb))
+        LaneEmitter(cg, fn_expr, width, index, upper, location).emit();
+    cg.jump(exit_bb, location);
+    cg.enter(exit_bb);
+    cg.jump_to_continuation(break_continuation, location);
+}
+
+/// Emits a loop over [@p lower, @p upper) - of the type of @p lower - that threads an accumulator of @p type from @p init through @p step; yields the final one.
+template<class F>
+static const Def* emit_fold(CodeGen& cg, const Def* lower, const Def* upper, const Def* init, const thorin::Type* type, Location location, F step) {
+    auto& w = cg.world();
+    auto head = w.continuation(w.fn_type({w.mem_type(), lower->type(), type}), {location, "fold_head"});
+    cg.cur_bb->jump(head, {cg.get_mem(), lower, init}, location);
+    cg.set_continuation(head);
+    auto index = head->param(1);
+    auto acc = head->param(2);
+
+    JumpTarget body_bb({location, "fold_body"});
+    JumpTarget exit_bb({location, "fold_exit"});
+    cg.branch(w.binop(Cmp_lt, index, upper, location), body_bb, exit_bb, location);
+    if (cg.enter(body_bb)) {
+        auto next = step(index, acc);
+        cg.cur_bb->jump(head, {cg.get_mem(), w.binop(ArithOp_add, index, w.one(index->type(), location), location), next}, location);
+    }
+    cg.enter(exit_bb);
+    return acc;
+}
+
+/**
+ * Lowers <tt>for i, acc in parallel_reduce(num_threads, lower, upper, identity, combine) { ... }</tt>.
+ * A parallel loop runs over chunks of [lower, upper); each chunk folds its indices with the body into an accumulator of its own, starting at the identity.
+ * The accumulators lie in a stack slot, each padded to a cache line of its own by an <tt>align_type(64)</tt> field, so workers never write to the same line;
+ * after the loop they are combined from left to right.
+ * There is one chunk per thread. The slot is sized at compile time: for a literal @c num_threads it has that many entries, up to @c max_static_chunks;
+ * otherwise it has @c max_chunks, which is also the number of chunks the runtime balances if @c num_threads is 0. More threads than entries share them.
+ * The chunks are numbered in the @c i32 of the @c parallel runtime call; the indices of the range keep its own type.
+ */
+static void emit_parallel_reduce(CodeGen& cg, const ForExpr* for_expr, const MapExpr* map_expr, Continuation* break_continuation) {
+    auto& w = cg.world();
+    auto location = for_expr->location();
+    auto num_threads = cg.remit(map_expr->arg(0));
+    auto lower = cg.remit(map_expr->arg(1));
+    auto upper = cg.remit(map_expr->arg(2));
+    auto identity = cg.remit(map_expr->arg(3));
+    auto combine = cg.remit(map_expr->arg(4));
+    auto body = cg.remit(for_expr->fn_expr());
+    auto type = cg.convert(map_expr->arg(3)->type());
+    auto index_type = lower->type();
+
+    auto literal = [&] (int32_t i) { return w.literal_qs32(i, location); };
+    auto index = [&] (const Def* def) { return w.cast(index_type, def, location); };
+    auto op = [&] (int tag, const Def* a, const Def* b) { return w.binop(tag, a, b, location); };
+    auto min = [&] (const Def* a, const Def* b) { return w.select(op(Cmp_lt, a, b), a, b, location); };
+    auto max = [&] (const Def* a, const Def* b) { return w.select(op(Cmp_gt, a, b), a, b, location); };
+
+    const uint64_t max_chunks = 64, max_static_chunks = 1024;
+    auto threads_literal = map_expr->arg(0)->isa<LiteralExpr>();
+    uint64_t slot_size = threads_literal == nullptr || threads_literal->get_u64() == 0 ? max_chunks : std::min(threads_literal->get_u64(), max_static_chunks);
+    assert(slot_size >= 1 && slot_size <= max_static_chunks);
+    // more threads than entries share them; for a literal num_threads within max_static_chunks this folds to num_threads
+    auto num_chunks = w.select(op(Cmp_gt, num_threads, literal(0)), min(num_threads, literal(int32_t(slot_size))), literal(int32_t(slot_size)), location);
+    auto n = max(op(ArithOp_sub, upper, lower), w.zero(index_type, location));
+    auto chunk_size = op(ArithOp_div, op(ArithOp_add, n, op(ArithOp_sub, index(num_chunks), w.one(index_type, location))), index(num_chunks));
+    auto padded = w.struct_type("parallel_reduce_accumulator", 2);
+    padded->set(0, type);
+    padded->set(1, cg.align_type(64));
+    auto accumulators = w.slot(w.definite_array_type(padded, slot_size), cg.frame(), {location, "parallel_reduce_accumulators"});
+    auto accumulator = [&] (const Def* chunk) { return w.lea(w.lea(accumulators, chunk, location), literal(0), location); };
+
+    auto outer_bb = cg.cur_bb;
+    auto outer_mem = cg.get_mem();
+    auto chunk = w.continuation(w.fn_type({w.mem_type(), w.type_qs32(), w.fn_type({w.mem_type()})}), {location, "parallel_reduce_chunk"});
+    cg.set_continuation(chunk);
+    auto begin = op(ArithOp_add, lower, op(ArithOp_mul, index(chunk->param(1)), chunk_size));
+    auto end = min(op(ArithOp_add, begin, chunk_size), upper);
+    auto partial = emit_fold(cg, begin, end, identity, type, location, [&] (const Def* index, const Def* acc) {
+        auto next = cg.call(body, {cg.get_mem(), index, acc}, type, Debug(location, "parallel_reduce_body"));
+        cg.set_mem(cg.cur_bb->param(0));
+        return next;
+    });
+    cg.store(accumulator(chunk->param(1)), partial, location);
+    cg.cur_bb->jump(chunk->param(2), {cg.get_mem()}, location);
+    cg.cur_bb = outer_bb;
+    cg.set_mem(outer_mem);
+
+    auto parallel = w.continuation(w.fn_type({w.mem_type(), w.type_qs32(), w.type_qs32(), w.type_qs32(), chunk->type(), w.fn_type({w.mem_type()})}), {location, "parallel"});
+    parallel->set_intrinsic();
+    cg.call(parallel, {cg.get_mem(), num_threads, literal(0), num_chunks, chunk}, w.tuple_type({}), Debug(location, "parallel_reduce_join"));
+    cg.set_mem(cg.cur_bb->param(0));
+
+    auto result = emit_fold(cg, literal(1), num_chunks, cg.load(accumulator(literal(0)), location), type, location, [&] (const Def* index, const Def* acc) {
+        auto partial = cg.load(accumulator(index), location);
+        auto next = cg.call(combine, {cg.get_mem(), acc, partial}, type, Debug(location, "parallel_reduce_combine"));
+        cg.set_mem(cg.cur_bb->param(0));
+        return next;
+    });
+    cg.cur_bb->jump(break_continuation, {cg.get_mem(), result}, location);
+}
+
 const Def* ForExpr::remit(CodeGen& cg) const {
+    // 'with' shares ForExpr but is no loop; its break continuation is anonymous
+    auto report = session_state().vectorize_report;
+    if (report != nullptr && break_decl()->symbol() != "_")
+        report->loop(location(), "for", must_vectorize());
+
     std::vector<const Def*> defs;
     defs.push_back(nullptr); // reserve for mem but set later - some other args may update the monad
 
@@ -717,17 +987,27 @@ const Def* ForExpr::remit(CodeGen& cg) const {
         forexpr = prefix->rhs();
 
     // emit call
+    static const Intrinsic* vectorize = find_intrinsic("vectorize");
+    static const Intrinsic* parallel_reduce = find_intrinsic("parallel_reduce");
     auto map_expr = forexpr->as<MapExpr>();
-    for (const auto& arg : map_expr->args())
-        defs.push_back(cg.remit(arg.get()));
-    defs.push_back(cg.remit(fn_expr()));
-    defs.push_back(break_continuation);
-    auto fun = cg.remit(map_expr->lhs());
-    if (prefix && prefix->tag() == PrefixExpr::RUN) fun = cg.world().run(fun, break_continuation, location());
-    if (prefix && prefix->tag() == PrefixExpr::HLT) fun = cg.world().hlt(fun, break_continuation, location());
+    if (intrinsic() != nullptr && intrinsic() == vectorize && map_expr->num_args() == 3) {
+        emit_vectorized(cg, this, map_expr, break_continuation);
+    } else if (intrinsic() != nullptr && intrinsic() == parallel_reduce) {
+        emit_parallel_reduce(cg, this, map_expr, break_continuation);
+    } else {
+        for (const auto& arg : map_expr->args())
+            defs.push_back(cg.remit(arg.get()));
+        defs.push_back(cg.remit(fn_expr()));
+        defs.push_back(break_continuation);
+        auto fun = cg.remit(map_expr->lhs());
+        if (prefix && prefix->tag() == PrefixExpr::RUN && !specialize(prefix->location(), map_expr->lhs()))
+            prefix = nullptr;
+        if (prefix && prefix->tag() == PrefixExpr::RUN) fun = cg.world().run(fun, break_continuation, location());
+        if (prefix && prefix->tag() == PrefixExpr::HLT) fun = cg.world().hlt(fun, break_continuation, location());
 
-    defs.front() = cg.get_mem(); // now get the current memory monad
-    cg.call(fun, defs, nullptr, map_expr->location());
+        defs.front() = cg.get_mem(); // now get the current memory monad
+        cg.call(fun, defs, nullptr, map_expr->location());
+    }
 
     cg.set_continuation(break_continuation);
     if (break_continuation->num_params() == 2)
@@ -814,6 +1094,32 @@ void emit(World& world, const Module* mod) {
     clear_value_numbering_table(world);
 }
 
+static void collect_noalias_params(const Module* mod, std::map<std::string, std::vector<unsigned>>& result) {
+    for (const auto& item : mod->items()) {
+        if (auto module_decl = item->isa<ModuleDecl>()) {
+            if (module_decl->module() != nullptr)
+                collect_noalias_params(module_decl->module(), result);
+        } else if (auto fn_decl = item->isa<FnDecl>()) {
+            if (!fn_decl->is_extern() || fn_decl->abi() != "" || fn_decl->body() == nullptr)
+                continue;
+            std::vector<unsigned> params;
+            for (size_t i = 0, e = fn_decl->num_params(); i != e; ++i) {
+                auto ptr = fn_decl->param(i)->type()->isa<PtrType>();
+                if (ptr != nullptr && (ptr->is_mut() || ptr->isa<OwnedPtrType>()) && fn_decl->param(i)->is_exclusive())
+                    params.push_back(i);
+            }
+            if (!params.empty())
+                result[fn_decl->fn_symbol().remove_quotation()] = params;
+        }
+    }
+}
+
+std::map<std::string, std::vector<unsigned>> noalias_params(const Module* mod) {
+    std::map<std::string, std::vector<unsigned>> result;
+    collect_noalias_params(mod, result);
+    return result;
+}
+
 //------------------------------------------------------------------------------
 
 }
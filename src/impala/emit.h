@@ -0,0 +1,126 @@
+#ifndef IMPALA_EMIT_H
+#define IMPALA_EMIT_H
+
+#include <vector>
+
+#include "thorin/irbuilder.h"
+#include "thorin/continuation.h"
+#include "thorin/world.h"
+
+#include "impala/ast.h"
+
+namespace impala {
+
+class CodeGen : public thorin::IRBuilder {
+public:
+    CodeGen(thorin::World& world)
+        : thorin::IRBuilder(world)
+    {}
+
+    const thorin::Def* frame() const { assert(cur_fn); return cur_fn->frame(); }
+    /// Enter \p x and perform \p get_value to collect return value.
+    const thorin::Def* converge(const Expr* expr, thorin::JumpTarget& x) {
+        emit_jump(expr, x);
+        if (enter(x))
+            return cur_bb->get_value(1, convert(expr->type()));
+        return nullptr;
+    }
+
+    void emit_jump_boolean(bool val, thorin::JumpTarget& x, const thorin::Location& loc) {
+        if (is_reachable()) {
+            cur_bb->set_value(1, world().literal(val, loc));
+            jump(x, loc);
+        }
+    }
+
+    thorin::Continuation* create_continuation(const LocalDecl* decl) {
+        auto result = continuation(convert(decl->type())->as<thorin::FnType>(), decl->debug());
+        result->param(0)->debug().set("mem");
+        decl->value_ = thorin::Value::create_val(*this, result);
+        return result;
+    }
+
+    void set_continuation(thorin::Continuation* continuation) {
+        cur_bb = continuation;
+        set_mem(continuation->param(0));
+    }
+
+    void jump_to_continuation(thorin::Continuation* continuation, const thorin::Location& loc) {
+        if (is_reachable())
+            cur_bb->jump(continuation, {get_mem()}, loc);
+        set_continuation(continuation);
+    }
+
+    thorin::Value lemit(const Expr* expr) { return expr->lemit(*this); }
+    const thorin::Def* remit(const Expr* expr) { return expr->remit(*this); }
+    const thorin::Def* remit(const Expr* expr, MapExpr::State state, Location eval_loc) {
+        return expr->as<MapExpr>()->remit(*this, state, eval_loc);
+    }
+    void emit_jump(const Expr* expr, thorin::JumpTarget& x) { if (is_reachable()) expr->emit_jump(*this, x); }
+    void emit_branch(const Expr* expr, thorin::JumpTarget& t, thorin::JumpTarget& f) { expr->emit_branch(*this, t, f); }
+    void emit(const Stmt* stmt) { if (is_reachable()) stmt->emit(*this); }
+    void emit(const Item* item) {
+        assert(!item->done_);
+        item->emit(*this);
+#ifndef NDEBUG
+        item->done_ = true;
+#endif
+    }
+    void emit(const Ptrn* ptrn, const thorin::Def* def) { ptrn->emit(*this, def); }
+    thorin::Value emit(const Decl* decl) {
+        assert(decl->value_.tag() != thorin::Value::Empty);
+        return decl->value_;
+    }
+    thorin::Value emit(const Decl* decl, const thorin::Def* init) {
+        if (!decl->value_)
+            decl->value_ = decl->emit(*this, init);
+        return decl->value_;
+    }
+    const thorin::Type* convert(const Type* type) {
+        if (auto t = thorin_type(type))
+            return t;
+        auto t = convert_rec(type);
+        return thorin_type(type) = t;
+    }
+
+    void convert_ops(const Type*, std::vector<const thorin::Type*>& nops);
+    const thorin::Type* convert_rec(const Type*);
+
+    /// A field of no size that LLVM aligns to @p align: an empty array of a vector of that many bytes.
+    const thorin::Type* align_type(int align) {
+        return world().definite_array_type(world().type(thorin::PrimType_pu8, align), 0);
+    }
+
+    /**
+     * Tells LLVM what a pointer @p def of @p type promises if it is aligned beyond @p known:
+     * <tt>llvm.assume((ptr & (align - 1)) == 0)</tt>, from which LLVM infers the alignment of the accesses through it.
+     */
+    void assume_aligned(const Type* type, const thorin::Def* def, Location location, int known = 0) {
+        auto ptr_type = type->isa<PtrType>();
+        if (ptr_type == nullptr || ptr_type->align() <= known || !is_reachable())
+            return;
+
+        auto& w = world();
+        if (assume_ == nullptr) {
+            assume_ = w.continuation(w.fn_type({w.mem_type(), w.type_bool(), w.fn_type({w.mem_type()})}), {location, "llvm.assume"});
+            assume_->cc() = thorin::CC::Device;
+        }
+        auto addr = w.cast(w.type_pu64(), def, location);
+        auto mask = w.literal_pu64(ptr_type->align() - 1, location);
+        auto cond = w.binop(thorin::Cmp_eq, w.binop(thorin::ArithOp_and, addr, mask, location), w.zero(w.type_pu64(), location), location);
+        call(assume_, {get_mem(), cond}, w.tuple_type({}), thorin::Debug(location, "assume_aligned"));
+        set_mem(cur_bb->param(0));
+    }
+
+    const thorin::Type*& thorin_type(const Type* type) { return impala2thorin_[type]; }
+    const thorin::StructType*& thorin_struct_type(const StructType* type) { return struct_type_impala2thorin_[type]; }
+
+    const Fn* cur_fn = nullptr;
+    thorin::Continuation* assume_ = nullptr;
+    TypeMap<const thorin::Type*> impala2thorin_;
+    thorin::GIDMap<const StructType*, const thorin::StructType*> struct_type_impala2thorin_;
+};
+
+}
+
+#endif
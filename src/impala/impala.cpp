@@ -1,29 +1,76 @@
 #include "impala/impala.h"
 
+#include <mutex>
+
 #include "impala/ast.h"
+#include "impala/stats.h"
 #include "impala/symbol.h"
 #include "impala/token.h"
 
 namespace impala {
 
-bool fancy_output = false;
+static thread_local SessionState default_state;
+static thread_local SessionState* current_state = nullptr;
+
+SessionState& session_state() { return current_state != nullptr ? *current_state : default_state; }
+
+SessionScope::SessionScope(SessionState& state)
+    : prev_(current_state)
+{
+    current_state = &state;
+}
 
-bool& fancy() { return fancy_output; }
+SessionScope::~SessionScope() { current_state = prev_; }
+
+bool& fancy() { return session_state().fancy; }
+
+void init() {
+    static std::once_flag initialized;
+    std::call_once(initialized, [] {
+        PrecTable::init();
+        Token::init();
+    });
+}
 
-void init() { PrecTable::init(); Token::init(); }
 void destroy() { Symbol::destroy(); }
+
 void check(Init& init, const Module* mod, bool nossa) {
-    name_analysis(mod);
-    type_inference(init, mod);
-    type_analysis(mod, nossa);
-    //borrow_check(mod);
+    {
+        PhaseTimer timer("name_analysis");
+        name_analysis(mod);
+    }
+    {
+        PhaseTimer timer("type_inference");
+        type_inference(init, mod);
+    }
+    {
+        PhaseTimer timer("type_analysis");
+        type_analysis(mod, nossa);
+        count("types", init.typetable->types().size());
+    }
 }
 
-int global_num_warnings = 0;
-int global_num_errors = 0;
+int num_warnings() { return session_state().num_warnings; }
+int num_errors() { return session_state().num_errors; }
+
+std::ostream& report(Diagnostic::Kind kind, const thorin::Location& loc, std::string message) {
+    auto& state = session_state();
+    ++(kind == Diagnostic::Error ? state.num_errors : state.num_warnings);
+
+    if (state.diagnostics != nullptr) {
+        state.diagnostics->push_back({kind, loc, std::move(message)});
+        static thread_local std::ostream discard(nullptr);
+        return discard;
+    }
 
-int num_warnings() { return global_num_warnings; }
-int num_errors() { return global_num_errors; }
+    thorin::streamf(std::cerr, "{}: {}: ", loc, kind == Diagnostic::Error ? "error" : "warning");
+    return std::cerr << message << std::endl;
+}
+
+std::string basename(const std::string& filename) {
+    auto i = filename.find_last_of("\\/");
+    return i == std::string::npos ? filename : filename.substr(i + 1);
+}
 
 Prec PrecTable::infix[Token::Num];
 
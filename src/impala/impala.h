@@ -2,7 +2,9 @@
 #define IMPALA_IMPALA_H
 
 #include <iostream>
+#include <map>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -17,32 +19,48 @@ namespace impala {
 bool& fancy();
 
 class ASTNode;
+class CostReport;
 class Item;
 class Module;
+class PEBudget;
+class VectorizeReport;
+class Stats;
 typedef std::vector<std::unique_ptr<const Item>> Items;
 
 void init();
 void destroy();
 
 struct Init {
-    Init(std::string module_name)
+    /// A @p resident @c Init leaves the process-wide tables (symbols, tokens, precedences) alive for the next session.
+    Init(std::string module_name, bool resident = false)
         : world(std::move(module_name))
+        , resident_(resident)
     {
         init();
     }
-    ~Init() { destroy(); }
+    ~Init() {
+        if (!resident_)
+            destroy();
+    }
 
     thorin::World world;
     std::unique_ptr<TypeTable> typetable;
+
+private:
+    bool resident_;
 };
 
 void parse(Items&, std::istream&, const char*);
 void name_analysis(const Module*);
 void type_inference(Init&, const Module*);
 void type_analysis(const Module*, bool nossa);
-//void borrow_check(const ModContents*);
 void check(Init&, const Module*, bool nossa);
 void emit(thorin::World&, const Module*);
+/**
+ * The <tt>&mut</tt> and @c ~ parameters - by index - of the exported functions - by symbol - that type analysis proved exclusive: see @c Param::is_exclusive.
+ * Callers outside of Impala are held to the same rule as C's @c restrict.
+ */
+std::map<std::string, std::vector<unsigned>> noalias_params(const Module*);
 
 enum class Prec {
     Bottom,
@@ -66,24 +84,65 @@ private:
     friend void init();
 };
 
-extern int global_num_warnings;
-extern int global_num_errors;
+struct Diagnostic {
+    enum Kind { Warning, Error };
+
+    Kind kind;
+    thorin::Location location;
+    std::string message;
+};
+
+/**
+ * The mutable state of one compilation.
+ * Each thread has its own current @c SessionState; use @c SessionScope to install a different one.
+ */
+struct SessionState {
+    int num_warnings = 0;
+    int num_errors = 0;
+    bool fancy = false;
+    /// If set, diagnostics are collected here instead of being written to @c std::cerr.
+    std::vector<Diagnostic>* diagnostics = nullptr;
+    /// If set, phases and counters are recorded here; see @c StatsScope.
+    Stats* stats = nullptr;
+    /// If set, compile cost is attributed to functions here; see @c CostReportScope.
+    CostReport* cost_report = nullptr;
+    /// If set, @c @ annotations are only specialized within its budgets; see @c PEBudgetScope.
+    PEBudget* pe_budget = nullptr;
+    /// If set, emission registers loops and <tt>#[must_vectorize]</tt> here; see @c VectorizeReportScope.
+    VectorizeReport* vectorize_report = nullptr;
+};
+
+SessionState& session_state();
+
+class SessionScope {
+public:
+    SessionScope(SessionState&);
+    ~SessionScope();
+
+private:
+    SessionState* prev_;
+};
 
 int num_warnings();
 int num_errors();
 
+std::ostream& report(Diagnostic::Kind, const thorin::Location&, std::string message);
+
+/// @p filename without its directory; debug info and diagnostics may spell the same path differently.
+std::string basename(const std::string& filename);
+
 template<typename... Args>
 std::ostream& warning(const thorin::Location& loc, const char* fmt, Args... args) {
-    ++global_num_warnings;
-    thorin::streamf(std::cerr, "{}: warning: ", loc);
-    return thorin::streamf(std::cerr, fmt, args...) << std::endl;;
+    std::ostringstream os;
+    thorin::streamf(os, fmt, args...);
+    return report(Diagnostic::Warning, loc, os.str());
 }
 
 template<typename... Args>
 std::ostream& error(const thorin::Location& loc, const char* fmt, Args... args) {
-    ++global_num_errors;
-    thorin::streamf(std::cerr, "{}: error: ", loc);
-    return thorin::streamf(std::cerr, fmt, args...) << std::endl;;
+    std::ostringstream os;
+    thorin::streamf(os, fmt, args...);
+    return report(Diagnostic::Error, loc, os.str());
 }
 
 }
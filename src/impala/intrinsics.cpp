@@ -0,0 +1,675 @@
+#include "impala/intrinsics.h"
+
+#include "thorin/continuation.h"
+#include "thorin/primop.h"
+#include "thorin/type.h"
+#include "thorin/world.h"
+
+#include "impala/ast.h"
+#include "impala/impala.h"
+#include "impala/sema/typetable.h"
+
+namespace impala {
+
+/*
+ * infer
+ */
+
+/// The simd vector type of @p expr if already known.
+static const SimdType* simd_type(const Expr* expr) { return expr->type() != nullptr ? expr->type()->isa<SimdType>() : nullptr; }
+
+static const Type* infer_shuffle(TypeTable& table, const MapExpr* call) {
+    auto type = simd_type(call->arg(0)), mask = simd_type(call->arg(2));
+    return type != nullptr && mask != nullptr ? table.simd_type(type->elem_type(), mask->dim()) : nullptr;
+}
+
+static const Type* infer_reduce(TypeTable&, const MapExpr* call) {
+    auto type = simd_type(call->arg(0));
+    return type != nullptr ? type->elem_type() : nullptr;
+}
+
+/// The element type of the array that @p expr points to if already known.
+static const Type* pointee_elem_type(const Expr* expr) {
+    if (auto ptr_type = expr->type() != nullptr ? expr->type()->isa<PtrType>() : nullptr) {
+        if (auto array_type = ptr_type->pointee()->isa<ArrayType>())
+            return array_type->elem_type();
+    }
+    return nullptr;
+}
+
+static const Type* infer_gather(TypeTable& table, const MapExpr* call) {
+    auto elem_type = pointee_elem_type(call->arg(0));
+    auto index = simd_type(call->arg(1));
+    return elem_type != nullptr && index != nullptr ? table.simd_type(elem_type, index->dim()) : nullptr;
+}
+
+/*
+ * check
+ */
+
+int num_bits(const Type* type) {
+    if (auto prim_type = type->isa<PrimType>()) {
+        switch (prim_type->primtype_tag()) {
+            case PrimType_bool:                   return 1;
+            case PrimType_i8:  case PrimType_u8:  return 8;
+            case PrimType_i16: case PrimType_u16:
+            case PrimType_f16:                    return 16;
+            case PrimType_i32: case PrimType_u32:
+            case PrimType_f32:                    return 32;
+            case PrimType_i64: case PrimType_u64:
+            case PrimType_f64:                    return 64;
+        }
+    }
+    return 0;
+}
+
+static bool is_aggregate(const Type* type) {
+    return type->isa<TupleType>() || type->isa<StructType>() || type->isa<DefiniteArrayType>()
+        || type->isa<IndefiniteArrayType>() || type->isa<FnType>();
+}
+
+static void check_bitcast(const MapExpr* call) {
+    auto dst = call->type(), src = call->arg(0)->type();
+    if (!dst->is_known() || !src->is_known())
+        return;
+    if (is_aggregate(dst) || is_aggregate(src))
+        error(call, "cannot bitcast '{}' to '{}': only primitive, pointer and simd types can be reinterpreted", src, dst);
+    else if (num_bits(dst) != 0 && num_bits(src) != 0 && num_bits(dst) != num_bits(src))
+        error(call, "cannot bitcast '{}' to '{}': the types differ in size", src, dst);
+}
+
+static void check_select(const MapExpr* call) {
+    auto cond = call->arg(0)->type(), type = call->arg(1)->type();
+    auto simd_cond = cond->isa<SimdType>();
+    auto simd_type = type->isa<SimdType>();
+    if (!cond->is_known() || !type->is_known())
+        return;
+    if (!is_bool(simd_cond ? simd_cond->elem_type() : cond))
+        error(call->arg(0), "select needs a condition of type 'bool' or a simd vector of 'bool', not '{}'", cond);
+    else if (simd_cond != nullptr && (simd_type == nullptr || simd_type->dim() != simd_cond->dim()))
+        error(call, "select with a condition of type '{}' needs operands of the same vector length, not '{}'", cond, type);
+}
+
+/// Memory orderings, numbered as by LLVM's @c AtomicOrdering; calls that leave them out are @c Order_SeqCst.
+enum { Order_Relaxed = 2, Order_Acquire = 4, Order_Release = 5, Order_AcqRel = 6, Order_SeqCst = 7 };
+
+static const char* order_name(uint64_t order) {
+    switch (order) {
+        case Order_Relaxed: return "relaxed";
+        case Order_Acquire: return "acquire";
+        case Order_Release: return "release";
+        case Order_AcqRel:  return "acq_rel";
+        case Order_SeqCst:  return "seq_cst";
+        default:            return nullptr;
+    }
+}
+
+/// What is not allowed for an access that only reads or only writes memory or that orders no access at all.
+static const unsigned Order_NotForLoad  = (1u << Order_Release) | (1u << Order_AcqRel);
+static const unsigned Order_NotForStore = (1u << Order_Acquire) | (1u << Order_AcqRel);
+static const unsigned Order_NotForFence = 1u << Order_Relaxed;
+
+/**
+ * The ordering that argument @p i of @p call gives - @c Order_SeqCst if left out - or 0 if not a literal.
+ * Reports an ordering that is unknown or among @p forbidden for @p what and yields 0 then, too.
+ */
+static uint64_t check_order(const MapExpr* call, size_t i, unsigned forbidden, const char* what) {
+    if (i >= call->num_args())
+        return Order_SeqCst;
+    auto literal = call->arg(i)->isa<LiteralExpr>();
+    if (literal == nullptr)
+        return 0;
+
+    auto order = literal->get_u64();
+    if (order_name(order) == nullptr) {
+        error(call->arg(i), "unknown memory ordering {}", order);
+        return 0;
+    }
+    if (forbidden & (1u << order)) {
+        error(call->arg(i), "memory ordering '{}' is not allowed for {}", order_name(order), what);
+        return 0;
+    }
+    return order;
+}
+
+/// How much an ordering constrains the loads that follow it: relaxed and release not at all, seq_cst most.
+static int acquire_strength(uint64_t order) {
+    return order == Order_SeqCst ? 2 : order == Order_Acquire || order == Order_AcqRel ? 1 : 0;
+}
+
+/// The binary operations of @c atomic, numbered as by LLVM's @c atomicrmw.
+enum { Atomic_Xchg = 0, Atomic_UMin = 10, Atomic_FAdd = 11, Atomic_FSub = 12 };
+
+static void check_atomic(const MapExpr* call) {
+    check_order(call, 3, 0, "atomic");
+    auto type = call->arg(2)->type();
+    auto op = call->arg(0)->isa<LiteralExpr>();
+    if (op == nullptr || !type->is_known())
+        return;
+
+    auto binop = op->get_u64();
+    if (binop > Atomic_FSub)
+        error(call->arg(0), "unknown atomic operation {}", binop);
+    else if (binop != Atomic_Xchg && binop <= Atomic_UMin && !is_int(type))
+        error(call, "atomic operation {} needs an integer type, not '{}'", binop, type);
+    else if (binop >= Atomic_FAdd && !is_float(type))
+        error(call, "atomic operation {} needs a floating-point type, not '{}'", binop, type);
+}
+
+/// Atomic loads and stores take what a single instruction can move: integers, floating-point numbers and pointers.
+static void check_atomic_access(const MapExpr* call, const Type* type, unsigned forbidden, const char* what) {
+    check_order(call, call->num_args() - 1, forbidden, what);
+    if (type->is_known() && !is_int(type) && !is_float(type) && !type->isa<PtrType>())
+        error(call, "{} needs an integer, floating-point or pointer type, not '{}'", what, type);
+}
+
+static void check_atomic_load(const MapExpr* call) {
+    if (auto ptr_type = call->arg(0)->type()->isa<PtrType>())
+        check_atomic_access(call, ptr_type->pointee(), Order_NotForLoad, "an atomic load");
+}
+
+static void check_atomic_store(const MapExpr* call) { check_atomic_access(call, call->arg(1)->type(), Order_NotForStore, "an atomic store"); }
+
+static void check_cmpxchg(const MapExpr* call) {
+    auto success = check_order(call, 3, 0, "cmpxchg");
+    auto failure = check_order(call, 4, Order_NotForLoad, "a failed cmpxchg");
+    if (success != 0 && failure != 0 && acquire_strength(failure) > acquire_strength(success))
+        error(call->arg(4), "memory ordering '{}' on failure of cmpxchg is stronger than '{}' on success", order_name(failure), order_name(success));
+
+    auto type = call->arg(1)->type();
+    if (type->is_known() && !is_int(type) && !type->isa<PtrType>())
+        error(call, "cmpxchg needs an integer or pointer type, not '{}'", type);
+}
+
+static void check_fence(const MapExpr* call) { check_order(call, 0, Order_NotForFence, "a fence"); }
+
+static void check_shuffle(const MapExpr* call) {
+    auto type = simd_type(call->arg(0));
+    if (type == nullptr) {
+        error(call->arg(0), "shuffle needs simd vector operands, not '{}'", call->arg(0)->type());
+        return;
+    }
+
+    auto mask = call->arg(2)->isa<SimdExpr>();
+    if (mask == nullptr) {
+        error(call->arg(2), "lanes of shuffle must be given as a simd expression of integer literals");
+        return;
+    }
+    for (const auto& lane : mask->args()) {
+        auto literal = lane->isa<LiteralExpr>();
+        if (literal == nullptr || !is_int(literal->type()))
+            error(lane.get(), "lanes of shuffle must be given as a simd expression of integer literals");
+        else if (literal->get_u64() >= 2 * type->dim())
+            error(lane.get(), "lane {} is out of range for shuffling two vectors of type '{}'", literal->get_u64(), type);
+    }
+}
+
+static void check_reduce(const MapExpr* call, bool bitwise) {
+    auto type = simd_type(call->arg(0));
+    if (type == nullptr)
+        error(call->arg(0), "reduction needs a simd vector, not '{}'", call->arg(0)->type());
+    else if (bitwise && !is_int(type->elem_type()) && !is_bool(type->elem_type()))
+        error(call->arg(0), "bitwise reduction needs a simd vector of integers or booleans, not '{}'", type);
+    else if (!bitwise && !is_int(type->elem_type()) && !is_float(type->elem_type()))
+        error(call->arg(0), "arithmetic reduction needs a simd vector of numbers, not '{}'", type);
+}
+
+static void check_reduce_arith  (const MapExpr* call) { check_reduce(call, false); }
+static void check_reduce_bitwise(const MapExpr* call) { check_reduce(call, true);  }
+
+/// Checks the pointer and the indices of @c gather and @c scatter; returns the number of lanes or 0.
+static uint64_t check_indices(const MapExpr* call) {
+    auto index = simd_type(call->arg(1));
+    if (pointee_elem_type(call->arg(0)) == nullptr) {
+        error(call->arg(0), "{} needs a pointer to an array, not '{}'", call->intrinsic()->name, call->arg(0)->type());
+        return 0;
+    }
+    if (index == nullptr || !is_int(index->elem_type())) {
+        error(call->arg(1), "indices must be a simd vector of integers, not '{}'", call->arg(1)->type());
+        return 0;
+    }
+    return index->dim();
+}
+
+static void check_gather(const MapExpr* call) { check_indices(call); }
+
+static void check_scatter(const MapExpr* call) {
+    auto dim = check_indices(call);
+    auto type = simd_type(call->arg(2));
+    if (dim == 0)
+        return;
+    if (type == nullptr || type->dim() != dim || type->elem_type() != pointee_elem_type(call->arg(0)))
+        error(call->arg(2), "scatter needs a simd vector of {} elements of type '{}', not '{}'", dim, pointee_elem_type(call->arg(0)), call->arg(2)->type());
+}
+
+static void check_vectorize(const MapExpr* call) {
+    auto width = call->num_args() != 0 ? call->arg(0)->isa<LiteralExpr>() : nullptr;
+    if (width == nullptr || width->get_u64() == 0)
+        error(call->num_args() != 0 ? call->arg(0)->location() : call->location(), "vectorize needs a positive integer literal as vector width");
+}
+
+static void check_parallel_reduce(const MapExpr* call) {
+    error(call, "parallel_reduce can only be iterated over by a 'for' loop");
+}
+
+/*
+ * emit
+ */
+
+static const thorin::Def* emit_bitcast(IntrinsicCall& call) {
+    return call.world.bitcast(call.type, call.args[0], call.location);
+}
+
+static const thorin::Def* emit_select(IntrinsicCall& call) {
+    return call.world.select(call.args[0], call.args[1], call.args[2], call.location);
+}
+
+static const thorin::Def* emit_sizeof(IntrinsicCall& call) {
+    return call.world.size_of(call.type_args[0], call.location);
+}
+
+/// The offset of a @c T that follows a byte: the padding LLVM inserts is what the target aligns @c T to.
+static const thorin::Def* emit_alignof(IntrinsicCall& call) {
+    auto& w = call.world;
+    auto type = call.type_args[0];
+    auto padded = w.size_of(w.tuple_type({ w.type_pu8(), type }), call.location);
+    return w.arithop(thorin::ArithOp_sub, padded, w.size_of(type, call.location), call.location);
+}
+
+/// Lane @p i of the vector @p def.
+static const thorin::Def* lane(IntrinsicCall& call, const thorin::Def* def, uint64_t i) {
+    return call.world.extract(def, call.world.literal_qu32(i, call.location), call.location);
+}
+
+/// Lanes [@p begin, @p end) of the vector @p def as a vector - or as a scalar if it is just one.
+static const thorin::Def* lanes(IntrinsicCall& call, const thorin::Def* def, uint64_t begin, uint64_t end) {
+    if (end - begin == 1)
+        return lane(call, def, begin);
+    std::vector<const thorin::Def*> ops;
+    for (auto i = begin; i != end; ++i)
+        ops.push_back(lane(call, def, i));
+    return call.world.vector(ops, call.location);
+}
+
+// LLVM combines the extracts and inserts into shufflevector instructions
+static const thorin::Def* emit_shuffle(IntrinsicCall& call) {
+    auto dim = call.arg_types[0]->as<thorin::VectorType>()->length();
+    std::vector<const thorin::Def*> ops;
+    for (const auto& mask : call.expr->arg(2)->as<SimdExpr>()->args()) {
+        auto i = mask->as<LiteralExpr>()->get_u64();
+        ops.push_back(lane(call, i < dim ? call.args[0] : call.args[1], i % dim));
+    }
+    return call.world.vector(ops, call.location);
+}
+
+/// Combines the upper half of the lanes with the lower half in one vector operation until one lane is left; odd lanes are combined last.
+static const thorin::Def* reduce(IntrinsicCall& call, const thorin::Def* (*combine)(IntrinsicCall&, const thorin::Def*, const thorin::Def*)) {
+    auto def = call.args[0];
+    auto dim = call.arg_types[0]->as<thorin::VectorType>()->length();
+    if (dim == 1)
+        return lane(call, def, 0);
+
+    std::vector<const thorin::Def*> odd;
+    while (dim > 1) {
+        auto half = dim / 2;
+        if (dim % 2 != 0)
+            odd.push_back(lane(call, def, dim - 1));
+        def = combine(call, lanes(call, def, 0, half), lanes(call, def, half, 2 * half));
+        dim = half;
+    }
+    for (auto odd_lane : odd)
+        def = combine(call, def, odd_lane);
+    return def;
+}
+
+static const thorin::Def* add(IntrinsicCall& call, const thorin::Def* a, const thorin::Def* b) { return call.world.binop(thorin::ArithOp_add, a, b, call.location); }
+static const thorin::Def* mul(IntrinsicCall& call, const thorin::Def* a, const thorin::Def* b) { return call.world.binop(thorin::ArithOp_mul, a, b, call.location); }
+
+std::string llvm_suffix(const Type* type) {
+    if (auto simd = type->isa<SimdType>())
+        return "v" + std::to_string(simd->dim()) + llvm_suffix(simd->elem_type());
+    return (is_float(type) ? "f" : "i") + std::to_string(num_bits(type));
+}
+
+thorin::Continuation* llvm_intrinsic(thorin::World& world, const thorin::Location& location, const std::string& name, const thorin::FnType* fn_type) {
+    auto continuation = world.continuation(fn_type, {location, name});
+    continuation->cc() = thorin::CC::Device;
+    return continuation;
+}
+
+static const thorin::Def* llvm_intrinsic(IntrinsicCall& call, const std::string& name, const thorin::FnType* fn_type) {
+    return llvm_intrinsic(call.world, call.location, name, fn_type);
+}
+
+/// A function that takes the arguments of @p call and returns @p ret_types; the caller fills in its body.
+static thorin::Continuation* wrapper(IntrinsicCall& call, std::vector<const thorin::Type*> ret_types) {
+    auto& w = call.world;
+    std::vector<const thorin::Type*> param_types = { w.mem_type() };
+    param_types.insert(param_types.end(), call.arg_types.begin(), call.arg_types.end());
+    ret_types.insert(ret_types.begin(), w.mem_type());
+    param_types.push_back(w.fn_type(ret_types));
+    return w.continuation(w.fn_type(param_types), {call.location, call.expr->intrinsic()->name});
+}
+
+/// Calls <tt>llvm.vector.reduce.</tt>@p op on the vector.
+static const thorin::Def* reduce_call(IntrinsicCall& call, const char* op) {
+    auto& w = call.world;
+    return llvm_intrinsic(call, std::string("llvm.vector.reduce.") + op + "." + llvm_suffix(call.expr->arg(0)->type()),
+        w.fn_type({ w.mem_type(), call.arg_types[0], w.fn_type({ w.mem_type(), call.type }) }));
+}
+
+/**
+ * Floating-point sums and products stay a tree of vector operations:
+ * LLVM's reductions of them are sequential unless the call may reassociate, which Thorin cannot express.
+ */
+static const thorin::Def* reduce_tree(IntrinsicCall& call, const thorin::Def* (*combine)(IntrinsicCall&, const thorin::Def*, const thorin::Def*)) {
+    auto fn = wrapper(call, { call.type });
+    call.args = { fn->param(1) };
+    fn->jump(fn->param(2), { fn->param(0), reduce(call, combine) }, call.location);
+    return fn;
+}
+
+static const Type* reduced_type(IntrinsicCall& call) { return call.expr->arg(0)->type()->as<SimdType>()->elem_type(); }
+static bool is_signed(const Type* type) { return is_i8(type) || is_i16(type) || is_i32(type) || is_i64(type); }
+
+static const thorin::Def* emit_reduce_add(IntrinsicCall& call) { return is_float(reduced_type(call)) ? reduce_tree(call, add) : reduce_call(call, "add"); }
+static const thorin::Def* emit_reduce_mul(IntrinsicCall& call) { return is_float(reduced_type(call)) ? reduce_tree(call, mul) : reduce_call(call, "mul"); }
+static const thorin::Def* emit_reduce_and(IntrinsicCall& call) { return reduce_call(call, "and"); }
+static const thorin::Def* emit_reduce_or (IntrinsicCall& call) { return reduce_call(call, "or");  }
+static const thorin::Def* emit_reduce_xor(IntrinsicCall& call) { return reduce_call(call, "xor"); }
+
+static const thorin::Def* emit_reduce_min(IntrinsicCall& call) {
+    auto type = reduced_type(call);
+    return reduce_call(call, is_float(type) ? "fmin" : is_signed(type) ? "smin" : "umin");
+}
+
+static const thorin::Def* emit_reduce_max(IntrinsicCall& call) {
+    auto type = reduced_type(call);
+    return reduce_call(call, is_float(type) ? "fmax" : is_signed(type) ? "smax" : "umax");
+}
+
+/**
+ * The arguments of <tt>llvm.masked.gather</tt> and <tt>llvm.masked.scatter</tt> that address the elements of the array @p base at @p indices:
+ * a vector of pointers, their alignment and a mask of all lanes.
+ * Also yields the name of the pointer vector in the intrinsic's name, as LLVM spells pointers to typed elements, e.g. @c v4p0f32.
+ */
+static std::vector<const thorin::Def*> addresses(IntrinsicCall& call, const thorin::Def* base, const thorin::Def* indices, std::string& suffix) {
+    auto& w = call.world;
+    auto ptr_type = call.arg_types[0]->as<thorin::PtrType>();
+    auto elem_type = ptr_type->pointee()->as<thorin::ArrayType>()->elem_type();
+    auto dim = call.arg_types[1]->as<thorin::VectorType>()->length();
+    auto splat = [&] (const thorin::Def* def) { return w.vector(std::vector<const thorin::Def*>(dim, def), call.location); };
+
+    auto offsets = w.arithop(thorin::ArithOp_mul, w.cast(w.type(thorin::PrimType_qs64, dim), indices, call.location),
+                             splat(w.cast(w.type_qs64(), w.size_of(elem_type, call.location), call.location)), call.location);
+    auto ptrs = w.arithop(thorin::ArithOp_add, splat(w.cast(w.type_qs64(), base, call.location)), offsets, call.location);
+    auto impala_elem_type = pointee_elem_type(call.expr->arg(0));
+    suffix = "v" + std::to_string(dim) + "p" + std::to_string(int(ptr_type->addr_space())) + llvm_suffix(impala_elem_type);
+    return {
+        w.cast(w.ptr_type(elem_type, dim, -1, ptr_type->addr_space()), ptrs, call.location),
+        w.literal_qs32(std::max(1, num_bits(impala_elem_type) / 8), call.location),
+        splat(w.literal(true, call.location))
+    };
+}
+
+static const thorin::Def* emit_gather(IntrinsicCall& call) {
+    auto& w = call.world;
+    auto fn = wrapper(call, { call.type });
+    std::string suffix;
+    auto args = addresses(call, fn->param(1), fn->param(2), suffix);
+    std::vector<const thorin::Type*> param_types = { w.mem_type() };
+    for (auto arg : args)
+        param_types.push_back(arg->type());
+    param_types.push_back(call.type);
+    param_types.push_back(w.fn_type({ w.mem_type(), call.type }));
+    auto gather = llvm_intrinsic(call, "llvm.masked.gather." + llvm_suffix(call.expr->type()) + "." + suffix, w.fn_type(param_types));
+
+    args.insert(args.begin(), fn->param(0));
+    args.push_back(w.bottom(call.type, call.location)); // masked-off lanes; there are none
+    args.push_back(fn->param(3));
+    fn->jump(gather, args, call.location);
+    return fn;
+}
+
+static const thorin::Def* emit_scatter(IntrinsicCall& call) {
+    auto& w = call.world;
+    auto fn = wrapper(call, {});
+    std::string suffix;
+    auto args = addresses(call, fn->param(1), fn->param(2), suffix);
+    args.insert(args.begin(), fn->param(3));
+    std::vector<const thorin::Type*> param_types = { w.mem_type() };
+    for (auto arg : args)
+        param_types.push_back(arg->type());
+    param_types.push_back(w.fn_type({ w.mem_type() }));
+    auto scatter = llvm_intrinsic(call, "llvm.masked.scatter." + llvm_suffix(call.expr->arg(2)->type()) + "." + suffix, w.fn_type(param_types));
+
+    args.insert(args.begin(), fn->param(0));
+    args.push_back(fn->param(4));
+    fn->jump(scatter, args, call.location);
+    return fn;
+}
+
+static const thorin::Def* continuation(IntrinsicCall& call, const char* name, const thorin::FnType* fn_type) {
+    auto continuation = call.world.continuation(fn_type, {call.location, name});
+    continuation->set_intrinsic();
+    return continuation;
+}
+
+static const thorin::Def* emit_reserve_shared(IntrinsicCall& call) {
+    auto& w = call.world;
+    return continuation(call, "reserve_shared", w.fn_type({ w.mem_type(), w.type_qs32(), w.fn_type({ w.mem_type(), call.type }) }));
+}
+
+/*
+ * Thorin's atomic and cmpxchg are sequentially consistent, and it has no other atomic access.
+ * Whatever they cannot do calls the runtime's helpers impala_atomic_*, impala_cmpxchg* and impala_fence - see test/infrastructure/lib.c.
+ * These take the memory orderings as they are numbered here and the accessed values as unsigned integers of the same size;
+ * linked in with -link-bitcode, they are inlined and become single instructions again.
+ */
+
+/// Whether argument @p i of @p call is left out or the literal @c Order_SeqCst.
+static bool is_seq_cst(IntrinsicCall& call, size_t i) {
+    if (i >= call.expr->num_args())
+        return true;
+    auto literal = call.expr->arg(i)->isa<LiteralExpr>();
+    return literal != nullptr && literal->get_u64() == Order_SeqCst;
+}
+
+/// The size in bits with which the runtime's helpers access @p type, or 0 if they cannot; pointers are 64 bits wide.
+static int atomic_bits(const Type* type) {
+    if (type->isa<PtrType>())
+        return 64;
+    return is_bool(type) ? 0 : num_bits(type);
+}
+
+static const thorin::Type* bits_type(thorin::World& w, int bits) {
+    return w.type(bits == 8 ? thorin::PrimType_pu8 : bits == 16 ? thorin::PrimType_pu16 : bits == 32 ? thorin::PrimType_pu32 : thorin::PrimType_pu64);
+}
+
+/// Reinterprets @p def as @p type; pointers are converted to and from integers.
+static const thorin::Def* reinterpret(IntrinsicCall& call, const thorin::Type* type, const thorin::Def* def) {
+    if (def->type() == type)
+        return def;
+    if (type->isa<thorin::PtrType>() != def->type()->isa<thorin::PtrType>())
+        return call.world.cast(type, def, call.location);
+    return call.world.bitcast(type, def, call.location);
+}
+
+/// The runtime's helper @p name that accesses @p bits wide values; its parameters, after the memory, are @p param_types.
+static const thorin::Def* helper(IntrinsicCall& call, const char* name, int bits, std::vector<const thorin::Type*> param_types) {
+    auto& w = call.world;
+    param_types.insert(param_types.begin(), w.mem_type());
+    auto continuation = w.continuation(w.fn_type(param_types), {call.location, name + std::to_string(bits)});
+    continuation->cc() = thorin::CC::C;
+    return continuation;
+}
+
+/// Argument @p i of the function @p fn built around @p call if it is an ordering that was passed, or else the literal @c Order_SeqCst.
+static const thorin::Def* order(IntrinsicCall& call, thorin::Continuation* fn, size_t i) {
+    if (i < call.expr->num_args())
+        return fn->param(i + 1);
+    return call.world.literal_pu32(Order_SeqCst, call.location);
+}
+
+/// Returns a helper's result from @p fn - the memory and then @p bits, which are reinterpreted as @p type.
+static thorin::Continuation* result(IntrinsicCall& call, thorin::Continuation* fn, const thorin::Type* bits, const thorin::Type* type) {
+    auto& w = call.world;
+    auto ret = w.continuation(w.fn_type({ w.mem_type(), bits }), {call.location, "atomic_result"});
+    ret->jump(fn->param(fn->num_params() - 1), { ret->param(0), reinterpret(call, type, ret->param(1)) }, call.location);
+    return ret;
+}
+
+/// Calls Thorin's intrinsic @p name with the first @p num_args arguments of @p call - without the orderings, which it does not take.
+static const thorin::Def* seq_cst(IntrinsicCall& call, const char* name, size_t num_args, std::vector<const thorin::Type*> ret_types) {
+    auto& w = call.world;
+    std::vector<const thorin::Type*> param_types = { w.mem_type() };
+    param_types.insert(param_types.end(), call.arg_types.begin(), call.arg_types.begin() + num_args);
+    ret_types.insert(ret_types.begin(), w.mem_type());
+    param_types.push_back(w.fn_type(ret_types));
+    auto intrinsic = continuation(call, name, w.fn_type(param_types));
+    if (call.arg_types.size() == num_args)
+        return intrinsic;
+
+    auto fn = wrapper(call, std::vector<const thorin::Type*>(ret_types.begin() + 1, ret_types.end()));
+    std::vector<const thorin::Def*> args(fn->params().begin(), fn->params().begin() + num_args + 1);
+    args.push_back(fn->param(fn->num_params() - 1));
+    fn->jump(intrinsic, args, call.location);
+    return fn;
+}
+
+static const thorin::Def* emit_atomic(IntrinsicCall& call) {
+    auto& w = call.world;
+    auto bits = atomic_bits(call.expr->arg(2)->type());
+    auto op = call.expr->arg(0)->isa<LiteralExpr>();
+    // the helpers have no floating-point arithmetic: fadd and fsub stay seq_cst
+    if (is_seq_cst(call, 3) || bits == 0 || op == nullptr || op->get_u64() >= Atomic_FAdd)
+        return seq_cst(call, "atomic", 3, { call.type });
+
+    auto fn = wrapper(call, { call.type });
+    auto type = bits_type(w, bits);
+    auto rmw = helper(call, "impala_atomic_rmw_", bits, { w.type_pu32(), w.ptr_type(type), type, w.type_pu32(), w.fn_type({ w.mem_type(), type }) });
+    fn->jump(rmw, { fn->param(0), fn->param(1), w.bitcast(w.ptr_type(type), fn->param(2), call.location), reinterpret(call, type, fn->param(3)),
+                    order(call, fn, 3), result(call, fn, type, call.type) }, call.location);
+    return fn;
+}
+
+static const thorin::Def* emit_atomic_load(IntrinsicCall& call) {
+    auto& w = call.world;
+    auto fn = wrapper(call, { call.type });
+    auto bits = atomic_bits(call.expr->type());
+    auto type = bits_type(w, bits);
+    auto load = helper(call, "impala_atomic_load_", bits, { w.ptr_type(type), w.type_pu32(), w.fn_type({ w.mem_type(), type }) });
+    fn->jump(load, { fn->param(0), w.bitcast(w.ptr_type(type), fn->param(1), call.location), order(call, fn, 1), result(call, fn, type, call.type) }, call.location);
+    return fn;
+}
+
+static const thorin::Def* emit_atomic_store(IntrinsicCall& call) {
+    auto& w = call.world;
+    auto fn = wrapper(call, {});
+    auto bits = atomic_bits(call.expr->arg(1)->type());
+    auto type = bits_type(w, bits);
+    auto store = helper(call, "impala_atomic_store_", bits, { w.ptr_type(type), type, w.type_pu32(), w.fn_type({ w.mem_type() }) });
+    fn->jump(store, { fn->param(0), w.bitcast(w.ptr_type(type), fn->param(1), call.location), reinterpret(call, type, fn->param(2)),
+                      order(call, fn, 2), fn->param(fn->num_params() - 1) }, call.location);
+    return fn;
+}
+
+/**
+ * A helper compares and exchanges through a pointer to the expected value, which holds what it found afterwards, and returns whether it succeeded.
+ * The function built around it keeps the expected value in a slot of its own frame.
+ */
+static const thorin::Def* emit_cmpxchg(IntrinsicCall& call, bool weak) {
+    auto& w = call.world;
+    auto value_type = call.arg_types[0]->as<thorin::PtrType>()->pointee();
+    if (!weak && is_seq_cst(call, 3) && is_seq_cst(call, 4))
+        return seq_cst(call, "cmpxchg", 3, { value_type, w.type_bool() });
+
+    auto fn = wrapper(call, { value_type, w.type_bool() });
+    auto bits = atomic_bits(call.expr->arg(1)->type());
+    auto type = bits_type(w, bits);
+    auto enter = w.enter(fn->param(0), call.location);
+    auto frame = w.extract(enter, w.literal_qu32(1, call.location), call.location);
+    auto slot = w.slot(type, frame, {call.location, "cmpxchg_expected"});
+    auto mem = w.store(w.extract(enter, w.literal_qu32(0, call.location), call.location), slot, reinterpret(call, type, fn->param(2)), call.location);
+
+    auto ret = w.continuation(w.fn_type({ w.mem_type(), w.type_bool() }), {call.location, "cmpxchg_result"});
+    auto load = w.load(ret->param(0), slot, call.location);
+    auto found = w.extract(load, w.literal_qu32(1, call.location), call.location);
+    ret->jump(fn->param(fn->num_params() - 1),
+              { w.extract(load, w.literal_qu32(0, call.location), call.location), reinterpret(call, value_type, found), ret->param(1) }, call.location);
+
+    auto cmpxchg = helper(call, weak ? "impala_cmpxchg_weak_" : "impala_cmpxchg_", bits,
+        { w.ptr_type(type), w.ptr_type(type), type, w.type_pu32(), w.type_pu32(), ret->type() });
+    fn->jump(cmpxchg, { mem, w.bitcast(w.ptr_type(type), fn->param(1), call.location), slot, reinterpret(call, type, fn->param(3)),
+                        order(call, fn, 3), order(call, fn, 4), ret }, call.location);
+    return fn;
+}
+
+static const thorin::Def* emit_cmpxchg(IntrinsicCall& call) { return emit_cmpxchg(call, false); }
+static const thorin::Def* emit_cmpxchg_weak(IntrinsicCall& call) { return emit_cmpxchg(call, true); }
+
+static const thorin::Def* emit_fence(IntrinsicCall& call) {
+    auto& w = call.world;
+    auto fence = w.continuation(w.fn_type({ w.mem_type(), w.type_pu32(), w.fn_type({ w.mem_type() }) }), {call.location, "impala_fence"});
+    fence->cc() = thorin::CC::C;
+    return fence;
+}
+
+/*
+ * registry
+ */
+
+static const Intrinsic intrinsics[] = {
+    // primops
+    { "alignof",        "fn alignof[T]() -> i32",                    1, 0, true, nullptr,       nullptr,              emit_alignof    },
+    { "bitcast",        "fn bitcast[D, S](S) -> D",                  2, 1, true, nullptr,       check_bitcast,        emit_bitcast    },
+    { "select",         "fn select[T, U](T, U, U) -> U",             2, 3, true, nullptr,       check_select,         emit_select     },
+    { "shuffle",        "fn shuffle[V, M, R](V, V, M) -> R",         3, 3, true, infer_shuffle, check_shuffle,        emit_shuffle    },
+    { "sizeof",         "fn sizeof[T]() -> i32",                     1, 0, true, nullptr,       nullptr,              emit_sizeof     },
+    // lowered by ForExpr; the identity starts the accumulator of each chunk
+    { "parallel_reduce", "fn parallel_reduce[T](i32, i32, i32, T, fn(T, T) -> T, fn(i32, T) -> T) -> T", 1, 6, true, nullptr, check_parallel_reduce, nullptr },
+    // LLVM intrinsics, called directly or from a function built around the call
+    { "gather",         "fn gather[T, I, R](&[T], I) -> R",          3, 2, false, infer_gather,  check_gather,         emit_gather     },
+    { "reduce_add",     "fn reduce_add[V, T](V) -> T",               2, 1, false, infer_reduce,  check_reduce_arith,   emit_reduce_add },
+    { "reduce_and",     "fn reduce_and[V, T](V) -> T",               2, 1, false, infer_reduce,  check_reduce_bitwise, emit_reduce_and },
+    { "reduce_max",     "fn reduce_max[V, T](V) -> T",               2, 1, false, infer_reduce,  check_reduce_arith,   emit_reduce_max },
+    { "reduce_min",     "fn reduce_min[V, T](V) -> T",               2, 1, false, infer_reduce,  check_reduce_arith,   emit_reduce_min },
+    { "reduce_mul",     "fn reduce_mul[V, T](V) -> T",               2, 1, false, infer_reduce,  check_reduce_arith,   emit_reduce_mul },
+    { "reduce_or",      "fn reduce_or[V, T](V) -> T",                2, 1, false, infer_reduce,  check_reduce_bitwise, emit_reduce_or  },
+    { "reduce_xor",     "fn reduce_xor[V, T](V) -> T",               2, 1, false, infer_reduce,  check_reduce_bitwise, emit_reduce_xor },
+    { "scatter",        "fn scatter[T, I, V](&mut [T], I, V) -> ()", 3, 3, false, nullptr,       check_scatter,        emit_scatter    },
+    // continuations whose type depends on the call
+    { "reserve_shared", "fn reserve_shared[T](i32) -> &[3][T]",                       1, 1, false, nullptr, nullptr,            emit_reserve_shared },
+    // the trailing memory orderings may be left out of a declaration together
+    { "atomic",         "fn atomic[T](u32, &mut T, T, u32) -> T",                    1, 4, false, nullptr, check_atomic,       emit_atomic,       1 },
+    { "atomic_load",    "fn atomic_load[T](&T, u32) -> T",                           1, 2, false, nullptr, check_atomic_load,  emit_atomic_load,  1 },
+    { "atomic_store",   "fn atomic_store[T](&mut T, T, u32) -> ()",                  1, 3, false, nullptr, check_atomic_store, emit_atomic_store, 1 },
+    { "cmpxchg",        "fn cmpxchg[T](&mut T, T, T, u32, u32) -> (T, bool)",        1, 5, false, nullptr, check_cmpxchg,      emit_cmpxchg,      2 },
+    { "cmpxchg_weak",   "fn cmpxchg_weak[T](&mut T, T, T, u32, u32) -> (T, bool)",   1, 5, false, nullptr, check_cmpxchg,      emit_cmpxchg_weak, 2 },
+    // continuations as declared
+    { "amdgpu",    "fn amdgpu(i32, (i32, i32, i32), (i32, i32, i32), fn() -> ()) -> ()", 0, 4, false, nullptr, nullptr, nullptr },
+    { "cuda",      "fn cuda(i32, (i32, i32, i32), (i32, i32, i32), fn() -> ()) -> ()",   0, 4, false, nullptr, nullptr, nullptr },
+    { "fence",     "fn fence(u32) -> ()",                                                0, 1, false, nullptr, check_fence, emit_fence },
+    { "hls",       "fn hls(i32, fn() -> ()) -> ()",                                      0, 2, false, nullptr, nullptr, nullptr },
+    { "nvvm",      "fn nvvm(i32, (i32, i32, i32), (i32, i32, i32), fn() -> ()) -> ()",   0, 4, false, nullptr, nullptr, nullptr },
+    { "opencl",    "fn opencl(i32, (i32, i32, i32), (i32, i32, i32), fn() -> ()) -> ()", 0, 4, false, nullptr, nullptr, nullptr },
+    { "parallel",  "fn parallel(i32, i32, i32, fn(i32) -> ()) -> ()",                    0, 4, false, nullptr, nullptr, nullptr },
+    { "spawn",     "fn spawn(fn() -> ()) -> i32",                                        0, 1, false, nullptr, nullptr, nullptr },
+    { "sync",      "fn sync(i32) -> ()",                                                 0, 1, false, nullptr, nullptr, nullptr },
+    // older runtimes pass an alignment after the width; 'for' loops over the declared form are lowered by the front end
+    { "vectorize", "fn vectorize(i32, i32, i32, fn(i32) -> ()) -> ()", Intrinsic::Any, Intrinsic::Any, false, nullptr, check_vectorize, nullptr },
+};
+
+bool Intrinsic::matches(size_t num_type_params, size_t num_params) const {
+    return (this->num_type_params == Any || size_t(this->num_type_params) == num_type_params) && takes(num_params);
+}
+
+const Intrinsic* find_intrinsic(const std::string& name) {
+    for (const auto& intrinsic : intrinsics) {
+        if (name == intrinsic.name)
+            return &intrinsic;
+    }
+    return nullptr;
+}
+
+}
@@ -0,0 +1,88 @@
+#ifndef IMPALA_INTRINSICS_H
+#define IMPALA_INTRINSICS_H
+
+#include <string>
+#include <vector>
+
+#include "thorin/util/location.h"
+
+namespace thorin {
+    class Continuation;
+    class Def;
+    class FnType;
+    class Type;
+    class World;
+}
+
+namespace impala {
+
+class MapExpr;
+class Type;
+class TypeTable;
+
+/// A call of an intrinsic as its emission callback sees it: everything already converted to Thorin.
+struct IntrinsicCall {
+    IntrinsicCall(thorin::World& world, const thorin::Location& location, const MapExpr* expr)
+        : world(world)
+        , location(location)
+        , expr(expr)
+    {}
+
+    thorin::World& world;
+    thorin::Location location;
+    const MapExpr* expr;                    ///< For arguments that must be known at compile time.
+    std::vector<const thorin::Type*> type_args;
+    std::vector<const thorin::Type*> arg_types;
+    const thorin::Type* type = nullptr;     ///< Of the result.
+    std::vector<const thorin::Def*> args;   ///< Only emitted for primops.
+    const thorin::Def* mem = nullptr;       ///< The memory monad for primops; one that accesses memory updates it.
+};
+
+/**
+ * A function of an <tt>extern "thorin"</tt> block that the compiler implements.
+ * NameSema looks up each such declaration once - names that are not registered are an error - and InferSema caches the result
+ * on every @c MapExpr that calls it; see @c find_intrinsic. A new intrinsic only needs an entry in the table in intrinsics.cpp.
+ */
+struct Intrinsic {
+    static const int Any = -1;
+
+    const char* name;
+    const char* signature;      ///< How it is to be declared.
+    int num_type_params;        ///< Or @c Any.
+    int num_params;             ///< Or @c Any.
+    /// A primop is emitted in place of the call - its declaration is not emitted at all; otherwise the call goes to a continuation.
+    bool primop;
+    /// Computes the type of a call from its arguments where the declaration cannot express it, or @c nullptr if not known yet; may be @c nullptr.
+    const Type* (*infer)(TypeTable&, const MapExpr*);
+    /// Checks a call beyond its declared type and reports errors itself; may be @c nullptr.
+    void (*check)(const MapExpr*);
+    /**
+     * Emits a call: a primop yields its result; otherwise the continuation to call with the arguments -
+     * an intrinsic one, which Thorin's back ends lower by its name, an LLVM intrinsic, a function of the runtime or a function built around one of these.
+     * If @c nullptr, the call goes to the continuation of the declaration.
+     */
+    const thorin::Def* (*emit)(IntrinsicCall&);
+    /// How many of the last @c num_params may be left out together - of a declaration and then of its calls alike.
+    int num_optional_params = 0;
+
+    /// Whether a declaration with that many type parameters and parameters matches @c signature.
+    bool matches(size_t num_type_params, size_t num_params) const;
+    /// Whether a call with that many arguments fits @c signature; only then are @c infer, @c check and @c emit called.
+    bool takes(size_t num_args) const {
+        return num_params == Any || size_t(num_params) == num_args || size_t(num_params) == num_args + num_optional_params;
+    }
+};
+
+/// The intrinsic called @p name - without quotation marks - or @c nullptr.
+const Intrinsic* find_intrinsic(const std::string& name);
+
+/// Size in bits of a primitive type, or 0 if @p type is none.
+int num_bits(const Type* type);
+/// How LLVM names @p type - a primitive type or a simd vector of one - in the instances of its overloaded intrinsics, e.g. @c v4f32.
+std::string llvm_suffix(const Type* type);
+/// The LLVM intrinsic @p name, which Thorin's LLVM back end calls by its name like an <tt>extern "device"</tt> function.
+thorin::Continuation* llvm_intrinsic(thorin::World&, const thorin::Location&, const std::string& name, const thorin::FnType*);
+
+}
+
+#endif
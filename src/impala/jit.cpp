@@ -0,0 +1,130 @@
+#include "impala/jit.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef LLVM_SUPPORT
+#include <llvm/ExecutionEngine/JITEventListener.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h>
+#include <llvm/ExecutionEngine/SectionMemoryManager.h>
+#include <llvm/Object/SymbolSize.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+#endif
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "impala/backend.h"
+
+namespace impala {
+
+#if defined(LLVM_SUPPORT) && !defined(_WIN32)
+
+static void check(llvm::Error err) {
+    if (err)
+        throw std::runtime_error("JIT: " + llvm::toString(std::move(err)));
+}
+
+template<class T>
+static T check(llvm::Expected<T> expected) {
+    if (!expected)
+        check(expected.takeError());
+    return std::move(*expected);
+}
+
+/// Writes the perf map format: one <tt>start size name</tt> line per JITed function, addresses in hex.
+class PerfMapListener : public llvm::JITEventListener {
+public:
+    PerfMapListener()
+        : stream_("/tmp/perf-" + std::to_string(getpid()) + ".map")
+    {}
+
+    void notifyObjectLoaded(ObjectKey, const llvm::object::ObjectFile& obj, const llvm::RuntimeDyld::LoadedObjectInfo& info) override {
+        for (const auto& sym_size : llvm::object::computeSymbolSizes(obj)) {
+            const auto& sym = sym_size.first;
+            auto type    = sym.getType();
+            auto name    = sym.getName();
+            auto addr    = sym.getAddress();
+            auto section = sym.getSection();
+            if (!type || !name || !addr || !section) {
+                llvm::consumeError(type.takeError());
+                llvm::consumeError(name.takeError());
+                llvm::consumeError(addr.takeError());
+                llvm::consumeError(section.takeError());
+                continue;
+            }
+            if (*type != llvm::object::SymbolRef::ST_Function || *section == obj.section_end())
+                continue;
+
+            uint64_t load_addr = *addr - (*section)->getAddress() + info.getSectionLoadAddress(**section);
+            stream_ << std::hex << load_addr << ' ' << sym_size.second << std::dec << ' ' << name->str() << '\n';
+        }
+        stream_.flush();
+    }
+
+private:
+    std::ofstream stream_;
+};
+
+int jit_run(const std::string& ll_file, const std::vector<std::string>& libs, const std::vector<std::string>& args, bool perf_map) {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+
+    auto context = std::make_unique<llvm::LLVMContext>();
+    auto module = load_llvm(*context, ll_file);
+
+    std::unique_ptr<PerfMapListener> perf_map_listener;
+    if (perf_map)
+        perf_map_listener = std::make_unique<PerfMapListener>();
+
+    auto jit = check(llvm::orc::LLJITBuilder()
+        .setObjectLinkingLayerCreator([&] (llvm::orc::ExecutionSession& session, const llvm::Triple&) {
+            auto layer = std::make_unique<llvm::orc::RTDyldObjectLinkingLayer>(session, [] { return std::make_unique<llvm::SectionMemoryManager>(); });
+            if (perf_map_listener) {
+                layer->registerJITEventListener(*perf_map_listener);
+                if (auto jitdump = llvm::JITEventListener::createPerfJITEventListener())
+                    layer->registerJITEventListener(*jitdump);
+            }
+            return llvm::Expected<std::unique_ptr<llvm::orc::ObjectLayer>>(std::move(layer));
+        })
+        .create());
+
+    // symbols of the given runtime libraries take precedence over those of the host process
+    auto& dylib = jit->getMainJITDylib();
+    auto prefix = jit->getDataLayout().getGlobalPrefix();
+    for (const auto& lib : libs)
+        dylib.addGenerator(check(llvm::orc::DynamicLibrarySearchGenerator::Load(lib.c_str(), prefix)));
+    dylib.addGenerator(check(llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(prefix)));
+
+    check(jit->addIRModule(llvm::orc::ThreadSafeModule(std::move(module), std::move(context))));
+    check(jit->initialize(dylib));
+    auto main = check(jit->lookup("main"));
+
+    std::vector<char*> argv;
+    for (const auto& arg : args)
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    auto fn = reinterpret_cast<int (*)(int, char**)>(main.getAddress());
+    int status = fn(int(args.size()), argv.data());
+    std::fflush(stdout);
+
+    check(jit->deinitialize(dylib));
+    return status;
+}
+
+#else
+
+int jit_run(const std::string&, const std::vector<std::string>&, const std::vector<std::string>&, bool) {
+    throw std::logic_error("-run requires an impala built with LLVM support on a POSIX system");
+}
+
+#endif
+
+}
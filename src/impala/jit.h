@@ -0,0 +1,20 @@
+#ifndef IMPALA_JIT_H
+#define IMPALA_JIT_H
+
+#include <string>
+#include <vector>
+
+namespace impala {
+
+/**
+ * Loads the LLVM module in @p ll_file into an in-process ORC JIT and calls its @c main.
+ * @c extern "C" functions resolve against the shared libraries in @p libs first and then against the running process.
+ * @p args become @c argv of the program - including @c argv[0].
+ * With @p perf_map, symbols of JITed code are written to <tt>/tmp/perf-<pid>.map</tt> (and to a jitdump if LLVM was built with perf support).
+ * Returns the exit status of @c main.
+ */
+int jit_run(const std::string& ll_file, const std::vector<std::string>& libs, const std::vector<std::string>& args, bool perf_map);
+
+}
+
+#endif
@@ -47,6 +47,13 @@ int Lexer::next() {
 }
 
 Token Lexer::lex() {
+    auto token = lex_token();
+    if (token != Token::Eof)
+        ++num_tokens_;
+    return token;
+}
+
+Token Lexer::lex_token() {
     while (true) {
         std::string str; // the token string is concatenated here
         front_line_ = peek_line_;
@@ -168,6 +175,7 @@ Token Lexer::lex() {
         if (accept('{')) return {location(), Token::L_BRACE};
         if (accept('}')) return {location(), Token::R_BRACE};
         if (accept('~')) return {location(), Token::TILDE};
+        if (accept('#')) return {location(), Token::HASH};
 
         // '.', floats
         if (accept('.')) {
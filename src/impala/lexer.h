@@ -14,8 +14,10 @@ public:
     Lexer(std::istream& stream, const char* filename);
 
     Token lex(); ///< Get next \p Token in stream.
+    size_t num_tokens() const { return num_tokens_; } ///< Tokens lexed so far, not counting \p Token::Eof.
 
 private:
+    Token lex_token();
     bool lex_identifier(std::string&);
     Token lex_suffix(std::string&, bool floating);
     Token literal_error(std::string&, bool floating);
@@ -49,6 +51,7 @@ private:
 
     std::istream& stream_;
     const char* filename_;
+    size_t num_tokens_ = 0;
     uint32_t front_line_ = 1, front_col_ = 1, back_line_ = 1, back_col_ = 1, peek_line_ = 1, peek_col_ = 1;
 };
 
@@ -1,6 +1,12 @@
 #include <fstream>
+#include <sstream>
 #include <vector>
 #include <cctype>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
 #include <stdexcept>
 
 #include "thorin/be/llvm/llvm.h"
@@ -10,8 +16,16 @@
 #include "thorin/util/ycomp.h"
 
 #include "impala/ast.h"
+#include "impala/backend.h"
 #include "impala/cgen.h"
+#include "impala/costreport.h"
+#include "impala/pebudget.h"
+#include "impala/remarks.h"
+#include "impala/vectorizereport.h"
 #include "impala/impala.h"
+#include "impala/jit.h"
+#include "impala/server.h"
+#include "impala/stats.h"
 
 //------------------------------------------------------------------------------
 
@@ -22,6 +36,19 @@ typedef vector<string> Names;
 
 //------------------------------------------------------------------------------
 
+// count allocations for -time-passes
+void* operator new(size_t size) {
+    impala::num_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+//------------------------------------------------------------------------------
+
 ostream* open(ofstream& stream, const string& name) {
     if (name == "-")
         return &cout;
@@ -30,21 +57,25 @@ ostream* open(ofstream& stream, const string& name) {
     return &stream;
 }
 
-int main(int argc, char** argv) {
+/// Runs one compilation; @p cache is only set when running as a resident server (see @c impala::serve).
+int compile(int argc, char** argv, impala::SourceCache* cache) {
     try {
         if (argc < 1)
             throw logic_error("bad number of arguments");
 
         string prgname = argv[0];
-        Names infiles;
+        string server;
+        Names infiles, libs, link_bitcode, run_args;
 #ifndef NDEBUG
         Names breakpoints;
 #endif
-        string out_name, log_name, log_level;
+        string out_name, log_name, log_level, jobs, stats_file, stats_format, pe_max_specializations, pe_max_size, pe_max_time,
+               remarks_filter, remarks_file, remarks_format;
         bool help,
-             emit_cint, emit_thorin, emit_ast, emit_annotated, emit_llvm, emit_ycomp, emit_ycomp_cfg,
+             emit_cint, emit_thorin, emit_ast, emit_annotated, emit_llvm, emit_obj, emit_bc, emit_ycomp, emit_ycomp_cfg,
              opt_thorin, opt_s, opt_0, opt_1, opt_2, opt_3, debug,
-             nocleanup, nossa, fancy;
+             nocleanup, noopt, nossa, fancy, run, perf_map, time_passes, print_stats, cost_report, pe_report, print_remarks,
+             vectorize_report;
         YCompCommandLine yComp;
 
         auto cmd_parser = ArgParser()
@@ -62,24 +93,57 @@ int main(int argc, char** argv) {
             .add_option<bool>            ("O3",                 "",                               "optimize yet more", opt_3, false)
             .add_option<bool>            ("Os",                 "",                               "optimize for size", opt_s, false)
             .add_option<bool>            ("Othorin",            "",                               "optimize at Thorin level", opt_thorin, false)
+            .add_option<bool>            ("cost-report",        "",                               "report front-end time, Thorin defs and LLVM instructions per source function to stderr (implies -Othorin and -g)", cost_report, false)
             .add_option<bool>            ("emit-annotated",     "",                               "emit AST of Impala program after semantic analysis", emit_annotated, false)
             .add_option<bool>            ("emit-ast",           "",                               "emit AST of Impala program", emit_ast, false)
+            .add_option<bool>            ("emit-bc",            "",                               "emit optimized LLVM bitcode with a ThinLTO summary to <module>.bc", emit_bc, false)
             .add_option<bool>            ("emit-c-interface",   "",                               "emit C interface from Impala code (experimental)", emit_cint, false)
             .add_option<bool>            ("emit-llvm",          "",                               "emit llvm from Thorin representation (implies -Othorin)", emit_llvm, false)
+            .add_option<bool>            ("emit-obj",           "",                               "emit an optimized native object file to <module>.o", emit_obj, false)
             .add_option<bool>            ("emit-thorin",        "",                               "emit textual Thorin representation of Impala program", emit_thorin, false)
             .add_option<bool>            ("emit-ycomp",         "",                               "emit ycomp-compatible graph representation of Impala program", emit_ycomp, false)
             .add_option<bool>            ("emit-ycomp-cfg",     "",                               "emit ycomp-compatible control-flow graph representation of Impala program", emit_ycomp_cfg, false)
             .add_option<bool>            ("f",                  "",                               "use fancy output: Impala's AST dump uses only parentheses where necessary", fancy, false)
             .add_option<bool>            ("g",                  "",                               "emit debug information", debug, false)
+            .add_option<string>          ("j",                  "<N>",                            "split -emit-obj output into N partitions <module>.<i>.o that are optimized and code-generated in parallel", jobs, "1")
+            .add_option<vector<string>>  ("link-bitcode",       "<file>",                         "link runtime bitcode <file> into -emit-obj/-emit-bc output so that its functions can be inlined; may be used multiple times", link_bitcode)
+            .add_option<vector<string>>  ("load",               "<lib>",                          "resolve extern \"C\" symbols of -run in shared library <lib> first; may be used multiple times", libs)
             .add_option<bool>            ("nocleanup",          "",                               "no clean-up phase", nocleanup, false)
+            .add_option<bool>            ("noopt",              "",                               "no Thorin optimization phase, even where -Othorin is implied", noopt, false)
             .add_option<bool>            ("nossa",              "",                               "use slots + load/store instead of SSA construction", nossa, false)
+            .add_option<string>          ("pe-max-size",        "<N>",                            "residualize the @ annotations that grow the optimized program beyond N Thorin defs (0: unlimited)", pe_max_size, "0")
+            .add_option<string>          ("pe-max-specializations", "<N>",                        "residualize @ annotations that partial evaluation copies more than N times (0: unlimited)", pe_max_specializations, "0")
+            .add_option<string>          ("pe-max-time",        "<ms>",                           "residualize @ annotations until emission and Thorin optimization finish within <ms> (0: 10000)", pe_max_time, "0")
+            .add_option<bool>            ("pe-report",          "",                               "report to stderr which @ annotations were specialized, how often and at what size", pe_report, false)
+            .add_option<bool>            ("perf-map",           "",                               "make code JITed by -run visible to perf via /tmp/perf-<pid>.map", perf_map, false)
+            .add_option<bool>            ("remarks",            "",                               "report missed optimizations - unspecialized higher-order calls, closures, unpromoted locals, allocations in loops - at their source location (implies -Othorin)", print_remarks, false)
+            .add_option<string>          ("remarks-file",       "<file>",                         "write the -remarks report to <file>; use '-' for stdout (default: stderr)", remarks_file, "")
+            .add_option<string>          ("remarks-filter",     "<regex>",                        "only report -remarks whose kind - specialize, closure, mem2reg or alloc-in-loop - matches <regex>", remarks_filter, ".*")
+            .add_option<string>          ("remarks-format",     "{text|json}",                    "format of the -remarks report", remarks_format, "text")
+            .add_option<bool>            ("run",                "",                               "JIT-compile the program in process and call its main; arguments after '--' are passed to main", run, false)
+            .add_option<string>          ("server",             "<socket>",                       "stay resident and serve compile requests from impala-client on the Unix socket <socket>", server, "")
+            .add_option<bool>            ("stats",              "",                               "like -time-passes but also report counters such as tokens, AST nodes, types, Thorin continuations/primops and residual calls, loops and closures", print_stats, false)
+            .add_option<string>          ("stats-file",         "<file>",                         "write the -time-passes/-stats report to <file>; use '-' for stdout (default: stderr)", stats_file, "")
+            .add_option<string>          ("stats-format",       "{text|json|trace}",              "format of the -time-passes/-stats report; 'trace' is Chrome's trace event format", stats_format, "text")
+            .add_option<bool>            ("time-passes",        "",                               "report wall time, CPU time, peak RSS growth and allocations of each compiler phase", time_passes, false)
+            .add_option<bool>            ("vectorize-report",   "",                               "report for each for and while loop whether LLVM vectorized it and why not (implies -g)", vectorize_report, false)
             .add_option<YCompCommandLine>("ycomp",              "{cfg|domtree|domfrontiers|looptree} {true|false} <arg>    ",
                 "print ycomp graph to <arg>; the flag indicates whether the graph is based upon a forward (true) or backwards (false) CFG; the option can be specified multiple times",
                 yComp, YCompCommandLine());
 
+        // everything after '--' belongs to the program started by -run
+        for (int i = 1; i < argc; ++i) {
+            if (!strcmp(argv[i], "--")) {
+                run_args.assign(argv + i + 1, argv + argc);
+                argc = i;
+                break;
+            }
+        }
+
         // do cmdline parsing
         cmd_parser.parse(argc, argv);
-        opt_thorin |= emit_llvm;
+        opt_thorin |= emit_llvm || emit_obj || emit_bc || run || cost_report || print_remarks || vectorize_report;
+        opt_thorin &= !noopt;
 
         impala::fancy() = fancy;
 
@@ -111,6 +175,12 @@ int main(int argc, char** argv) {
         else if (opt_2) opt = 2;
         else if (opt_3) opt = 3;
 
+        if (!server.empty()) {
+            if (cache != nullptr)
+                throw invalid_argument("-server cannot be requested from a server session");
+            return impala::serve(server, compile);
+        }
+
         if (infiles.empty() && !help) {
             std::cerr << "no input files" << std::endl;
             return EXIT_FAILURE;
@@ -141,7 +211,74 @@ int main(int argc, char** argv) {
             }
         }
 
-        impala::Init init(module_name);
+        impala::Stats::Format format;
+        if (stats_format == "text")       format = impala::Stats::Format::Text;
+        else if (stats_format == "json")  format = impala::Stats::Format::JSON;
+        else if (stats_format == "trace") format = impala::Stats::Format::Trace;
+        else
+            throw invalid_argument("stats format must be one of {text|json|trace}");
+
+        std::unique_ptr<impala::Stats> stats;
+        if (time_passes || print_stats)
+            stats = std::make_unique<impala::Stats>();
+        impala::StatsScope stats_scope(stats.get());
+
+        std::unique_ptr<impala::CostReport> cost;
+        if (cost_report)
+            cost = std::make_unique<impala::CostReport>();
+        impala::CostReportScope cost_scope(cost.get());
+
+        auto parse_limit = [] (const string& option, const string& value) -> unsigned long {
+            size_t end = 0;
+            unsigned long limit = 0;
+            try {
+                limit = std::stoul(value, &end);
+            } catch (const exception&) {
+                end = 0;
+            }
+            if (end == 0 || end != value.size() || value[0] == '-')
+                throw invalid_argument("-" + option + " expects a non-negative integer");
+            return limit;
+        };
+        impala::PEBudget::Limits pe_limits;
+        pe_limits.max_specializations = parse_limit("pe-max-specializations", pe_max_specializations);
+        pe_limits.max_size            = parse_limit("pe-max-size", pe_max_size);
+        pe_limits.max_ms              = parse_limit("pe-max-time", pe_max_time);
+
+        unsigned long num_jobs = 0;
+        try {
+            num_jobs = parse_limit("j", jobs);
+        } catch (const invalid_argument&) {}
+        if (num_jobs < 1 || num_jobs > INT_MAX)
+            throw invalid_argument("-j expects a positive number of partitions");
+        if (num_jobs != 1 && !emit_obj)
+            std::cerr << "warning: -j only splits -emit-obj output and has no effect without it" << std::endl;
+
+        impala::Remarks::Format remarks_fmt;
+        if (remarks_format == "text")      remarks_fmt = impala::Remarks::Format::Text;
+        else if (remarks_format == "json") remarks_fmt = impala::Remarks::Format::JSON;
+        else
+            throw invalid_argument("remarks format must be one of {text|json}");
+
+        std::unique_ptr<impala::Remarks> remarks;
+        if (print_remarks) {
+            try {
+                remarks = std::make_unique<impala::Remarks>(remarks_filter);
+            } catch (const std::regex_error&) {
+                throw invalid_argument("invalid -remarks-filter '" + remarks_filter + "'");
+            }
+        }
+
+        // always collected: #[must_vectorize] has to be checked even without -vectorize-report
+        impala::VectorizeReport vectorize;
+        impala::VectorizeReportScope vectorize_scope(&vectorize);
+
+        std::unique_ptr<impala::PEBudget> pe;
+        if (pe_limits.any() || pe_report)
+            pe = std::make_unique<impala::PEBudget>(pe_limits);
+        impala::PEBudgetScope pe_scope(pe.get());
+
+        impala::Init init(module_name, cache != nullptr);
 
 #ifndef NDEBUG
         for (auto b : breakpoints) {
@@ -161,10 +298,18 @@ int main(int argc, char** argv) {
 #endif
 
         impala::Items items;
-        for (const auto& infile : infiles) {
-            auto filename = infile.c_str();
-            ifstream file(filename);
-            impala::parse(items, file, filename);
+        {
+            impala::PhaseTimer timer("parse");
+            for (const auto& infile : infiles) {
+                auto filename = infile.c_str();
+                if (cache != nullptr) {
+                    istringstream file(cache->get(infile));
+                    impala::parse(items, file, filename);
+                } else {
+                    ifstream file(filename);
+                    impala::parse(items, file, filename);
+                }
+            }
         }
 
         auto module = std::make_unique<const impala::Module>(infiles.front().c_str(), std::move(items));
@@ -202,25 +347,121 @@ int main(int argc, char** argv) {
             impala::generate_c_interface(module.get(), opts, out_file);
         }
 
-        if (result && (emit_llvm || emit_thorin || emit_ycomp || emit_ycomp_cfg))
+        // besides -emit-llvm, these pick up the LLVM module thorin::emit_llvm writes to <module>.ll
+        bool llvm_consumer = emit_obj || emit_bc || run || cost_report || vectorize_report;
+
+        if (result && (emit_llvm || emit_thorin || emit_ycomp || emit_ycomp_cfg || llvm_consumer || print_remarks)) {
+            if (pe && opt_thorin) {
+                // trial compilations in child processes decide which @ annotations to residualize below
+                impala::PhaseTimer timer("pe_trials");
+                pe->fit(init.world, [&] { emit(init.world, module.get()); }, [&] {
+                    if (!nocleanup) init.world.cleanup();
+                    init.world.opt();
+                });
+            }
+            impala::PhaseTimer timer("emit");
             emit(init.world, module.get());
+            if (stats) stats->count(init.world);
+        }
 
+        int status = EXIT_SUCCESS;
         if (result) {
-            if (!nocleanup)
+            if (!nocleanup) {
+                impala::PhaseTimer timer("cleanup");
                 init.world.cleanup();
-            if (opt_thorin)
+                if (stats) stats->count(init.world);
+            }
+            if (opt_thorin) {
+                impala::PhaseTimer timer("opt");
                 init.world.opt();
+                if (stats) stats->count(init.world);
+            }
+            if (pe)
+                pe->count(init.world);
+            if (remarks)
+                remarks->analyze(init.world);
             if (emit_thorin)      init.world.dump();
-            if (emit_llvm)        thorin::emit_llvm(init.world, opt, debug);
+            if (cost)
+                cost->count_defs(init.world);
+            // vectorization is reported by the in-process LLVM pipeline, which maps it back to loops via debug locations;
+            // #[must_vectorize] is only enforced where LLVM vectorizes at all, so that unoptimized builds keep working
+            bool vectorizing = opt >= 2 || opt == -1;
+            bool check_vectorize = (emit_llvm || llvm_consumer) && (vectorize_report || (vectorizing && vectorize.any_required()));
+            impala::BackendOptions backend;
+#ifdef LLVM_SUPPORT
+            // thorin cannot mark the '&mut' parameters that type analysis proved exclusive as noalias, so the in-process pipeline does
+            if (emit_llvm || llvm_consumer)
+                backend.noalias = impala::noalias_params(module.get());
+#endif
+            bool optimize_in_process = check_vectorize || !backend.noalias.empty();
+            // -emit-obj/-emit-bc optimize themselves after linking the runtime bitcode
+            if (emit_llvm || llvm_consumer) {
+                impala::PhaseTimer timer("emit_llvm");
+                // -cost-report traces LLVM instructions back to source functions via debug locations
+                thorin::emit_llvm(init.world, (emit_llvm || run || cost_report) && !optimize_in_process ? opt : 0, debug || cost_report || check_vectorize);
+            }
+            auto ll_file = module_name + ".ll";
+
+            backend.opt = opt;
+            backend.bitcode = link_bitcode;
+            backend.jobs = int(num_jobs);
+            if (optimize_in_process) {
+                if (check_vectorize)
+                    backend.vectorize_report = &vectorize;
+                if (!emit_obj && !emit_bc) {
+                    impala::PhaseTimer timer("opt_llvm");
+                    impala::optimize_llvm(ll_file, backend);
+                }
+            }
+
+            if (cost)
+                cost->count_llvm(ll_file);
             if (emit_ycomp)
                 std::cerr << "-emit-ycomp: this feature is currently removed" << std::endl;
             if (emit_ycomp_cfg)
                 std::cerr << "-emit-ycomp-cfg: this feature is currently removed" << std::endl;
             yComp.print(init.world);
+
+            if (emit_obj) {
+                impala::PhaseTimer timer("emit_obj");
+                impala::emit_object(ll_file, module_name + ".o", backend);
+                backend.vectorize_report = nullptr; // already reported
+            }
+            if (emit_bc) {
+                impala::PhaseTimer timer("emit_bc");
+                impala::emit_bitcode(ll_file, module_name + ".bc", backend);
+            }
+            if (vectorize_report)
+                vectorize.write(std::cerr);
+            if (check_vectorize && vectorizing && !vectorize.check())
+                status = EXIT_FAILURE;
+            if (run && status == EXIT_SUCCESS) {
+                run_args.insert(run_args.begin(), module_name);
+                status = impala::jit_run(ll_file, libs, run_args, perf_map);
+            }
+            if (llvm_consumer && !emit_llvm)
+                std::remove(ll_file.c_str());
         } else
-            return EXIT_FAILURE;
+            status = EXIT_FAILURE;
 
-        return EXIT_SUCCESS;
+        if (cost)
+            cost->write(std::cerr);
+        if (pe_report)
+            pe->write(std::cerr);
+
+        if (remarks) {
+            ofstream remarks_stream;
+            auto os = remarks_file.empty() ? &std::cerr : open(remarks_stream, remarks_file);
+            remarks->write(*os, remarks_fmt);
+        }
+
+        if (stats) {
+            ofstream stats_stream;
+            auto os = stats_file.empty() ? &std::cerr : open(stats_stream, stats_file);
+            stats->write(*os, format, print_stats);
+        }
+
+        return status;
     } catch (exception const& e) {
         cerr << e.what() << std::endl;
         return EXIT_FAILURE;
@@ -229,3 +470,5 @@ int main(int argc, char** argv) {
         return EXIT_FAILURE;
     }
 }
+
+int main(int argc, char** argv) { return compile(argc, argv, nullptr); }
@@ -1,12 +1,14 @@
 #include <algorithm>
 #include <functional>
 #include <sstream>
+#include <utility>
 
 #include "thorin/util/array.h"
 
 #include "impala/ast.h"
 #include "impala/impala.h"
 #include "impala/lexer.h"
+#include "impala/stats.h"
 
 #define VISIBILITY \
          Token::PRIV: \
@@ -120,6 +122,7 @@ public:
     }
 
     const Token& lookahead(size_t i = 0) const { assert(i < 3); return lookahead_[i]; }
+    size_t num_tokens() const { return lexer_.num_tokens(); }
     Location prev_location() const { return prev_location_; }
 
 #ifdef NDEBUG
@@ -180,8 +183,12 @@ public:
     // misc
     const Identifier* try_identifier(const std::string& what);
     Visibility parse_visibility();
+    void parse_attribute_list();
+    void parse_attributes(bool loops);
+    int parse_align();
     uint64_t parse_integer(const char* what);
     int parse_addr_space();
+    int parse_ptr_align();
     char char_value(const char*& p);
 
     // paths
@@ -277,6 +284,8 @@ private:
     Token lookahead_[3]; ///< SLL(3) look ahead
     size_t cur_var_handle;
     Location prev_location_;
+    bool must_vectorize_ = false; ///< A pending <tt>#[must_vectorize]</tt> for the next function or loop.
+    int align_ = 0;               ///< A pending <tt>#[align(N)]</tt> for the next struct or static item.
 };
 
 //------------------------------------------------------------------------------
@@ -286,6 +295,7 @@ void parse(Items& items, std::istream& is, const char* filename) {
     parser.parse_items(items);
     if (parser.lookahead() != Token::Eof)
         parser.error("module item", "module contents");
+    count("tokens", parser.num_tokens());
 }
 
 //------------------------------------------------------------------------------
@@ -346,6 +356,63 @@ Visibility Parser::parse_visibility() {
     }
 }
 
+/// Parses <tt>#[must_vectorize]</tt> and <tt>#[align(N)]</tt> and keeps them pending for what follows.
+void Parser::parse_attribute_list() {
+    while (accept(Token::HASH)) {
+        expect(Token::L_BRACKET, "attribute");
+        parse_comma_list("closing bracket of attribute", Token::R_BRACKET, [&] {
+            if (lookahead() != Token::ID) {
+                error("identifier", "attribute");
+                return;
+            }
+            auto name = lex();
+            if (name.symbol() == "must_vectorize")
+                must_vectorize_ = true;
+            else if (name.symbol() == "align")
+                align_ = parse_align();
+            else
+                impala::error(name.location(), "unknown attribute '{}'", name.symbol());
+        });
+    }
+}
+
+/**
+ * Parses attributes for the function or, with @p loops, the @c for or @c while loop that follows - <tt>#[must_vectorize]</tt> -
+ * or for the struct or static item that follows - <tt>#[align(N)]</tt>.
+ */
+void Parser::parse_attributes(bool loops) {
+    auto location = lookahead().location();
+    parse_attribute_list();
+
+    size_t i = lookahead() == Token::PUB || lookahead() == Token::PRIV ? 1 : 0;
+    bool item = lookahead(i) == Token::STRUCT || lookahead(i) == Token::STATIC;
+    if (lookahead(i) == Token::EXTERN)
+        ++i;
+    bool fn = lookahead(i) == Token::FN;
+    bool loop = i == 0 && (lookahead() == Token::FOR || lookahead() == Token::WHILE);
+    if (must_vectorize_ && !fn && !(loops && loop)) {
+        impala::error(location, "'#[must_vectorize]' only applies to functions{}", loops ? " and to for and while loops" : "");
+        must_vectorize_ = false;
+    }
+    if (align_ != 0 && !item) {
+        impala::error(location, "'#[align]' only applies to structs, static items and the targets of pointer types");
+        align_ = 0;
+    }
+}
+
+/// Parses the parenthesized alignment of <tt>#[align(N)]</tt>; yields 0 if it is no power of two.
+int Parser::parse_align() {
+    expect(Token::L_PAREN, "alignment");
+    auto location = lookahead().location();
+    auto align = parse_integer("alignment");
+    expect(Token::R_PAREN, "alignment");
+    if (align == 0 || (align & (align - 1)) != 0 || align > 4096) {
+        impala::error(location, "alignment must be a power of two no greater than 4096, not {}", align);
+        return 0;
+    }
+    return int(align);
+}
+
 uint64_t Parser::parse_integer(const char* what) {
     switch (lookahead()) {
         case Token::LIT_i8:  return lex().box().get_s8();
@@ -362,6 +429,21 @@ uint64_t Parser::parse_integer(const char* what) {
     }
 }
 
+/// Parses the <tt>#[align(N)]</tt> of the target of a pointer type, which is 0 without one.
+int Parser::parse_ptr_align() {
+    if (lookahead() != Token::HASH)
+        return 0;
+
+    auto location = lookahead().location();
+    auto must_vectorize = std::exchange(must_vectorize_, false);
+    auto align = std::exchange(align_, 0);
+    parse_attribute_list();
+    if (must_vectorize_)
+        impala::error(location, "'#[must_vectorize]' does not apply to pointer types");
+    must_vectorize_ = must_vectorize;
+    return std::exchange(align_, align);
+}
+
 int Parser::parse_addr_space() {
     if (lookahead(0) == Token::L_BRACKET && lookahead(1) == Token::LIT_i32) {
         eat(Token::L_BRACKET);
@@ -526,6 +608,7 @@ const Item* Parser::parse_extern_block_or_fn_decl(Tracker tracker, Visibility vi
 const FnDecl* Parser::parse_fn_decl(BodyMode mode, Tracker tracker, Visibility vis, bool is_extern, Symbol abi) {
     //THORIN_PUSH(cur_var_handle, cur_var_handle);
 
+    auto must_vectorize = std::exchange(must_vectorize_, false);
     eat(Token::FN);
     auto export_name = lookahead() == Token::LIT_str ? lex().symbol() : Symbol();
     auto identifier = try_identifier("function name");
@@ -546,7 +629,7 @@ const FnDecl* Parser::parse_fn_decl(BodyMode mode, Tracker tracker, Visibility v
     }
 
     return new FnDecl(tracker, vis, is_extern, abi, export_name, identifier, std::move(ast_type_params),
-                      std::move(params), body);
+                      std::move(params), body, must_vectorize);
 }
 
 const ImplItem* Parser::parse_impl(Tracker tracker, Visibility vis) {
@@ -592,6 +675,9 @@ void Parser::parse_items(Items& items) {
             case ITEM:
                 items.emplace_back(parse_item());
                 continue;
+            case Token::HASH:
+                parse_attributes(/*loops*/ false);
+                continue;
             case Token::SEMICOLON:
                 lex();
                 continue;
@@ -602,16 +688,23 @@ void Parser::parse_items(Items& items) {
 }
 
 const StaticItem* Parser::parse_static_item(Tracker tracker, Visibility vis) {
+    auto align = std::exchange(align_, 0);
+    auto location = lookahead().location();
     eat(Token::STATIC);
     bool mut = accept(Token::MUT);
+    if (align != 0 && !mut) {
+        impala::error(location, "'#[align]' only applies to mutable static items: others do not live in memory");
+        align = 0;
+    }
     auto identifier = try_identifier("static item");
     auto ast_type = accept(Token::COLON) ? parse_type() : nullptr;
     auto init = accept(Token::ASGN) ? parse_expr() : nullptr;
     expect(Token::SEMICOLON, "static item");
-    return new StaticItem(tracker, vis, mut, identifier, ast_type, init);
+    return new StaticItem(tracker, vis, mut, identifier, ast_type, init, align);
 }
 
 const StructDecl* Parser::parse_struct_decl(Tracker tracker, Visibility vis) {
+    auto align = std::exchange(align_, 0);
     eat(Token::STRUCT);
     auto identifier = try_identifier("struct declaration");
     auto ast_type_params = parse_ast_type_params();
@@ -621,7 +714,7 @@ const StructDecl* Parser::parse_struct_decl(Tracker tracker, Visibility vis) {
     parse_comma_list("closing brace of struct declaration", Token::R_BRACE, [&] {
         field_decls.emplace_back(parse_field_decl(i++));
     });
-    return new StructDecl(tracker, vis, identifier, std::move(ast_type_params), std::move(field_decls));
+    return new StructDecl(tracker, vis, identifier, std::move(ast_type_params), std::move(field_decls), align);
 }
 
 const FieldDecl* Parser::parse_field_decl(const size_t i) {
@@ -764,8 +857,9 @@ const PtrASTType* Parser::parse_ptr_type() {
     if (accept(Token::ANDAND)) {
         auto tag = accept(Token::MUT) ? PtrASTType::Mut : PtrASTType::Borrowed;
         auto addr_space = parse_addr_space();
+        auto align = parse_ptr_align();
         auto referenced_ast_type = parse_type();
-        return new PtrASTType(tracker, PtrASTType::Borrowed, 0, new PtrASTType(tracker, tag, addr_space, referenced_ast_type));
+        return new PtrASTType(tracker, PtrASTType::Borrowed, 0, new PtrASTType(tracker, tag, addr_space, referenced_ast_type, align));
     }
 
     PtrASTType::Tag tag;
@@ -780,8 +874,9 @@ const PtrASTType* Parser::parse_ptr_type() {
     }
 
     auto addr_space = parse_addr_space();
+    auto align = parse_ptr_align();
     auto referenced_ast_type = parse_type();
-    return new PtrASTType(tracker, tag, addr_space, referenced_ast_type);
+    return new PtrASTType(tracker, tag, addr_space, referenced_ast_type, align);
 }
 
 const TupleASTType* Parser::parse_tuple_type() {
@@ -1124,6 +1219,7 @@ const IfExpr* Parser::parse_if_expr() {
 const ForExpr* Parser::parse_for_expr() {
     //THORIN_PUSH(cur_var_handle, cur_var_handle);
     auto tracker = track();
+    auto must_vectorize = std::exchange(must_vectorize_, false);
     eat(Token::FOR);
     auto params = param_list() ? parse_param_list(Token::IN, true) : Params();
     params.emplace_back(create<Param>(cur_var_handle++, create<Identifier>("continue"), nullptr));
@@ -1131,7 +1227,7 @@ const ForExpr* Parser::parse_for_expr() {
     auto expr = parse_expr();
     auto body = try_block_expr("body of for loop");
     auto break_decl = create_continuation_decl("break", /*set type during InferSema*/ false);
-    return new ForExpr(tracker, new FnExpr(tracker, std::move(params), body), expr, break_decl);
+    return new ForExpr(tracker, new FnExpr(tracker, std::move(params), body), expr, break_decl, must_vectorize);
 }
 
 const ForExpr* Parser::parse_with_expr() {
@@ -1150,12 +1246,13 @@ const ForExpr* Parser::parse_with_expr() {
 
 const WhileExpr* Parser::parse_while_expr() {
     auto tracker = track();
+    auto must_vectorize = std::exchange(must_vectorize_, false);
     eat(Token::WHILE);
     auto continue_decl = create_continuation_decl("continue", true);
     auto cond = parse_expr();
     auto body = try_block_expr("body of while loop");
     auto break_decl = create_continuation_decl("break", true);
-    return new WhileExpr(tracker, continue_decl, cond, body, break_decl);
+    return new WhileExpr(tracker, continue_decl, cond, body, break_decl, must_vectorize);
 }
 
 const BlockExprBase* Parser::parse_block_expr() {
@@ -1168,6 +1265,7 @@ const BlockExprBase* Parser::parse_block_expr() {
     while (true) {
         switch (lookahead()) {
             case Token::SEMICOLON: lex(); continue; // ignore semicolon
+            case Token::HASH:      parse_attributes(/*loops*/ true); continue;
             case ITEM:             stmts.emplace_back(parse_item_stmt()); continue;
             case Token::LET:       stmts.emplace_back(parse_let_stmt()); continue;
             case Token::ASM:       stmts.emplace_back(parse_asm_stmt()); continue;
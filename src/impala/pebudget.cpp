@@ -0,0 +1,341 @@
+#include "impala/pebudget.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "thorin/continuation.h"
+#include "thorin/world.h"
+
+#include "impala/ast.h"
+#include "impala/impala.h"
+
+namespace impala {
+
+static std::string name(const std::string& callee) { return callee.empty() ? "@{...}" : callee; }
+
+static std::string key(const thorin::Location& location) {
+    std::ostringstream os;
+    os << (location.filename() != nullptr ? location.filename() : "<unknown>") << ':' << location.front_line() << ':' << location.front_col();
+    return os.str();
+}
+
+bool PEBudget::specialize(const thorin::Location& location, const FnDecl* callee) {
+    auto k = key(location);
+    if (!index_.count(k)) {
+        index_.emplace(k, sites_.size());
+        sites_.push_back({k, location, callee != nullptr ? callee->location() : location, callee != nullptr ? callee->symbol().str() : ""});
+    }
+
+    auto i = residualized_.find(k);
+    if (i == residualized_.end())
+        return true;
+    warning(location, "{}; residualizing instead of specializing", i->second);
+    return false;
+}
+
+void PEBudget::residualize(const std::string& key, std::string reason) {
+    residualized_[key] = std::move(reason);
+}
+
+void PEBudget::count(const thorin::World& world) {
+    for (auto& site : sites_)
+        site.specializations = site.size = 0;
+
+    // copies of a function keep the location of the original - like CostReport, attribute by source range
+    auto attribute = [&] (const thorin::Def* def, bool continuation) {
+        const thorin::Location& location = def->debug();
+        if (location.filename() == nullptr)
+            return;
+        for (auto& site : sites_) {
+            const auto& range = site.range;
+            if (range.filename() == nullptr || std::strcmp(range.filename(), location.filename()) != 0)
+                continue;
+            if (location.front_line() < range.front_line() || location.front_line() > range.back_line())
+                continue;
+            ++site.size;
+            if (continuation && location.front_line() == range.front_line() && location.front_col() == range.front_col())
+                ++site.specializations;
+        }
+    };
+
+    for (auto continuation : world.continuations())
+        attribute(continuation, true);
+    for (auto primop : world.primops())
+        attribute(primop, false);
+    size_ = world.continuations().size() + world.primops().size();
+}
+
+#ifndef _WIN32
+
+/// Time of a trial if -pe-max-time sets none: a runaway specialization must not hang the compiler.
+static const unsigned default_trial_ms = 10000;
+/// All trials together may take this many times as long as one.
+static const unsigned max_trials_factor = 8;
+static const size_t max_trials = 32;
+/// Address space of a trial: a runaway specialization runs out of it rather than out of the machine's memory.
+static const rlim_t trial_memory = rlim_t(4) << 30;
+/// How a trial that ran out of memory exits.
+static const int exit_out_of_memory = 3;
+
+static void write_all(int fd, const std::string& str) {
+    for (size_t done = 0; done != str.size();) {
+        auto n = ::write(fd, str.data() + done, str.size() - done);
+        if (n <= 0)
+            return;
+        done += n;
+    }
+}
+
+/*
+ * The child reports over a pipe, one record per line with tab-separated fields - file names may contain spaces:
+ *     site <key> <callee>                          after emission, in emission order
+ *     measure <key> <specializations> <size>       after optimization
+ *     total <size> <ms>
+ * A child that ran out of time is killed by SIGALRM and never gets to the last two; one that ran out of memory exits with exit_out_of_memory.
+ */
+auto PEBudget::run(const thorin::World& world, const std::function<void()>& emit, const std::function<void()>& optimize, unsigned budget_ms) -> Trial {
+    Trial trial;
+    int fds[2];
+    if (pipe(fds) != 0) {
+        trial.forked = false;
+        return trial;
+    }
+
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+    auto pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        trial.forked = false;
+        return trial;
+    }
+
+    if (pid == 0) {
+        close(fds[0]);
+        std::vector<Diagnostic> diagnostics; // the real compilation reports them
+        session_state().diagnostics = &diagnostics;
+        struct itimerval timer = {};
+        timer.it_value.tv_sec  = budget_ms / 1000;
+        timer.it_value.tv_usec = (budget_ms % 1000) * 1000;
+        setitimer(ITIMER_REAL, &timer, nullptr); // SIGALRM terminates the child
+        struct rlimit memory = { trial_memory, trial_memory };
+        setrlimit(RLIMIT_AS, &memory);
+
+        auto start = std::chrono::steady_clock::now();
+        sites_.clear();
+        index_.clear();
+        std::ostringstream os;
+        try {
+            emit();
+            for (const auto& site : sites_)
+                os << "site\t" << site.key << '\t' << site.callee << '\n';
+            write_all(fds[1], os.str());
+
+            optimize();
+            count(world);
+        } catch (const std::bad_alloc&) {
+            _exit(exit_out_of_memory);
+        }
+        auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        os.str("");
+        for (const auto& site : sites_)
+            os << "measure\t" << site.key << '\t' << site.specializations << '\t' << site.size << '\n';
+        os << "total\t" << size_ << '\t' << ms << '\n';
+        write_all(fds[1], os.str());
+        _exit(0);
+    }
+
+    close(fds[1]);
+    std::string output;
+    char buf[4096];
+    for (ssize_t n; (n = ::read(fds[0], buf, sizeof(buf))) > 0;)
+        output.append(buf, n);
+    close(fds[0]);
+    int status;
+    waitpid(pid, &status, 0);
+    ++num_trials_;
+
+    if (WIFSIGNALED(status) && WTERMSIG(status) == SIGALRM) {
+        std::ostringstream reason;
+        reason << "partial evaluation does not finish within the budget of " << budget_ms << " ms";
+        trial.failure = reason.str();
+    } else if (WIFEXITED(status) && WEXITSTATUS(status) == exit_out_of_memory) {
+        std::ostringstream reason;
+        reason << "partial evaluation needs more than the budget of " << (trial_memory >> 20) << " MiB";
+        trial.failure = reason.str();
+    } else if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        trial.failure = "partial evaluation makes the compiler fail";
+    }
+
+    std::istringstream is(output);
+    std::string line;
+    while (std::getline(is, line)) {
+        std::vector<std::string> fields;
+        std::istringstream record(line);
+        for (std::string field; std::getline(record, field, '\t');)
+            fields.push_back(field);
+
+        if (fields.size() >= 2 && fields[0] == "site") {
+            Site site;
+            site.key = fields[1];
+            site.callee = fields.size() > 2 ? fields[2] : ""; // run blocks have none
+            trial.sites.push_back(site);
+        } else if (fields.size() == 4 && fields[0] == "measure") {
+            auto i = std::find_if(trial.sites.begin(), trial.sites.end(), [&] (const Site& site) { return site.key == fields[1]; });
+            if (i != trial.sites.end()) {
+                i->specializations = std::stoul(fields[2]);
+                i->size = std::stoul(fields[3]);
+            }
+        } else if (fields.size() == 3 && fields[0] == "total") {
+            trial.size = std::stoul(fields[1]);
+            trial.ms = std::stod(fields[2]);
+            trial.finished = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        }
+    }
+    return trial;
+}
+
+void PEBudget::fit(const thorin::World& world, std::function<void()> emit, std::function<void()> optimize) {
+    if (!limits_.any())
+        return;
+
+    auto trial_ms = limits_.max_ms != 0 ? limits_.max_ms : default_trial_ms;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(max_trials_factor * trial_ms);
+
+    // without numbers to go by after a trial failed, the annotations are residualized one at a time until one helps
+    std::vector<std::string> candidates;
+    std::string candidate;
+    bool searching = false;
+    bool all_residualized = false;
+    std::string failure = "partial evaluation does not converge";
+
+    for (size_t attempt = 0; attempt != max_trials; ++attempt) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0)
+            break;
+        auto trial = run(world, emit, optimize, std::min(trial_ms, unsigned(left)));
+        if (!trial.forked) {
+            // what earlier trials decided stands
+            std::cerr << "warning: cannot fork partial evaluation trials; budgets are ignored" << std::endl;
+            return;
+        }
+
+        if (trial.finished && (limits_.max_ms == 0 || trial.ms <= limits_.max_ms)) {
+            candidate.clear();
+            candidates.clear();
+            searching = false;
+
+            bool changed = false;
+            if (limits_.max_specializations != 0) {
+                for (const auto& site : trial.sites) {
+                    if (site.specializations > limits_.max_specializations && !residualized_.count(site.key)) {
+                        std::ostringstream reason;
+                        reason << "partial evaluation leaves " << site.specializations << " copies of '" << name(site.callee)
+                               << "', more than the budget of " << limits_.max_specializations;
+                        residualize(site.key, reason.str());
+                        changed = true;
+                    }
+                }
+            }
+
+            if (!changed && limits_.max_size != 0 && trial.size > limits_.max_size) {
+                const Site* largest = nullptr;
+                for (const auto& site : trial.sites) {
+                    if (!residualized_.count(site.key) && (largest == nullptr || site.size > largest->size))
+                        largest = &site;
+                }
+                if (largest != nullptr) {
+                    std::ostringstream reason;
+                    reason << "partial evaluation leaves a program of " << trial.size << " defs, more than the budget of " << limits_.max_size;
+                    residualize(largest->key, reason.str());
+                    changed = true;
+                }
+            }
+
+            if (!changed)
+                return;
+        } else {
+            failure = trial.failure.empty() ? "partial evaluation does not finish within the budget of " + std::to_string(limits_.max_ms) + " ms" : trial.failure;
+            if (all_residualized)
+                break; // it is not partial evaluation at all
+            if (!candidate.empty())
+                residualized_.erase(candidate); // did not help
+            if (!searching) {
+                searching = true;
+                for (const auto& site : trial.sites) {
+                    if (!residualized_.count(site.key))
+                        candidates.push_back(site.key);
+                }
+            }
+
+            if (candidates.empty()) {
+                if (trial.sites.empty())
+                    break; // no annotation could be to blame
+                // no single annotation is to blame - one more trial tells whether residualizing all of them helps
+                for (const auto& site : trial.sites)
+                    residualize(site.key, failure);
+                candidate.clear();
+                all_residualized = true;
+                continue;
+            }
+
+            candidate = candidates.front();
+            candidates.erase(candidates.begin());
+            residualize(candidate, failure);
+        }
+    }
+
+    // the compilation itself would run away just the same
+    throw std::runtime_error(failure + "; giving up after " + std::to_string(num_trials_) + " trial compilation" + (num_trials_ == 1 ? "" : "s"));
+}
+
+#else
+
+void PEBudget::fit(const thorin::World&, std::function<void()>, std::function<void()>) {
+    if (limits_.any())
+        std::cerr << "warning: partial evaluation budgets need fork() and are ignored on this platform" << std::endl;
+}
+
+#endif
+
+void PEBudget::write(std::ostream& os) const {
+    auto flags = os.flags();
+    os << std::left << std::setw(40) << "annotation" << std::setw(24) << "callee" << std::setw(14) << "specialized"
+       << std::right << std::setw(16) << "specializations" << std::setw(10) << "defs" << std::endl;
+    for (const auto& site : sites_) {
+        os << std::left << std::setw(40) << site.key << std::setw(24) << name(site.callee)
+           << std::setw(14) << (residualized_.count(site.key) ? "residualized" : "yes")
+           << std::right << std::setw(16) << site.specializations << std::setw(10) << site.size << std::endl;
+    }
+    os << "residual program: " << size_ << " defs";
+    if (num_trials_ != 0)
+        os << " after " << num_trials_ << " trial compilation" << (num_trials_ == 1 ? "" : "s");
+    os << std::endl;
+    os.flags(flags);
+}
+
+PEBudgetScope::PEBudgetScope(PEBudget* budget)
+    : prev_(session_state().pe_budget)
+{
+    session_state().pe_budget = budget;
+}
+
+PEBudgetScope::~PEBudgetScope() { session_state().pe_budget = prev_; }
+
+}
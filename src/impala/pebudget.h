@@ -0,0 +1,98 @@
+#ifndef IMPALA_PEBUDGET_H
+#define IMPALA_PEBUDGET_H
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "thorin/util/location.h"
+
+namespace thorin { class World; }
+
+namespace impala {
+
+class FnDecl;
+
+/**
+ * Keeps partial evaluation - @c @ run blocks and @c @f(...) calls - within budgets and reports what it specialized.
+ * A mistaken annotation can make Thorin unroll without bound, so @c fit first emits and optimizes the program in a child process.
+ * Annotations whose specialization exceeds a budget are then residualized - compiled as plain calls - with a warning at the annotation.
+ * Install it in the current @c SessionState via @c PEBudgetScope; emission specializes every annotation otherwise.
+ */
+class PEBudget {
+public:
+    struct Limits {
+        size_t max_specializations = 0; ///< Copies of one function that partial evaluation may leave; 0 means unlimited.
+        size_t max_size = 0;            ///< Thorin defs of the whole optimized program; 0 means unlimited.
+        unsigned max_ms = 0;            ///< Time for emission and optimization; 0 means unlimited.
+
+        bool any() const { return max_specializations != 0 || max_size != 0 || max_ms != 0; }
+    };
+
+    PEBudget(Limits limits)
+        : limits_(limits)
+    {}
+
+    /**
+     * Registers the annotation at @p location and returns whether to specialize it.
+     * @p callee is the annotated function if it is known statically; its source range - or else @p location - is the annotation's code.
+     */
+    bool specialize(const thorin::Location& location, const FnDecl* callee);
+    /**
+     * Finds the annotations to residualize: runs @p emit and then @p optimize on @p world in child processes until all budgets hold.
+     * Neither @p world nor the AST are touched in this process. Does nothing if no limit is set;
+     * if processes cannot be forked, it warns and leaves the annotations specialized that no earlier trial residualized.
+     * Each trial is bounded in time and memory even if no time limit is set, and all of them together in time.
+     * Throws @c std::runtime_error if the program does not fit even with all annotations residualized.
+     */
+    void fit(const thorin::World& world, std::function<void()> emit, std::function<void()> optimize);
+    /// Attributes the continuations and primops of @p world to the annotations registered so far.
+    void count(const thorin::World& world);
+    /// Writes one line per annotation: whether it was specialized, how often and at what size.
+    void write(std::ostream&) const;
+
+private:
+    struct Site {
+        std::string key;
+        thorin::Location location;
+        thorin::Location range;
+        std::string callee;
+        size_t specializations = 0;
+        size_t size = 0;
+    };
+
+    struct Trial {
+        bool forked = true; ///< Whether the child could be started at all.
+        bool finished = false;
+        std::string failure; ///< Why the child did not finish, if it did not.
+        std::vector<Site> sites; ///< In emission order; a child that did not finish only reports keys and callees.
+        size_t size = 0;
+        double ms = 0;
+    };
+
+    Trial run(const thorin::World& world, const std::function<void()>& emit, const std::function<void()>& optimize, unsigned budget_ms);
+    void residualize(const std::string& key, std::string reason);
+
+    Limits limits_;
+    std::vector<Site> sites_;
+    std::unordered_map<std::string, size_t> index_;
+    std::unordered_map<std::string, std::string> residualized_; ///< Annotation key -> the budget it exceeded.
+    size_t size_ = 0;
+    size_t num_trials_ = 0;
+};
+
+/// Installs @p budget - which may be @c nullptr - in the current @c SessionState for the lifetime of the scope.
+class PEBudgetScope {
+public:
+    PEBudgetScope(PEBudget* budget);
+    ~PEBudgetScope();
+
+private:
+    PEBudget* prev_;
+};
+
+}
+
+#endif
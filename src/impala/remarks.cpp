@@ -0,0 +1,128 @@
+#include "impala/remarks.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_set>
+
+#include "thorin/continuation.h"
+#include "thorin/primop.h"
+#include "thorin/type.h"
+#include "thorin/world.h"
+
+#include "impala/impala.h"
+#include "impala/stats.h"
+
+namespace impala {
+
+Remarks::Remarks(const std::string& filter)
+    : filter_(filter)
+{}
+
+void Remarks::add(const char* kind, const thorin::Location& location, std::string function, std::string message) {
+    if (std::regex_match(kind, filter_))
+        remarks_.push_back({kind, location, std::move(function), std::move(message)});
+}
+
+/// The continuation that executes the memory operation @p def: the one whose memory parameter starts its chain of memory operands.
+static const thorin::Continuation* executed_in(const thorin::Def* def) {
+    while (!def->isa<thorin::Param>()) {
+        if (def->num_ops() == 0)
+            return nullptr;
+        def = def->op(0);
+    }
+    return def->as<thorin::Param>()->continuation();
+}
+
+/// Specialized code keeps the location of what it was cloned from, but a block may have none; then the callee's will do.
+static const thorin::Location& where(const thorin::Def* def, const thorin::Def* fallback) {
+    const thorin::Location& location = def->debug();
+    return location.filename() != nullptr || fallback == nullptr ? location : fallback->debug();
+}
+
+void Remarks::analyze(const thorin::World& world) {
+    for (auto continuation : world.continuations()) {
+        if (!continuation->empty()) {
+            auto callee = continuation->callee();
+            if (auto callee_continuation = callee->isa_continuation()) {
+                if (!callee_continuation->is_intrinsic() && !callee_continuation->is_basicblock()) {
+                    for (auto arg : continuation->args()) {
+                        auto fn = arg->isa_continuation();
+                        if (fn != nullptr && !fn->is_basicblock()) {
+                            add("specialize", where(continuation, callee), callee->name(),
+                                "call of '" + callee->name() + "' still passes '" + fn->name() + "' as a function value; annotate it with '@' to specialize it");
+                        }
+                    }
+                }
+            } else if (!callee->type()->as<thorin::FnType>()->is_basicblock()) {
+                // returning through a return continuation is fine, calling an unknown function is not
+                add("specialize", where(continuation, callee), callee->name(),
+                    "call of function value '" + callee->name() + "' whose target is not known at compile time");
+            }
+        }
+
+        if (!continuation->is_basicblock()) {
+            for (auto use : continuation->uses()) {
+                auto user = use->isa_continuation();
+                // intrinsics such as 'parallel' take their body as a closure by design
+                if (user != nullptr && (use.index() == 0 || (user->callee()->isa_continuation() && user->callee()->as_continuation()->is_intrinsic())))
+                    continue;
+                add("closure", continuation->debug(), continuation->name(),
+                    "'" + continuation->name() + "' remains a closure: it is still used as a value at run time");
+                break;
+            }
+        }
+    }
+
+    std::unordered_set<const thorin::Continuation*> in_loop;
+    for (const auto& loop : find_loops(world))
+        in_loop.insert(loop.begin(), loop.end());
+
+    for (auto primop : world.primops()) {
+        if (primop->isa<thorin::Slot>()) {
+            add("mem2reg", primop->debug(), primop->name(),
+                "address-taken local '" + primop->name() + "' stays in a stack slot instead of being promoted to a register");
+        } else if (primop->isa<thorin::Alloc>()) {
+            auto continuation = executed_in(primop);
+            if (continuation != nullptr && in_loop.count(continuation))
+                add("alloc-in-loop", where(primop, continuation), continuation->name(),
+                    "'~' allocation inside a loop; consider allocating once outside of it");
+        }
+    }
+}
+
+void Remarks::write(std::ostream& os, Format format) const {
+    std::vector<const Remark*> remarks;
+    for (const auto& remark : remarks_)
+        remarks.push_back(&remark);
+    std::stable_sort(remarks.begin(), remarks.end(), [] (const Remark* a, const Remark* b) {
+        auto fa = a->location.filename(), fb = b->location.filename();
+        int cmp = std::strcmp(fa != nullptr ? fa : "", fb != nullptr ? fb : "");
+        if (cmp != 0) return cmp < 0;
+        if (a->location.front_line() != b->location.front_line()) return a->location.front_line() < b->location.front_line();
+        return a->location.front_col() < b->location.front_col();
+    });
+
+    if (format == Format::Text) {
+        for (auto remark : remarks) {
+            thorin::streamf(os, "{}: remark: {} [{}]", remark->location, remark->message, remark->kind);
+            os << std::endl;
+        }
+        return;
+    }
+
+    os << "{\"remarks\": [";
+    const char* sep = "\n";
+    for (auto remark : remarks) {
+        auto filename = remark->location.filename();
+        json_quote(os << sep << "    {\"kind\": ", remark->kind);
+        json_quote(os << ", \"file\": ", filename != nullptr ? filename : "")
+            << ", \"line\": " << remark->location.front_line()
+            << ", \"column\": " << remark->location.front_col();
+        json_quote(os << ", \"function\": ", remark->function);
+        json_quote(os << ", \"message\": ", remark->message) << '}';
+        sep = ",\n";
+    }
+    os << "\n]}" << std::endl;
+}
+
+}
@@ -0,0 +1,52 @@
+#ifndef IMPALA_REMARKS_H
+#define IMPALA_REMARKS_H
+
+#include <ostream>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "thorin/util/location.h"
+
+namespace thorin { class World; }
+
+namespace impala {
+
+/**
+ * Optimization remarks in the spirit of Clang's @c -Rpass-missed: what Thorin's partial evaluation and optimization left behind,
+ * reported at the Impala source location it stems from. Each remark has a kind that can be filtered on:
+ *  - @c specialize: a call that still passes a function to another function - higher-order code that was not specialized
+ *  - @c closure: a function that is still used as a value at run time
+ *  - @c mem2reg: an address-taken local that still lives in a stack slot
+ *  - @c alloc-in-loop: a @c ~ allocation that is executed in a loop
+ */
+class Remarks {
+public:
+    enum class Format { Text, JSON };
+
+    struct Remark {
+        const char* kind;
+        thorin::Location location;
+        std::string function; ///< The function the remark is about, if any.
+        std::string message;
+    };
+
+    /// Only remarks whose kind matches @p filter are collected.
+    Remarks(const std::string& filter = ".*");
+
+    /// Inspects @p world - best after @c thorin::World::opt - and collects a remark for everything that was not optimized away.
+    void analyze(const thorin::World& world);
+    const std::vector<Remark>& remarks() const { return remarks_; }
+    /// Writes the remarks sorted by location; @c Format::Text looks like compiler diagnostics.
+    void write(std::ostream&, Format) const;
+
+private:
+    void add(const char* kind, const thorin::Location& location, std::string function, std::string message);
+
+    std::regex filter_;
+    std::vector<Remark> remarks_;
+};
+
+}
+
+#endif
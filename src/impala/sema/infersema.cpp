@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <memory>
 
 #include "thorin/util/array.h"
@@ -5,8 +6,11 @@
 #include "thorin/util/log.h"
 
 #include "impala/ast.h"
+#include "impala/costreport.h"
 #include "impala/impala.h"
-#include "impala/sema/typetable.h"
+#include "impala/intrinsics.h"
+#include "impala/stats.h"
+#include "impala/sema/infersema.h"
 
 using namespace thorin;
 
@@ -14,132 +18,6 @@ namespace impala {
 
 //------------------------------------------------------------------------------
 
-class InferSema : public TypeTable {
-public:
-    // helpers
-
-    const Type* reduce(const Lambda* lambda, ASTTypeArgs ast_type_args, std::vector<const Type*>& type_args);
-    void fill_type_args(std::vector<const Type*>& type_args, const ASTTypes& ast_type_args);
-    const Type* close(int num_lambdas, const Type* body);
-    size_t num_lambdas(const Lambda* lambda);
-
-    // unification related stuff
-
-    /**
-     * Gets the representative of @p type.
-     * Initializes @p type with @p UnknownType if @p type is @c nullptr.
-     */
-    const Type* find_type(const Type*& type);
-    const Type* find_type(const Typeable* typeable) { return find_type(typeable->type_); }
-
-    /**
-     * @c unify(t, u).
-     * Initializes @p t with @p UnknownType if @p type is @c nullptr.
-     */
-    const Type*& constrain(const    Type*& t, const   Type* u);
-    const Type*& constrain(const Typeable* t, const   Type* u, const Type* v) { return constrain(constrain(t, u), v); }
-    const Type*& constrain(const Typeable* t, const   Type* u)                { return constrain(t->type_, u); }
-
-    /// obeys subtyping
-    const Type* coerce(const Type* dst, const Expr* src);
-    const Type* coerce(const Typeable* dst, const Expr* src) { return dst->type_ = coerce(dst->type_, src); }
-    void assign(const Expr* dst, const Expr* src);
-
-    // infer wrappers
-
-    const Type* infer(const LocalDecl* local) {
-        auto type = local->infer(*this);
-        constrain(local, type);
-        return type;
-    }
-    const Type* infer(const Ptrn* p) { return constrain(p, p->infer(*this)); }
-    const Type* infer(const FieldDecl* f) { return constrain(f, f->infer(*this)); }
-    void infer(const Item* n) { n->infer(*this); }
-    const Type* infer_head(const Item* n) {
-        return (n->type_ == nullptr || n->type_->isa<UnknownType>()) ? n->type_ = n->infer_head(*this) : n->type_;
-    }
-    void infer(const Stmt* n) { n->infer(*this); }
-    const Type* infer(const Expr* expr) { return constrain(expr, expr->infer(*this)); }
-    const Type* infer(const Expr* expr, const Type* t) { return constrain(expr, expr->infer(*this), t); }
-
-    const Var* infer(const ASTTypeParam* ast_type_param) {
-        if (!ast_type_param->type())
-            ast_type_param->type_ = ast_type_param->infer(*this);
-        return ast_type_param->type()->as<Var>();
-    }
-
-    const Type* infer(const ASTType* ast_type) {
-        return constrain(ast_type, ast_type->infer(*this));
-    }
-
-    const Type* infer_call(const Expr* lhs, ArrayRef<const Expr*> args, const Type* call_type);
-    const Type* infer_call(const Expr* lhs, const Exprs& args, const Type* call_type) {
-        Array<const Expr*> array(args.size());
-        for (size_t i = 0, e = args.size(); i != e; ++i)
-            array[i] = args[i].get();
-        return infer_call(lhs, array, call_type);
-    }
-
-    const FnType* fn_type(const Type* type) {
-        if (auto tuple_type = type->isa<TupleType>())
-            return TypeTable::fn_type(tuple_type->ops());
-        return TypeTable::fn_type({type});
-    }
-
-    const FnType* fn_type(ArrayRef<const Type*> types) { return fn_type(tuple_type(types)); }
-
-    const Type* rvalue(const Expr* expr) {
-        infer(expr);
-        return expr->type()->isa<RefType>() ? Ref2ValueExpr::create(expr)->type() : expr->type();
-    }
-
-    const Type* wrap_ref(const RefType* ref, const Type* type) {
-        return ref ? ref_type(type, ref->is_mut(), ref->addr_space()) : type;
-    }
-
-private:
-    /// Used for union/find - see https://en.wikipedia.org/wiki/Disjoint-set_data_structure#Disjoint-set_forests .
-    struct Representative {
-        Representative() {}
-        Representative(const Type* type)
-            : parent(this)
-            , type(type)
-        {}
-
-        bool is_root() const { return parent != nullptr; }
-
-        Representative* parent = nullptr;
-        const Type* type = nullptr;
-        int rank = 0;
-    };
-
-    Representative* representative(const Type* type);
-    Representative* find(Representative* repr);
-    const Type* find(const Type* type);
-
-    /// Unifies @p t and @p u.
-    const Type* unify(const Type* t, const Type* u);
-
-    /**
-     * @p x will be the new representative.
-     * Returns again @p x.
-     */
-    Representative* unify(Representative* x, Representative* y);
-
-    /**
-     * Depending on the rank either @p x or @p y will be the new representative.
-     * Returns the new representative.
-     */
-    Representative* unify_by_rank(Representative* x, Representative* y);
-
-    TypeMap<std::unique_ptr<Representative>> representatives_;
-    bool todo_ = true;
-
-    friend void type_inference(Init&, const Module*);
-};
-
-//------------------------------------------------------------------------------
-
 /*
  * helpers
  */
@@ -274,7 +152,8 @@ const Type* InferSema::unify(const Type* dst, const Type* src) {
                 if (src_owned_ptr_type->addr_space() == dst_borrowed_ptr_type->addr_space())
                     return borrowed_ptr_type(unify(dst->op(0), src->op(0)),
                                              dst_borrowed_ptr_type->is_mut(),
-                                             dst_borrowed_ptr_type->addr_space());
+                                             dst_borrowed_ptr_type->addr_space(),
+                                             dst_borrowed_ptr_type->align());
             }
         }
 
@@ -309,6 +188,7 @@ auto InferSema::representative(const Type* type) -> Representative* {
 }
 
 auto InferSema::find(Representative* repr) -> Representative* {
+    ++num_finds_;
     if (repr->parent != repr) {
         todo_ = true;
         repr->parent = find(repr->parent);
@@ -325,6 +205,7 @@ auto InferSema::unify(Representative* x, Representative* y) -> Representative* {
 
     if (x == y)
         return x;
+    ++num_unions_;
     ++x->rank;
     todo_ = true;
     return y->parent = x;
@@ -335,6 +216,7 @@ auto InferSema::unify_by_rank(Representative* x, Representative* y) -> Represent
 
     if (x == y)
         return x;
+    ++num_unions_;
     if (x->rank < y->rank)
         return x->parent = y;
     else if (x->rank > y->rank)
@@ -358,6 +240,10 @@ void type_inference(Init& init, const Module* module) {
     }
 
     DLOG("iterations needed for type inference: {}", i);
+    count("iterations", i);
+    count("union-find finds", sema->num_finds());
+    count("union-find unions", sema->num_unions());
+    count("types", sema->types().size());
 }
 
 //------------------------------------------------------------------------------
@@ -404,9 +290,9 @@ const Type* PrimASTType::infer(InferSema& sema) const {
 const Type* PtrASTType::infer(InferSema& sema) const {
     auto pointee = sema.infer(referenced_ast_type());
     switch (tag()) {
-        case Borrowed: return sema.borrowed_ptr_type(pointee, false, addr_space());
-        case Mut:      return sema.borrowed_ptr_type(pointee,  true, addr_space());
-        case Owned:    return sema.   owned_ptr_type(pointee, addr_space());
+        case Borrowed: return sema.borrowed_ptr_type(pointee, false, addr_space(), align());
+        case Mut:      return sema.borrowed_ptr_type(pointee,  true, addr_space(), align());
+        case Owned:    return sema.   owned_ptr_type(pointee, addr_space(), align());
     }
     THORIN_UNREACHABLE;
 }
@@ -455,7 +341,15 @@ const Type* ASTTypeApp::infer(InferSema& sema) const {
  */
 
 const Type* Module::infer_head(InferSema&) const { /*TODO*/ return nullptr; }
-const Type* ModuleDecl::infer_head(InferSema&) const { /*TODO*/ return nullptr; }
+
+const Type* ModuleDecl::infer_head(InferSema& sema) const {
+    if (owned_module_) {
+        for (const auto& item : owned_module_->items())
+            sema.infer_head(item.get());
+    }
+    return nullptr;
+}
+
 const Type* ExternBlock::infer_head(InferSema&) const { return nullptr; }
 const Type* Typedef::infer_head(InferSema&) const { /*TODO*/ return nullptr; }
 
@@ -478,6 +372,7 @@ const Type* StaticItem::infer_head(InferSema& sema) const {
 }
 
 const Type* FnDecl::infer_head(InferSema& sema) const {
+    CostReport::Timer timer(CostReport::Infer, this);
     infer_ast_type_params(sema);
 
     Array<const Type*> param_types(num_params());
@@ -494,7 +389,11 @@ const Type* ImplItem::infer_head(InferSema&) const { /*TODO*/ return nullptr; }
  * Item::infer
  */
 
-void ModuleDecl::infer(InferSema&) const {
+void ModuleDecl::infer(InferSema& sema) const {
+    if (owned_module_) {
+        for (const auto& item : owned_module_->items())
+            sema.infer(item.get());
+    }
 }
 
 void Module::infer(InferSema& sema) const {
@@ -536,6 +435,7 @@ void StructDecl::infer(InferSema& sema) const {
 const Type* FieldDecl::infer(InferSema& sema) const { return sema.infer(ast_type()); }
 
 void FnDecl::infer(InferSema& sema) const {
+    CostReport::Timer timer(CostReport::Infer, this);
     infer_ast_type_params(sema);
 
     Array<const Type*> param_types(num_params());
@@ -857,6 +757,17 @@ const Type* TypeAppExpr::infer(InferSema& sema) const {
     return sema.find_type(this);
 }
 
+/// The intrinsic that @p callee names, if any.
+static const Intrinsic* called_intrinsic(const Expr* callee) {
+    if (auto type_app = callee->isa<TypeAppExpr>())
+        callee = type_app->lhs();
+    if (auto path = callee->isa<PathExpr>()) {
+        if (auto fn_decl = path->value_decl() != nullptr ? path->value_decl()->isa<FnDecl>() : nullptr)
+            return fn_decl->intrinsic();
+    }
+    return nullptr;
+}
+
 const Type* MapExpr::infer(InferSema& sema) const {
     auto ltype = sema.infer(lhs());
     if (is_ptr(ltype)) {
@@ -894,8 +805,15 @@ const Type* MapExpr::infer(InferSema& sema) const {
         ltype = sema.infer(lhs());
     }
 
-    if (ltype->isa<FnType>())
-        return sema.infer_call(lhs(), args(), sema.find_type(this));
+    if (ltype->isa<FnType>()) {
+        intrinsic_ = called_intrinsic(lhs());
+        auto type = sema.infer_call(lhs(), args(), sema.find_type(this));
+        if (intrinsic_ != nullptr && intrinsic_->infer != nullptr && intrinsic_->takes(num_args())) {
+            if (auto result = intrinsic_->infer(sema, this))
+                return sema.constrain(type, result);
+        }
+        return type;
+    }
 
     return sema.type_error();
 }
@@ -948,6 +866,7 @@ const Type* ForExpr::infer(InferSema& sema) const {
             sema.rvalue(map->arg(i));
 
         if (auto fn_for = ltype->isa<FnType>()) {
+            intrinsic_ = called_intrinsic(map->lhs());
             if (fn_for->num_ops() != 0) {
                 if (auto fn_ret = fn_for->ops().back()->isa<FnType>())
                     sema.constrain(break_decl_.get(), fn_ret); // inherit the type for break
@@ -0,0 +1,144 @@
+#ifndef IMPALA_SEMA_INFERSEMA_H
+#define IMPALA_SEMA_INFERSEMA_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "impala/ast.h"
+#include "impala/sema/typetable.h"
+
+namespace impala {
+
+class InferSema : public TypeTable {
+public:
+    // helpers
+
+    const Type* reduce(const Lambda* lambda, ASTTypeArgs ast_type_args, std::vector<const Type*>& type_args);
+    void fill_type_args(std::vector<const Type*>& type_args, const ASTTypes& ast_type_args);
+    const Type* close(int num_lambdas, const Type* body);
+    size_t num_lambdas(const Lambda* lambda);
+
+    // unification related stuff
+
+    /**
+     * Gets the representative of @p type.
+     * Initializes @p type with @p UnknownType if @p type is @c nullptr.
+     */
+    const Type* find_type(const Type*& type);
+    const Type* find_type(const Typeable* typeable) { return find_type(typeable->type_); }
+
+    /**
+     * @c unify(t, u).
+     * Initializes @p t with @p UnknownType if @p type is @c nullptr.
+     */
+    const Type*& constrain(const    Type*& t, const   Type* u);
+    const Type*& constrain(const Typeable* t, const   Type* u, const Type* v) { return constrain(constrain(t, u), v); }
+    const Type*& constrain(const Typeable* t, const   Type* u)                { return constrain(t->type_, u); }
+
+    /// obeys subtyping
+    const Type* coerce(const Type* dst, const Expr* src);
+    const Type* coerce(const Typeable* dst, const Expr* src) { return dst->type_ = coerce(dst->type_, src); }
+    void assign(const Expr* dst, const Expr* src);
+
+    // infer wrappers
+
+    const Type* infer(const LocalDecl* local) {
+        auto type = local->infer(*this);
+        constrain(local, type);
+        return type;
+    }
+    const Type* infer(const Ptrn* p) { return constrain(p, p->infer(*this)); }
+    const Type* infer(const FieldDecl* f) { return constrain(f, f->infer(*this)); }
+    void infer(const Item* n) { n->infer(*this); }
+    const Type* infer_head(const Item* n) {
+        return (n->type_ == nullptr || n->type_->isa<UnknownType>()) ? n->type_ = n->infer_head(*this) : n->type_;
+    }
+    void infer(const Stmt* n) { n->infer(*this); }
+    const Type* infer(const Expr* expr) { return constrain(expr, expr->infer(*this)); }
+    const Type* infer(const Expr* expr, const Type* t) { return constrain(expr, expr->infer(*this), t); }
+
+    const Var* infer(const ASTTypeParam* ast_type_param) {
+        if (!ast_type_param->type())
+            ast_type_param->type_ = ast_type_param->infer(*this);
+        return ast_type_param->type()->as<Var>();
+    }
+
+    const Type* infer(const ASTType* ast_type) {
+        return constrain(ast_type, ast_type->infer(*this));
+    }
+
+    const Type* infer_call(const Expr* lhs, ArrayRef<const Expr*> args, const Type* call_type);
+    const Type* infer_call(const Expr* lhs, const Exprs& args, const Type* call_type) {
+        Array<const Expr*> array(args.size());
+        for (size_t i = 0, e = args.size(); i != e; ++i)
+            array[i] = args[i].get();
+        return infer_call(lhs, array, call_type);
+    }
+
+    const FnType* fn_type(const Type* type) {
+        if (auto tuple_type = type->isa<TupleType>())
+            return TypeTable::fn_type(tuple_type->ops());
+        return TypeTable::fn_type({type});
+    }
+
+    const FnType* fn_type(ArrayRef<const Type*> types) { return fn_type(tuple_type(types)); }
+
+    const Type* rvalue(const Expr* expr) {
+        infer(expr);
+        return expr->type()->isa<RefType>() ? Ref2ValueExpr::create(expr)->type() : expr->type();
+    }
+
+    const Type* wrap_ref(const RefType* ref, const Type* type) {
+        return ref ? ref_type(type, ref->is_mut(), ref->addr_space()) : type;
+    }
+
+    uint64_t num_finds() const { return num_finds_; }
+    uint64_t num_unions() const { return num_unions_; }
+
+private:
+    /// Used for union/find - see https://en.wikipedia.org/wiki/Disjoint-set_data_structure#Disjoint-set_forests .
+    struct Representative {
+        Representative() {}
+        Representative(const Type* type)
+            : parent(this)
+            , type(type)
+        {}
+
+        bool is_root() const { return parent != nullptr; }
+
+        Representative* parent = nullptr;
+        const Type* type = nullptr;
+        int rank = 0;
+    };
+
+    Representative* representative(const Type* type);
+    Representative* find(Representative* repr);
+    const Type* find(const Type* type);
+
+    /// Unifies @p t and @p u.
+    const Type* unify(const Type* t, const Type* u);
+
+    /**
+     * @p x will be the new representative.
+     * Returns again @p x.
+     */
+    Representative* unify(Representative* x, Representative* y);
+
+    /**
+     * Depending on the rank either @p x or @p y will be the new representative.
+     * Returns the new representative.
+     */
+    Representative* unify_by_rank(Representative* x, Representative* y);
+
+    TypeMap<std::unique_ptr<Representative>> representatives_;
+    bool todo_ = true;
+    uint64_t num_finds_ = 0;
+    uint64_t num_unions_ = 0;
+
+    friend void type_inference(Init&, const Module*);
+};
+
+}
+
+#endif
@@ -1,57 +1,17 @@
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <unordered_map>
+
 #include "impala/ast.h"
 #include "impala/impala.h"
+#include "impala/intrinsics.h"
+#include "impala/sema/namesema.h"
 
 namespace impala {
 
 //------------------------------------------------------------------------------
 
-class NameSema {
-public:
-    /**
-     * Looks up the current definition of \p symbol.
-     * Reports an error at location of \p n if was \p symbol was not found.
-     * @return Returns nullptr on failure.
-     */
-    const Decl* lookup(const ASTNode* n, Symbol);
-
-    /**
-     * Maps \p decl's symbol to \p decl.
-     * If \p decl's symbol already has a definition in the current scope, an error will be emitted.
-     */
-    void insert(const Decl* decl);
-
-    /**
-     * Checks whether there already exists a \p Symbol \p symbol in the \em current scope.
-     * @param symbol The \p Symbol to check.
-     * @return The current mapping if the lookup succeeds, nullptr otherwise.
-     */
-    const Decl* clash(Symbol symbol) const;
-    void push_scope() { levels_.push_back(decl_stack_.size()); } ///< Opens a new scope.
-    void pop_scope();                                            ///< Discards current scope.
-
-    void bind_head(const Item* item) {
-        if (item->is_no_decl()) {
-            if (const auto& extern_block = item->isa<ExternBlock>()) {
-                for (const auto& fn_decl : extern_block->fn_decls())
-                    insert(fn_decl.get());
-            }
-        } else
-            insert(item);
-    }
-
-private:
-    size_t depth() const { return levels_.size(); }
-
-    thorin::HashMap<Symbol, const Decl*> symbol2decl_;
-    std::vector<const Decl*> decl_stack_;
-    std::vector<size_t> levels_;
-
-public: // HACK
-    int lambda_depth_ = 0;
-};
-
-//------------------------------------------------------------------------------
-
 const Decl* NameSema::lookup(const ASTNode* n, Symbol symbol) {
     assert(!symbol.empty() && "symbol is empty");
 
@@ -94,6 +54,35 @@ const Decl* NameSema::clash(Symbol symbol) const {
     return nullptr;
 }
 
+const Module* NameSema::load(const ModuleDecl* module_decl) {
+    if (module_decl->module_ != nullptr)
+        return module_decl->module_;
+
+    auto filename = module_decl->filename();
+    auto& first = (*loaded_)[filename];
+    if (first != nullptr)
+        return module_decl->module_ = first->module_;
+
+    std::ifstream stream(filename);
+    if (!stream) {
+        loaded_->erase(filename);
+        error(module_decl, "cannot open file '{}' for module '{}'", filename, module_decl->symbol());
+        return nullptr;
+    }
+
+    // register before binding so that modules referring back to this one find it
+    first = module_decl;
+    module_decl->loaded_filename_ = filename;
+    Items items;
+    parse(items, stream, module_decl->loaded_filename_.c_str());
+    module_decl->owned_module_ = std::make_unique<const Module>(module_decl->loaded_filename_.c_str(), std::move(items));
+    module_decl->module_ = module_decl->owned_module_.get();
+
+    NameSema sema(loaded_);
+    module_decl->module_->bind(sema);
+    return module_decl->module_;
+}
+
 void NameSema::pop_scope() {
     size_t level = levels_.back();
     for (size_t i = level, e = decl_stack_.size(); i != e; ++i) {
@@ -176,14 +165,18 @@ void FnASTType::bind(NameSema& sema) const {
  * items
  */
 
-void ModuleDecl::bind(NameSema& ) const {}
+void ModuleDecl::bind(NameSema&) const {} // loaded lazily by Path::bind
 
 void Module::bind(NameSema& sema) const {
     sema.push_scope();
     for (const auto& item : items()) {
         sema.bind_head(item.get());
-        if (item->is_named_decl())
+        if (!item->is_no_decl()) {
             symbol2item_[item->symbol()] = item.get();
+        } else if (auto extern_block = item->isa<ExternBlock>()) {
+            for (const auto& fn_decl : extern_block->fn_decls())
+                symbol2item_[fn_decl->symbol()] = fn_decl.get();
+        }
     }
     for (const auto& item : items())
         item->bind(sema);
@@ -228,6 +221,18 @@ void Fn::fn_bind(NameSema& sema) const {
 
 void FnDecl::bind(NameSema& sema) const {
     fn_bind(sema);
+
+    if (is_extern() && abi() == "\"thorin\"") {
+        auto name = fn_symbol().remove_quotation();
+        intrinsic_ = find_intrinsic(name);
+        auto num = num_params();
+        if (num != 0 && param(num - 1)->symbol() == "return")
+            --num;
+        if (intrinsic_ == nullptr)
+            error(identifier(), "unknown intrinsic '{}'", name);
+        else if (!intrinsic_->matches(num_ast_type_params(), num))
+            error(identifier(), "intrinsic '{}' must be declared as '{}'", name, intrinsic_->signature);
+    }
 }
 
 void StructDecl::bind(NameSema& sema) const {
@@ -300,9 +305,37 @@ void Path::Elem::bind(NameSema& sema) const {
     decl_ = sema.lookup(this, symbol());
 }
 
+void Path::Elem::bind(const Module* module, Symbol module_symbol) const {
+    auto item = thorin::find(module->symbol2item(), symbol());
+    if (item == nullptr)
+        error(this, "'{}' not found in module '{}'", symbol(), module_symbol);
+    else if (!item->visibility().is_pub())
+        error(this, "'{}' is private to module '{}'", symbol(), module_symbol);
+    else
+        decl_ = item;
+}
+
 void Path::bind(NameSema& sema) const {
-    for (const auto& elem : elems())
-        elem->bind(sema);
+    elems().front()->bind(sema);
+
+    // all but the last element must name a module
+    for (size_t i = 1, e = elems().size(); i != e; ++i) {
+        auto decl = elems()[i-1]->decl();
+        if (decl == nullptr)
+            return;
+
+        const Module* module = nullptr;
+        if (auto module_decl = decl->isa<ModuleDecl>())
+            module = sema.load(module_decl);
+        else if (auto inline_module = decl->isa<Module>())
+            module = inline_module;
+        else
+            error(elems()[i-1].get(), "'{}' is not a module", decl->symbol());
+
+        if (module == nullptr)
+            return;
+        elems()[i]->bind(module, decl->symbol());
+    }
 }
 
 void PathExpr::bind(NameSema& sema) const {
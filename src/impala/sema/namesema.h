@@ -0,0 +1,75 @@
+#ifndef IMPALA_SEMA_NAMESEMA_H
+#define IMPALA_SEMA_NAMESEMA_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "impala/ast.h"
+
+namespace impala {
+
+class NameSema {
+public:
+    /// Maps the file name of each loaded module to its first @p ModuleDecl; shared with the @p NameSema%s of all loaded modules.
+    typedef std::unordered_map<std::string, const ModuleDecl*> Loaded;
+
+    NameSema(std::shared_ptr<Loaded> loaded = std::make_shared<Loaded>())
+        : loaded_(loaded)
+    {}
+
+    /**
+     * Looks up the current definition of \p symbol.
+     * Reports an error at location of \p n if was \p symbol was not found.
+     * @return Returns nullptr on failure.
+     */
+    const Decl* lookup(const ASTNode* n, Symbol);
+
+    /**
+     * Maps \p decl's symbol to \p decl.
+     * If \p decl's symbol already has a definition in the current scope, an error will be emitted.
+     */
+    void insert(const Decl* decl);
+
+    /**
+     * Checks whether there already exists a \p Symbol \p symbol in the \em current scope.
+     * @param symbol The \p Symbol to check.
+     * @return The current mapping if the lookup succeeds, nullptr otherwise.
+     */
+    const Decl* clash(Symbol symbol) const;
+
+    /**
+     * Loads, parses and binds the file \p module_decl refers to - at most once per compilation.
+     * @return Returns nullptr if the file cannot be read.
+     */
+    const Module* load(const ModuleDecl* module_decl);
+
+    void push_scope() { levels_.push_back(decl_stack_.size()); } ///< Opens a new scope.
+    void pop_scope();                                            ///< Discards current scope.
+
+    void bind_head(const Item* item) {
+        if (item->is_no_decl()) {
+            if (const auto& extern_block = item->isa<ExternBlock>()) {
+                for (const auto& fn_decl : extern_block->fn_decls())
+                    insert(fn_decl.get());
+            }
+        } else
+            insert(item);
+    }
+
+private:
+    size_t depth() const { return levels_.size(); }
+
+    thorin::HashMap<Symbol, const Decl*> symbol2decl_;
+    std::vector<const Decl*> decl_stack_;
+    std::vector<size_t> levels_;
+    std::shared_ptr<Loaded> loaded_;
+
+public: // HACK
+    int lambda_depth_ = 0;
+};
+
+}
+
+#endif
@@ -57,6 +57,9 @@ const Type* FnType::return_type() const {
     return typetable().type_noret();
 }
 
+/// Whether a pointer of type @p src may stand for one of type @p dst: it must promise no less alignment.
+static bool is_aligned_for(const RefTypeBase* dst, const RefTypeBase* src) { return dst->align() <= src->align(); }
+
 bool is_subtype(const Type* dst, const Type* src) {
     assert(dst->is_known() && src->is_known());
 
@@ -66,9 +69,11 @@ bool is_subtype(const Type* dst, const Type* src) {
     if (auto dst_borrowed_ptr_type = dst->isa<BorrowedPtrType>()) {
         if (auto src_owned_ptr_type = src->isa<OwnedPtrType>()) {
             return src_owned_ptr_type->addr_space() == dst_borrowed_ptr_type->addr_space()
+                && is_aligned_for(dst_borrowed_ptr_type, src_owned_ptr_type)
                 && is_subtype(dst_borrowed_ptr_type->pointee(), src_owned_ptr_type->pointee());
         } else if (auto src_borrowed_ptr_type = src->isa<BorrowedPtrType>()) {
             return src_borrowed_ptr_type->addr_space() == dst_borrowed_ptr_type->addr_space()
+                && is_aligned_for(dst_borrowed_ptr_type, src_borrowed_ptr_type)
                 && (src_borrowed_ptr_type->is_mut() || !dst_borrowed_ptr_type->is_mut())
                 && is_subtype(dst_borrowed_ptr_type->pointee(), src_borrowed_ptr_type->pointee());
         }
@@ -87,7 +92,8 @@ bool is_subtype(const Type* dst, const Type* src) {
             result &= src->as<SimdType>()->dim() == dst_simd_type->dim();
         else if (auto dst_ref_type = dst->isa<RefTypeBase>())
             result &=  src->as<RefTypeBase>()->is_mut() == dst_ref_type->is_mut()
-                    && src->as<RefTypeBase>()->addr_space() == dst_ref_type->addr_space();
+                    && src->as<RefTypeBase>()->addr_space() == dst_ref_type->addr_space()
+                    && is_aligned_for(dst_ref_type, src->as<RefTypeBase>());
 
         if (auto dst_fn = dst->isa<FnType>()) {
             auto ret = dst_fn->return_type();
@@ -120,7 +126,7 @@ bool is_strict_subtype(const Type* dst, const Type* src) {
  */
 
 uint64_t RefTypeBase::vhash() const {
-    return thorin::hash_combine(Type::vhash(), ((uint64_t)addr_space() << 1) | uint64_t(is_mut()));
+    return thorin::hash_combine(Type::vhash(), ((uint64_t)align() << 32) | ((uint64_t)addr_space() << 1) | uint64_t(is_mut()));
 }
 
 //------------------------------------------------------------------------------
@@ -132,7 +138,8 @@ uint64_t RefTypeBase::vhash() const {
 bool RefTypeBase::equal(const Type* other) const {
     return Type::equal(other)
         && this->is_mut() == other->as<RefTypeBase>()->is_mut()
-        && this->addr_space() == other->as<RefTypeBase>()->addr_space();
+        && this->addr_space() == other->as<RefTypeBase>()->addr_space()
+        && this->align() == other->as<RefTypeBase>()->align();
 }
 
 bool UnknownType::equal(const Type* other) const { return this == other; }
@@ -177,6 +184,8 @@ std::ostream& RefTypeBase::stream(std::ostream& os) const {
     os << prefix();
     if (addr_space() != 0)
         os << '[' << addr_space() << ']';
+    if (align() != 0)
+        os << "#[align(" << align() << ")] ";
     return os << pointee();
 }
 
@@ -205,8 +214,8 @@ const Type* FnType             ::vrebuild(TypeTable& to, Types ops) const { retu
 const Type* DefiniteArrayType  ::vrebuild(TypeTable& to, Types ops) const { return to.  definite_array_type(ops[0], dim()); }
 const Type* SimdType           ::vrebuild(TypeTable& to, Types ops) const { return to.            simd_type(ops[0], dim()); }
 const Type* IndefiniteArrayType::vrebuild(TypeTable& to, Types ops) const { return to.indefinite_array_type(ops[0]); }
-const Type* BorrowedPtrType    ::vrebuild(TypeTable& to, Types ops) const { return to.borrowed_ptr_type(ops[0], is_mut(), addr_space()); }
-const Type* OwnedPtrType       ::vrebuild(TypeTable& to, Types ops) const { return to.   owned_ptr_type(ops[0], addr_space()); }
+const Type* BorrowedPtrType    ::vrebuild(TypeTable& to, Types ops) const { return to.borrowed_ptr_type(ops[0], is_mut(), addr_space(), align()); }
+const Type* OwnedPtrType       ::vrebuild(TypeTable& to, Types ops) const { return to.   owned_ptr_type(ops[0], addr_space(), align()); }
 const Type* RefType            ::vrebuild(TypeTable& to, Types ops) const { return to.      ref_type(ops[0], is_mut(), addr_space()); }
 const Type* InferError         ::vrebuild(TypeTable& to, Types ops) const { return to.infer_error(ops[0], ops[1]); }
 const Type* NoRetType          ::vrebuild(TypeTable&,    Types    ) const { return this; }
@@ -232,11 +241,11 @@ const Type* IndefiniteArrayType::vreduce(int depth, const Type* type, Type2Type&
 }
 
 const Type* BorrowedPtrType::vreduce(int depth, const Type* type, Type2Type& map) const {
-    return typetable().borrowed_ptr_type(pointee()->reduce(depth, type, map), is_mut(), addr_space());
+    return typetable().borrowed_ptr_type(pointee()->reduce(depth, type, map), is_mut(), addr_space(), align());
 }
 
 const Type* OwnedPtrType::vreduce(int depth, const Type* type, Type2Type& map) const {
-    return typetable().owned_ptr_type(pointee()->reduce(depth, type, map), addr_space());
+    return typetable().owned_ptr_type(pointee()->reduce(depth, type, map), addr_space(), align());
 }
 
 const Type* RefType::vreduce(int depth, const Type* type, Type2Type& map) const {
@@ -93,16 +93,19 @@ bool is_strict_subtype(const Type* dst, const Type* src);
 /// Common base Type for PtrType%s and RefType.
 class RefTypeBase : public Type {
 protected:
-    RefTypeBase(TypeTable& typetable, int tag, const Type* pointee, bool mut, int addr_space)
+    RefTypeBase(TypeTable& typetable, int tag, const Type* pointee, bool mut, int addr_space, int align)
         : Type(typetable, tag, {pointee})
         , mut_(mut)
         , addr_space_(addr_space)
+        , align_(align)
     {}
 
 public:
     const Type* pointee() const { return op(0); }
     bool is_mut() const { return mut_; }
     int addr_space() const { return addr_space_; }
+    /// What @c pointee is known to be aligned to beyond its natural alignment, or 0.
+    int align() const { return align_; }
 
     virtual std::ostream& stream(std::ostream&) const override;
     virtual uint64_t vhash() const override;
@@ -112,6 +115,7 @@ public:
 private:
     bool mut_;
     int addr_space_;
+    int align_;
 
     friend class TypeTable;
 };
@@ -119,8 +123,8 @@ private:
 /// Pointer @p Type.
 class PtrType : public RefTypeBase {
 protected:
-    PtrType(TypeTable& typetable, int tag, const Type* pointee, bool mut, int addr_space)
-        : RefTypeBase(typetable, tag, pointee, mut, addr_space)
+    PtrType(TypeTable& typetable, int tag, const Type* pointee, bool mut, int addr_space, int align)
+        : RefTypeBase(typetable, tag, pointee, mut, addr_space, align)
     {}
 
     std::ostream& stream_ptr_type(std::ostream&, std::string prefix, int addr_space, const Type* ref_type) const;
@@ -133,8 +137,8 @@ private:
 
 class BorrowedPtrType : public PtrType {
 public:
-    BorrowedPtrType(TypeTable& typetable, const Type* pointee, bool mut, int addr_space)
-        : PtrType(typetable, Tag_borrowed_ptr, pointee, mut, addr_space)
+    BorrowedPtrType(TypeTable& typetable, const Type* pointee, bool mut, int addr_space, int align)
+        : PtrType(typetable, Tag_borrowed_ptr, pointee, mut, addr_space, align)
     {}
 
     virtual std::string prefix() const override { return is_mut() ? "&mut " : "&"; }
@@ -146,8 +150,8 @@ private:
 
 class OwnedPtrType : public PtrType {
 public:
-    OwnedPtrType(TypeTable& typetable, const Type* pointee, int addr_space)
-        : PtrType(typetable, Tag_owned_ptr, pointee, true, addr_space)
+    OwnedPtrType(TypeTable& typetable, const Type* pointee, int addr_space, int align)
+        : PtrType(typetable, Tag_owned_ptr, pointee, true, addr_space, align)
     {}
 
     virtual std::string prefix() const override { return "~"; }
@@ -160,7 +164,7 @@ private:
 class RefType : public RefTypeBase {
 protected:
     RefType(TypeTable& typetable, const Type* pointee, bool mut, int addr_space)
-        : RefTypeBase(typetable, Tag_ref, pointee, mut, addr_space)
+        : RefTypeBase(typetable, Tag_ref, pointee, mut, addr_space, /*align*/ 0)
     {}
 
 public:
@@ -1,7 +1,12 @@
+#include <algorithm>
 #include <sstream>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "impala/ast.h"
+#include "impala/costreport.h"
 #include "impala/impala.h"
+#include "impala/intrinsics.h"
 #include "impala/sema/typetable.h"
 
 using namespace thorin;
@@ -54,6 +59,8 @@ public:
 
     template<typename... Args>
     const Type* expect_lvalue(const Expr* expr, const char* fmt, Args... args) {
+        if (vectorized_loop_ != nullptr)
+            vectorized_loop_->writes.push_back(expr);
         std::ostringstream os;
         thorin::streamf(os, fmt, args...);
         if (auto ref = is_lvalue(expr->type()))
@@ -99,18 +106,41 @@ public:
             array[i] = args[i].get();
         check_call(expr, array);
     }
+    void check_borrows(const Expr* callee, const FnType* fn_type, ArrayRef<const Expr*> args);
+    void reach(const Decl* decl);
+    void finish_borrows();
 
 private:
     bool nossa_;
 
 public:
+    /// What the body of a @c for loop over @c vectorize accesses; see @c ForExpr::check.
+    struct VectorizedLoop {
+        std::vector<const Expr*> writes;    ///< Assigned or borrowed as <tt>&mut</tt>.
+        std::vector<const MapExpr*> reads;  ///< Array and simd subscripts.
+    };
+
     const BlockExprBase* cur_block_ = nullptr;
     const Fn* cur_fn_ = nullptr;
+    VectorizedLoop* vectorized_loop_ = nullptr;
+    std::unordered_map<const LocalDecl*, const Expr*> pointer_lets_; ///< Immutable pointers and what they are bound to.
+
+    /// What a function - closures in it included - reaches besides its parameters; see @c finish_borrows.
+    struct Reach {
+        std::vector<const FnDecl*> fns; ///< Named, whether called or used as values.
+        bool unknown = false;           ///< Mutable statics, or code that cannot be followed.
+    };
+
+    const FnDecl* cur_fn_decl_ = nullptr;
+    std::unordered_map<const FnDecl*, Reach> reach_;
+    std::vector<const PathExpr*> fn_paths_;          ///< Paths to functions.
+    std::unordered_set<const Expr*> direct_callees_; ///< Those of them that are called right away.
 };
 
 void type_analysis(const Module* module, bool nossa) {
     TypeSema sema(nossa);
     sema.check(module);
+    sema.finish_borrows();
 }
 
 template<class T>
@@ -207,7 +237,9 @@ const Type* Fn::check_body(TypeSema& sema) const {
  * items
  */
 
-void ModuleDecl::check(TypeSema&) const {
+void ModuleDecl::check(TypeSema& sema) const {
+    if (owned_module_)
+        sema.check(owned_module_.get());
 }
 
 void Module::check(TypeSema& sema) const {
@@ -243,10 +275,16 @@ void StructDecl::check(TypeSema& sema) const {
 void FieldDecl::check(TypeSema& sema) const { sema.check(ast_type()); }
 
 void FnDecl::check(TypeSema& sema) const {
+    CostReport::Timer timer(CostReport::Check, this);
     THORIN_PUSH(sema.cur_fn_, this);
+    THORIN_PUSH(sema.cur_fn_decl_, this);
     check_ast_type_params(sema);
-    for (const auto& param : params())
-        sema.check(param.get());
+    auto& reach = sema.reach_[this];
+    for (const auto& param : params()) {
+        // a function it is passed may come from anywhere
+        if (sema.check(param.get())->isa<FnType>())
+            reach.unknown = true;
+    }
 
     if (body() != nullptr)
         check_body(sema);
@@ -309,7 +347,10 @@ void PathExpr::check(TypeSema& sema) const {
             // if local lies in an outer function go through memory to implement closure
             if (local->is_mut() && (sema.nossa() || local->fn() != sema.cur_fn_))
                 local->take_address();
+        } else if (value_decl()->isa<FnDecl>()) {
+            sema.fn_paths_.push_back(this);
         }
+        sema.reach(value_decl());
     }
 }
 
@@ -579,10 +620,22 @@ void MapExpr::check(TypeSema& sema) const {
     for (const auto& arg : args())
         sema.check(arg.get());
 
-    if (ltype->isa<FnType>())
-        return sema.check_call(lhs(), args());
+    // e.g. a path that did not resolve - already reported
+    if (ltype->isa<TypeError>())
+        return;
+
+    if (ltype->isa<FnType>()) {
+        sema.check_call(lhs(), args());
+
+        // a mismatch with the declaration is already reported
+        if (intrinsic_ != nullptr && intrinsic_->check != nullptr && intrinsic_->takes(num_args()))
+            intrinsic_->check(this);
+        return;
+    }
 
     if (ltype->isa<ArrayType>()) {
+        if (sema.vectorized_loop_ != nullptr)
+            sema.vectorized_loop_->reads.push_back(this);
         if (num_args() == 1)
             sema.expect_int(arg(0), "for array subscript");
         else
@@ -609,6 +662,7 @@ void TypeSema::check_call(const Expr* expr, ArrayRef<const Expr*> args) {
     if (fn_type->num_ops() == args.size() || fn_type->num_ops() == args.size() + 1) {
         for (size_t i = 0; i < args.size(); i++)
             expect_type(fn_type->op(i), args[i], "argument type");
+        check_borrows(expr, fn_type, args);
     } else
         error(expr, "incorrect number of arguments in function application: got {}, expected {}",
               args.size(), fn_type->num_ops() > 0 ? fn_type->num_ops() - 1 : 0);
@@ -648,6 +702,445 @@ void WhileExpr::check(TypeSema& sema) const {
         sema.expect_unit(body(), "body type in a while-expression");
 }
 
+/// Where an access goes: the variable it starts from - @c nullptr if unknown - and the innermost subscript on the way, if any.
+struct Access {
+    const Decl* root = nullptr;
+    const Expr* index = nullptr;
+};
+
+static const Expr* strip_implicit_casts(const Expr* expr) {
+    while (expr->isa<Ref2ValueExpr>() || expr->isa<ImplicitCastExpr>())
+        expr = expr->as<CastExpr>()->src();
+    return expr;
+}
+
+static Access access(const Expr* expr) {
+    Access result;
+    while (true) {
+        expr = strip_implicit_casts(expr);
+        if (auto map = expr->isa<MapExpr>()) {
+            auto ltype = unpack_ref_type(map->lhs()->type());
+            if (ltype->isa<ArrayType>() && map->num_args() == 1)
+                result.index = map->arg(0);
+            else if (!ltype->isa<TupleType>())
+                return Access();
+            expr = map->lhs();
+        } else if (auto field = expr->isa<FieldExpr>()) {
+            expr = field->lhs();
+        } else if (expr->isa<PrefixExpr>() && expr->as<PrefixExpr>()->tag() == PrefixExpr::MUL) {
+            expr = expr->as<PrefixExpr>()->rhs();
+        } else if (auto path = expr->isa<PathExpr>()) {
+            result.root = path->value_decl();
+            return result;
+        } else {
+            return Access();
+        }
+    }
+}
+
+static bool contains(const Location& outer, const Location& inner) {
+    auto before = [] (unsigned line1, unsigned col1, unsigned line2, unsigned col2) { return line1 < line2 || (line1 == line2 && col1 < col2); };
+    return !before(inner.front_line(), inner.front_col(), outer.front_line(), outer.front_col())
+        && !before(outer.back_line(), outer.back_col(), inner.front_line(), inner.front_col());
+}
+
+/**
+ * Rejects a dependency between the iterations of a loop over @c vectorize, whose lanes run in no particular order:
+ * a variable from outside the loop may only be written through a subscript with the loop index,
+ * and an array written that way may only be read at that index.
+ * Variables declared in the body are private to each iteration.
+ */
+static void check_independent(const FnExpr* body, const TypeSema::VectorizedLoop& loop) {
+    const Decl* var = body->num_params() > 1 ? body->param(0) : nullptr;
+    auto is_var = [&] (const Expr* index) {
+        auto path = strip_implicit_casts(index)->isa<PathExpr>();
+        return var != nullptr && path != nullptr && path->value_decl() == var;
+    };
+
+    std::vector<const Decl*> stored;
+    for (auto write : loop.writes) {
+        auto target = access(write);
+        if (target.root == nullptr || contains(body->location(), target.root->location()))
+            continue;
+        if (target.index == nullptr)
+            error(write, "'{}' is written in every iteration of a vectorized loop; iterations must not depend on each other", target.root->symbol());
+        else if (!is_var(target.index))
+            error(target.index, "a vectorized loop may only store to '{}' at its loop index; other elements may belong to other iterations", target.root->symbol());
+        else
+            stored.push_back(target.root);
+    }
+
+    for (auto read : loop.reads) {
+        if (std::find(loop.writes.begin(), loop.writes.end(), read) != loop.writes.end())
+            continue;
+        auto source = access(read);
+        if (source.root != nullptr && source.index != nullptr && !is_var(source.index)
+                && std::find(stored.begin(), stored.end(), source.root) != stored.end())
+            error(source.index, "'{}' is stored to in this vectorized loop, so it may only be read at the loop index", source.root->symbol());
+    }
+}
+
+/// The values of a loop over @c vectorize that vary with its index: the index itself and the variables of its body.
+struct Lanes {
+    const Decl* index = nullptr;
+    std::unordered_set<const Decl*> vars;
+
+    bool contain(const Decl* decl) const { return decl != nullptr && (decl == index || vars.count(decl) != 0); }
+};
+
+static bool check_lanes(const Lanes&, const Expr*);
+
+/// Whether @p expr is the loop index plus or minus values that do not vary with it: consecutive lanes access consecutive elements.
+static bool is_lane_index(const Lanes& lanes, const Expr* expr) {
+    expr = strip_implicit_casts(expr);
+    if (auto path = expr->isa<PathExpr>())
+        return lanes.index != nullptr && path->value_decl() == lanes.index;
+    if (auto infix = expr->isa<InfixExpr>()) {
+        if (infix->tag() == InfixExpr::ADD && !check_lanes(lanes, infix->lhs()))
+            return is_lane_index(lanes, infix->rhs());
+        if (infix->tag() == InfixExpr::ADD || infix->tag() == InfixExpr::SUB)
+            return !check_lanes(lanes, infix->rhs()) && is_lane_index(lanes, infix->lhs());
+    }
+    return false;
+}
+
+/// Whether @p map subscripts an array of numbers behind a pointer, which simd vectors of the lanes can be loaded from and stored to.
+static bool is_lane_array(const MapExpr* map) {
+    auto deref = strip_implicit_casts(map->lhs())->isa<PrefixExpr>();
+    auto elem_type = unpack_ref_type(map->type());
+    return deref != nullptr && deref->tag() == PrefixExpr::MUL && elem_type->isa<PrimType>() && !is_bool(elem_type);
+}
+
+/**
+ * Whether @p expr varies with the index of a loop over @c vectorize; reports what cannot run on simd vectors of its lanes.
+ * What varies is a number or a boolean computed with arithmetic, comparisons and casts from the lanes and from loads of arrays at the loop index;
+ * what does not is emitted once for all lanes, but must not have side effects either.
+ */
+static bool check_lanes(const Lanes& lanes, const Expr* expr) {
+    if (expr->isa<LiteralExpr>() || expr->isa<CharExpr>())
+        return false;
+    if (auto path = expr->isa<PathExpr>())
+        return lanes.contain(path->value_decl());
+    if (auto cast = expr->isa<CastExpr>()) {
+        bool varies = check_lanes(lanes, cast->src());
+        if (varies && !cast->isa<Ref2ValueExpr>() && !(cast->src()->type()->isa<PrimType>() && cast->type()->isa<PrimType>()))
+            error(cast, "a vectorized loop can only cast numbers and booleans that vary with its index");
+        return varies;
+    }
+    if (auto prefix = expr->isa<PrefixExpr>()) {
+        switch (prefix->tag()) {
+            case PrefixExpr::ADD:
+            case PrefixExpr::SUB:
+            case PrefixExpr::NOT:
+            case PrefixExpr::MUL:
+                return check_lanes(lanes, prefix->rhs());
+            default:
+                break;
+        }
+    } else if (auto infix = expr->isa<InfixExpr>()) {
+        if (!Token::is_assign((TokenTag) infix->tag())) {
+            bool lhs = check_lanes(lanes, infix->lhs());
+            bool rhs = check_lanes(lanes, infix->rhs());
+            bool and_and = infix->tag() == InfixExpr::ANDAND;
+            if ((lhs || rhs) && (and_and || infix->tag() == InfixExpr::OROR))
+                error(infix, "'{}' cannot short-circuit the lanes of a vectorized loop; use '{}'", and_and ? "&&" : "||", and_and ? "&" : "|");
+            return lhs || rhs;
+        }
+    } else if (auto map = expr->isa<MapExpr>()) {
+        auto ltype = unpack_ref_type(map->lhs()->type());
+        if (ltype->isa<FnType>()) {
+            error(map, "a vectorized loop cannot call functions; its body runs on simd vectors of its lanes");
+            return false;
+        }
+        bool lhs = check_lanes(lanes, map->lhs());
+        bool args = false;
+        for (const auto& arg : map->args())
+            args |= check_lanes(lanes, arg.get());
+        if (!lhs && !args)
+            return false;
+        if (lhs || !ltype->isa<ArrayType>())
+            error(map, "a vectorized loop can only compute numbers and booleans from its loop index with arithmetic, comparisons and casts");
+        else if (!is_lane_array(map))
+            error(map, "a vectorized loop can only load and store arrays of numbers behind pointers, not '{}'", ltype);
+        else if (!is_lane_index(lanes, map->arg(0)))
+            error(map->arg(0), "a vectorized loop can only access arrays at its loop index plus or minus values that do not vary with it");
+        return true;
+    } else if (auto field = expr->isa<FieldExpr>()) {
+        if (check_lanes(lanes, field->lhs()))
+            error(field, "a vectorized loop can only compute numbers and booleans from its loop index with arithmetic, comparisons and casts");
+        return false;
+    }
+
+    error(expr, "a vectorized loop cannot run this on simd vectors of its lanes");
+    return false;
+}
+
+/// Checks a statement of the body of a loop over @c vectorize, or its final expression: it may only assign to a variable or to an array element.
+static void check_lane_stmt(const Lanes& lanes, const Expr* expr) {
+    if (expr->isa<EmptyExpr>())
+        return;
+    auto infix = expr->isa<InfixExpr>();
+    if (infix != nullptr && Token::is_assign((TokenTag) infix->tag())) {
+        auto target = infix->lhs();
+        if (auto map = target->isa<MapExpr>()) {
+            // whether the subscript is the loop index is up to check_independent
+            if (!unpack_ref_type(map->lhs()->type())->isa<ArrayType>() || !is_lane_array(map))
+                error(map, "a vectorized loop can only load and store arrays of numbers behind pointers, not '{}'", unpack_ref_type(map->lhs()->type()));
+            else
+                check_lanes(lanes, map);
+        } else if (!target->isa<PathExpr>()) {
+            error(target, "a vectorized loop can only assign to its variables and store to arrays at its loop index");
+        }
+        check_lanes(lanes, infix->rhs());
+        return;
+    }
+    error(expr, "a vectorized loop can only declare variables, assign to them and store to arrays at its loop index");
+}
+
+/**
+ * Rejects a body of a loop over @c vectorize that cannot run on simd vectors of its lanes; see @c emit_vectorized.
+ * It may declare variables of number or boolean type, assign to them and store to arrays at the loop index.
+ */
+static void check_lanes(const FnExpr* body) {
+    Lanes lanes;
+    lanes.index = body->num_params() > 1 ? body->param(0) : nullptr;
+
+    auto expr = body->body();
+    if (auto block = expr->isa<BlockExprBase>()) {
+        for (const auto& stmt : block->stmts()) {
+            if (auto let = stmt->isa<LetStmt>()) {
+                auto id_ptrn = let->ptrn()->isa<IdPtrn>();
+                if (id_ptrn == nullptr || !let->ptrn()->type()->isa<PrimType>())
+                    error(let, "a vectorized loop can only declare variables of number or boolean type, not '{}'", let->ptrn()->type());
+                if (let->init())
+                    check_lanes(lanes, let->init());
+                if (id_ptrn != nullptr)
+                    lanes.vars.insert(id_ptrn->local());
+            } else if (auto expr_stmt = stmt->isa<ExprStmt>()) {
+                check_lane_stmt(lanes, expr_stmt->expr());
+            } else {
+                error(stmt.get(), "a vectorized loop can only declare variables, assign to them and store to arrays at its loop index");
+            }
+        }
+        expr = block->expr();
+    }
+    check_lane_stmt(lanes, expr);
+}
+
+/**
+ * The memory a pointer points to as far as it can be traced:
+ * the variable it lies in - @c nullptr if unknown - and the fields and subscripts taken from that variable, outermost first.
+ */
+struct Place {
+    const Decl* root = nullptr;
+    std::vector<const Expr*> path;
+};
+
+typedef std::unordered_map<const LocalDecl*, const Expr*> PointerLets;
+
+static Place lvalue_place(const PointerLets&, const Expr*);
+
+static Place pointee_place(const PointerLets& lets, const Expr* ptr) {
+    while (auto cast = ptr->isa<CastExpr>())
+        ptr = cast->src();
+
+    if (auto prefix = ptr->isa<PrefixExpr>()) {
+        if (prefix->tag() == PrefixExpr::AND || prefix->tag() == PrefixExpr::MUT)
+            return lvalue_place(lets, prefix->rhs());
+    } else if (auto path = ptr->isa<PathExpr>()) {
+        if (auto local = path->value_decl() ? path->value_decl()->isa<LocalDecl>() : nullptr) {
+            auto i = lets.find(local);
+            if (i != lets.end())
+                return pointee_place(lets, i->second);
+        }
+        // any other pointer variable stands for the memory it points to
+        Place result;
+        result.root = path->value_decl();
+        return result;
+    }
+    return Place();
+}
+
+static Place lvalue_place(const PointerLets& lets, const Expr* expr) {
+    expr = strip_implicit_casts(expr);
+    if (auto map = expr->isa<MapExpr>()) {
+        auto ltype = unpack_ref_type(map->lhs()->type());
+        if ((ltype->isa<ArrayType>() || ltype->isa<TupleType>()) && map->num_args() == 1) {
+            auto result = lvalue_place(lets, map->lhs());
+            result.path.push_back(map);
+            return result;
+        }
+    } else if (auto field = expr->isa<FieldExpr>()) {
+        auto result = lvalue_place(lets, field->lhs());
+        result.path.push_back(field);
+        return result;
+    } else if (expr->isa<PrefixExpr>() && expr->as<PrefixExpr>()->tag() == PrefixExpr::MUL) {
+        return pointee_place(lets, expr->as<PrefixExpr>()->rhs());
+    } else if (auto path = expr->isa<PathExpr>()) {
+        Place result;
+        result.root = path->value_decl();
+        return result;
+    }
+    return Place();
+}
+
+/// Whether two subscripts certainly denote the same element: equal literals or the same immutable variable.
+static bool same_index(const Expr* index1, const Expr* index2) {
+    index1 = strip_implicit_casts(index1);
+    index2 = strip_implicit_casts(index2);
+    auto lit1 = index1->isa<LiteralExpr>(), lit2 = index2->isa<LiteralExpr>();
+    if (lit1 != nullptr && lit2 != nullptr)
+        return lit1->get_u64() == lit2->get_u64();
+    auto path1 = index1->isa<PathExpr>(), path2 = index2->isa<PathExpr>();
+    return path1 != nullptr && path2 != nullptr && path1->value_decl() != nullptr
+        && path1->value_decl() == path2->value_decl() && !path1->value_decl()->is_mut();
+}
+
+/// Whether @p place1 and @p place2 certainly share memory; places that cannot be told apart are assumed to be distinct.
+static bool overlap(const Place& place1, const Place& place2) {
+    if (place1.root == nullptr || place1.root != place2.root)
+        return false;
+    for (size_t i = 0, e = std::min(place1.path.size(), place2.path.size()); i != e; ++i) {
+        auto step1 = place1.path[i], step2 = place2.path[i];
+        auto field1 = step1->isa<FieldExpr>(), field2 = step2->isa<FieldExpr>();
+        if (field1 != nullptr && field2 != nullptr) {
+            if (field1->index() != field2->index())
+                return false;
+        } else if (field1 != nullptr || field2 != nullptr
+                || !same_index(step1->as<MapExpr>()->arg(0), step2->as<MapExpr>()->arg(0))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Whether @p decl is the memory itself rather than a pointer to memory elsewhere.
+static bool is_storage(const Decl* decl) {
+    return (decl->isa<LocalDecl>() || decl->isa<StaticItem>()) && !unpack_ref_type(decl->type())->isa<PtrType>();
+}
+
+/// Whether @p place1 and @p place2 certainly do not share memory - the opposite of @c overlap: places that cannot be told apart may share it.
+static bool disjoint(const Place& place1, const Place& place2) {
+    if (place1.root == nullptr || place2.root == nullptr)
+        return false;
+    if (place1.root != place2.root)
+        return is_storage(place1.root) && is_storage(place2.root);
+    for (size_t i = 0, e = std::min(place1.path.size(), place2.path.size()); i != e; ++i) {
+        auto step1 = place1.path[i], step2 = place2.path[i];
+        auto field1 = step1->isa<FieldExpr>(), field2 = step2->isa<FieldExpr>();
+        if (field1 != nullptr && field2 != nullptr) {
+            if (field1->index() != field2->index())
+                return true;
+            continue;
+        }
+        if (field1 != nullptr || field2 != nullptr)
+            return false;
+        auto index1 = strip_implicit_casts(step1->as<MapExpr>()->arg(0)), index2 = strip_implicit_casts(step2->as<MapExpr>()->arg(0));
+        auto lit1 = index1->isa<LiteralExpr>(), lit2 = index2->isa<LiteralExpr>();
+        if (lit1 != nullptr && lit2 != nullptr && lit1->get_u64() != lit2->get_u64())
+            return true;
+        if (!same_index(index1, index2))
+            return false;
+    }
+    return false; // one lies within the other
+}
+
+static bool is_exclusive(const Type* type) {
+    auto ptr = type->isa<PtrType>();
+    return ptr != nullptr && (ptr->is_mut() || ptr->isa<OwnedPtrType>());
+}
+
+/**
+ * A callee may assume that a <tt>&mut</tt> or @c ~ argument is the only way to its memory while the call lasts.
+ * Rejects a call that passes another pointer into that memory alongside it.
+ * Unless every other argument is plain data or a pointer that certainly points elsewhere, the parameter of a named callee loses @c Param::is_exclusive.
+ */
+void TypeSema::check_borrows(const Expr* callee, const FnType* fn_type, ArrayRef<const Expr*> args) {
+    auto path = callee->isa<PathExpr>();
+    auto fn_decl = path != nullptr && path->value_decl() != nullptr ? path->value_decl()->isa<FnDecl>() : nullptr;
+    if (fn_decl != nullptr)
+        direct_callees_.insert(callee);
+    else if (cur_fn_decl_ != nullptr && path == nullptr)
+        reach_[cur_fn_decl_].unknown = true;
+
+    std::vector<Place> places;
+    for (auto arg : args)
+        places.push_back(unpack_ref_type(arg->type())->isa<PtrType>() ? pointee_place(pointer_lets_, arg) : Place());
+
+    for (size_t j = 1; j < args.size(); ++j) {
+        for (size_t i = 0; i != j; ++i) {
+            if ((is_exclusive(fn_type->op(i)) || is_exclusive(fn_type->op(j))) && overlap(places[i], places[j])) {
+                error(args[j], "arguments {} and {} overlap, but a mutable borrow must be the only way to its memory during the call", i + 1, j + 1);
+                break;
+            }
+        }
+    }
+
+    if (fn_decl == nullptr || fn_decl->num_params() < args.size())
+        return;
+    for (size_t i = 0; i != args.size(); ++i) {
+        if (!is_exclusive(fn_type->op(i)))
+            continue;
+        for (size_t j = 0; j != args.size(); ++j) {
+            auto type = unpack_ref_type(args[j]->type());
+            bool plain = type->isa<PrimType>() || type->isa<SimdType>();
+            if (j != i && !plain && !(type->isa<PtrType>() && disjoint(places[i], places[j]))) {
+                fn_decl->param(i)->is_exclusive_ = false;
+                break;
+            }
+        }
+    }
+}
+
+/// Notes that the current function names @p decl.
+void TypeSema::reach(const Decl* decl) {
+    if (cur_fn_decl_ == nullptr)
+        return;
+    auto& reach = reach_[cur_fn_decl_];
+    if (auto fn_decl = decl->isa<FnDecl>())
+        reach.fns.push_back(fn_decl);
+    else if (decl->isa<StaticItem>() && (decl->is_mut() || decl->type()->isa<FnType>()))
+        reach.unknown = true; // another pointer to the parameter's memory, or a function that could reach one
+}
+
+/**
+ * Takes @c Param::is_exclusive from all parameters of a function that is used as a value - its calls are not checked -
+ * or that may reach a mutable static: the parameter may point into it.
+ */
+void TypeSema::finish_borrows() {
+    std::unordered_set<const FnDecl*> lost;
+    for (auto path : fn_paths_) {
+        if (!direct_callees_.count(path))
+            lost.insert(path->value_decl()->as<FnDecl>());
+    }
+
+    std::unordered_set<const FnDecl*> unknown;
+    for (const auto& p : reach_) {
+        if (p.second.unknown)
+            unknown.insert(p.first);
+    }
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (const auto& p : reach_) {
+            if (unknown.count(p.first))
+                continue;
+            for (auto fn_decl : p.second.fns) {
+                if (unknown.count(fn_decl)) {
+                    unknown.insert(p.first);
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+    lost.insert(unknown.begin(), unknown.end());
+
+    for (auto fn_decl : lost) {
+        for (const auto& param : fn_decl->params())
+            param->is_exclusive_ = false;
+    }
+}
+
 void ForExpr::check(TypeSema& sema) const {
     auto forexpr = expr();
     if (auto prefix = forexpr->isa<PrefixExpr>())
@@ -658,7 +1151,21 @@ void ForExpr::check(TypeSema& sema) const {
         auto ltype = sema.check(map->lhs());
         for (const auto& arg : map->args())
             sema.check(arg.get());
+
+        // nested loops count as part of the vectorized one
+        static const Intrinsic* vectorize = find_intrinsic("vectorize");
+        auto errors = num_errors();
+        bool vectorized = intrinsic_ != nullptr && intrinsic_ == vectorize;
+        TypeSema::VectorizedLoop loop;
+        auto outer = sema.vectorized_loop_;
+        if (vectorized)
+            sema.vectorized_loop_ = &loop;
         sema.check(fn_expr());
+        sema.vectorized_loop_ = outer;
+        if (vectorized && outer != nullptr) {
+            outer->writes.insert(outer->writes.end(), loop.writes.begin(), loop.writes.end());
+            outer->reads.insert(outer->reads.end(), loop.reads.begin(), loop.reads.end());
+        }
 
         if (auto fn_for = ltype->isa<FnType>()) {
             if (fn_for->num_ops() != 0) {
@@ -670,6 +1177,14 @@ void ForExpr::check(TypeSema& sema) const {
                         args[i] = map->arg(i);
                     args.back() = fn_expr();
                     sema.check_call(map->lhs(), args);
+
+                    if (vectorized) {
+                        intrinsic_->check(map);
+                        check_independent(fn_expr(), loop);
+                        // the body is only worth a look once it is well-typed and its iterations are independent
+                        if (num_errors() == errors)
+                            check_lanes(fn_expr());
+                    }
                     return;
                 }
             }
@@ -724,6 +1239,11 @@ void LetStmt::check(TypeSema& sema) const {
             error(this, "cannot infer type for let initializer");
         else if (!is_subtype(init_type, type))
             error(this, "let pattern type does not match initializer type, got '{}' and '{}'", type, init_type);
+
+        // an immutable pointer stands for what it is bound to; see check_borrows
+        auto id_ptrn = ptrn()->isa<IdPtrn>();
+        if (id_ptrn && !id_ptrn->local()->is_mut() && init_type->isa<PtrType>())
+            sema.pointer_lets_[id_ptrn->local()] = init();
     } else {
         auto id_ptrn = ptrn()->isa<IdPtrn>();
         // Ptrns and non-mutable variables need an initialization
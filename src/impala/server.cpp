@@ -0,0 +1,183 @@
+#include "impala/server.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <csignal>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "impala/wire.h"
+#endif
+
+#include "impala/impala.h"
+
+namespace impala {
+
+#ifndef _WIN32
+
+//------------------------------------------------------------------------------
+
+const std::string& SourceCache::get(const std::string& filename) {
+    char buf[PATH_MAX];
+    std::string key = realpath(filename.c_str(), buf) ? buf : filename;
+
+    struct stat st;
+    if (stat(key.c_str(), &st) != 0) {
+        entries_.erase(key);
+        static const std::string empty;
+        return empty; // the parser reports the missing input like an empty stream
+    }
+
+#ifdef __APPLE__
+    auto mtime = int64_t(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    auto mtime = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    auto& entry = entries_[key];
+    if (entry.mtime != mtime || entry.size != int64_t(st.st_size)) {
+        std::ifstream file(key, std::ios::binary);
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        entry.contents = contents.str();
+        entry.mtime = mtime;
+        entry.size  = st.st_size;
+    }
+
+    return entry.contents;
+}
+
+//------------------------------------------------------------------------------
+
+static bool read_request(int fd, std::vector<std::string>& strings) {
+    uint32_t num;
+    if (!read_all(fd, &num, sizeof(num)))
+        return false;
+
+    for (uint32_t i = 0, e = ntohl(num); i != e; ++i) {
+        std::string str;
+        char c;
+        while (true) {
+            if (!read_all(fd, &c, 1))
+                return false;
+            if (c == '\0')
+                break;
+            str.push_back(c);
+        }
+        strings.emplace_back(std::move(str));
+    }
+
+    return !strings.empty();
+}
+
+static bool write_response(int fd, int status, const std::string& out, const std::string& err) {
+    auto write_u32 = [&] (uint32_t u) { u = htonl(u); return write_all(fd, &u, sizeof(u)); };
+    return write_u32(uint32_t(status))
+        && write_u32(uint32_t(out.size())) && write_all(fd, out.data(), out.size())
+        && write_u32(uint32_t(err.size())) && write_all(fd, err.data(), err.size());
+}
+
+/// Runs @p args as if invoked from @p cwd and captures everything written to @c std::cout and @c std::cerr.
+static int run_request(const std::string& cwd, std::vector<std::string>& args, CompileFn compile, SourceCache& cache,
+                       std::ostringstream& out, std::ostringstream& err) {
+    char old_cwd[PATH_MAX];
+    if (getcwd(old_cwd, sizeof(old_cwd)) == nullptr || chdir(cwd.c_str()) != 0) {
+        err << "cannot change into directory '" << cwd << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<char*> argv;
+    for (auto& arg : args)
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    SessionState state;
+    SessionScope scope(state);
+    auto cout_buf = std::cout.rdbuf(out.rdbuf());
+    auto cerr_buf = std::cerr.rdbuf(err.rdbuf());
+    int status = compile(int(args.size()), argv.data(), &cache);
+    std::cout.flush();
+    std::cerr.flush();
+    std::cout.rdbuf(cout_buf);
+    std::cerr.rdbuf(cerr_buf);
+
+    if (chdir(old_cwd) != 0)
+        std::cerr << "cannot change back into directory '" << old_cwd << "'" << std::endl;
+    return status;
+}
+
+int serve(const std::string& socket_path, CompileFn compile) {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path))
+        throw std::invalid_argument("socket path '" + socket_path + "' is too long");
+    std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0)
+        throw std::runtime_error("cannot create socket");
+    unlink(socket_path.c_str());
+    if (bind(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(sock, SOMAXCONN) != 0) {
+        close(sock);
+        throw std::runtime_error("cannot listen on socket '" + socket_path + "'");
+    }
+
+    // a client that disconnects early must not take the server down with it
+    signal(SIGPIPE, SIG_IGN);
+    init();
+    SourceCache cache;
+    std::cerr << "impala: serving on " << socket_path << std::endl;
+
+    bool shutdown = false;
+    while (!shutdown) {
+        int conn = accept(sock, nullptr, nullptr);
+        if (conn < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        std::vector<std::string> strings;
+        if (read_request(conn, strings)) {
+            auto cwd = strings.front();
+            std::vector<std::string> args(strings.begin() + 1, strings.end());
+            std::ostringstream out, err;
+            int status = EXIT_SUCCESS;
+
+            if (args.size() == 2 && (args[1] == "-shutdown" || args[1] == "--shutdown"))
+                shutdown = true;
+            else if (args.empty())
+                status = EXIT_FAILURE;
+            else
+                status = run_request(cwd, args, compile, cache, out, err);
+
+            write_response(conn, status, out.str(), err.str());
+        }
+        close(conn);
+    }
+
+    close(sock);
+    unlink(socket_path.c_str());
+    return EXIT_SUCCESS;
+}
+
+#else // _WIN32
+
+const std::string& SourceCache::get(const std::string&) { throw std::logic_error("server mode requires Unix sockets"); }
+int serve(const std::string&, CompileFn) { throw std::logic_error("server mode requires Unix sockets"); }
+
+#endif // _WIN32
+
+}
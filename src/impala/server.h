@@ -0,0 +1,44 @@
+#ifndef IMPALA_SERVER_H
+#define IMPALA_SERVER_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace impala {
+
+/**
+ * Keeps the contents of source files in memory across compile requests.
+ * A file is only read again from disk if its size or modification time - to the nanosecond - changed.
+ */
+class SourceCache {
+public:
+    const std::string& get(const std::string& filename);
+    size_t size() const { return entries_.size(); }
+
+private:
+    struct Entry {
+        int64_t mtime = -1; ///< In nanoseconds.
+        int64_t size  = -1;
+        std::string contents;
+    };
+
+    std::unordered_map<std::string, Entry> entries_;
+};
+
+/// The driver entry point: @c argv as on the command line; @p cache is the server's @c SourceCache.
+typedef int (*CompileFn)(int argc, char** argv, SourceCache* cache);
+
+/**
+ * Listens on the Unix socket @p socket_path and runs @p compile for each request of @c impala-client.
+ * The process-wide front-end tables are set up once; every request gets a fresh @c Init (@c World + @c TypeTable).
+ * Returns once a client sends @c -shutdown.
+ *
+ * Wire format - request: <tt>u32 n</tt> followed by @c n NUL-terminated strings (working directory, then argv);
+ * response: <tt>i32 status, u32 len, stdout, u32 len, stderr</tt>; all integers in network byte order.
+ */
+int serve(const std::string& socket_path, CompileFn compile);
+
+}
+
+#endif
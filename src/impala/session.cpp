@@ -0,0 +1,36 @@
+#include "impala/session.h"
+
+#include <sstream>
+#include <stdexcept>
+
+#include "impala/ast.h"
+
+namespace impala {
+
+CompilerSession::CompilerSession(std::string module_name)
+    : init_(std::move(module_name), /*resident*/ true)
+{
+    state_.diagnostics = &diagnostics_;
+}
+
+bool CompilerSession::compile(const std::string& source, std::string filename, bool nossa) {
+    if (module_ != nullptr)
+        throw std::logic_error("compiler session already compiled a module");
+
+    SessionScope scope(state_);
+    filename_ = std::move(filename);
+
+    Items items;
+    std::istringstream stream(source);
+    parse(items, stream, filename_.c_str());
+    module_ = std::make_unique<const Module>(filename_.c_str(), std::move(items));
+
+    check(init_, module_.get(), nossa);
+    if (num_errors() != 0)
+        return false;
+
+    emit(init_.world, module_.get());
+    return num_errors() == 0;
+}
+
+}
@@ -0,0 +1,47 @@
+#ifndef IMPALA_SESSION_H
+#define IMPALA_SESSION_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "impala/impala.h"
+
+namespace impala {
+
+/**
+ * A self-contained compilation from an in-memory buffer to a @c thorin::World.
+ * The session owns the @c World, the @c TypeTable and all diagnostics; nothing is written to @c std::cerr.
+ * Distinct sessions may be used concurrently from different threads; a single session must not be shared.
+ *
+ * @attention Thorin's @c Log is still process-wide and should stay at @c Log::Error when running sessions concurrently.
+ */
+class CompilerSession {
+public:
+    CompilerSession(std::string module_name);
+
+    /**
+     * Parses, checks and emits @p source; @p filename is only used in diagnostics.
+     * A session compiles exactly one module.
+     * Returns @c true if no errors occurred - @c world() is then ready for @c cleanup(), @c opt() and a back end.
+     */
+    bool compile(const std::string& source, std::string filename, bool nossa = false);
+
+    thorin::World& world() { return init_.world; }
+    const Module* module() const { return module_.get(); }
+    const std::vector<Diagnostic>& diagnostics() const { return diagnostics_; }
+    int num_warnings() const { return state_.num_warnings; }
+    int num_errors() const { return state_.num_errors; }
+    bool& fancy() { return state_.fancy; }
+
+private:
+    Init init_;
+    SessionState state_;
+    std::vector<Diagnostic> diagnostics_;
+    std::string filename_; ///< Locations point into this string.
+    std::unique_ptr<const Module> module_;
+};
+
+}
+
+#endif
@@ -0,0 +1,330 @@
+#include "impala/stats.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <map>
+#include <typeinfo>
+#include <unordered_map>
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "thorin/continuation.h"
+#include "thorin/world.h"
+
+#include "impala/ast.h"
+#include "impala/impala.h"
+
+namespace impala {
+
+std::atomic<uint64_t> num_allocations(0);
+
+Stats::Stats()
+    : start_(std::chrono::steady_clock::now())
+{}
+
+auto Stats::sample() -> Sample {
+    Sample result;
+    result.wall = std::chrono::steady_clock::now();
+    result.cpu_ms = 1000.0 * double(std::clock()) / CLOCKS_PER_SEC;
+#ifndef _WIN32
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    result.rss_kb = usage.ru_maxrss / 1024; // bytes on macOS
+#else
+    result.rss_kb = usage.ru_maxrss;
+#endif
+#else
+    result.rss_kb = 0;
+#endif
+    result.allocations = num_allocations.load(std::memory_order_relaxed);
+    return result;
+}
+
+void Stats::begin(const char* name) {
+    phases_.emplace_back();
+    phases_.back().name = name;
+    running_.emplace_back(phases_.size() - 1, sample());
+}
+
+static std::string class_name(const ASTNode* node) {
+    const char* mangled = typeid(*node).name();
+#ifdef __GNUG__
+    int status;
+    if (auto demangled = abi::__cxa_demangle(mangled, nullptr, nullptr, &status)) {
+        std::string name(demangled);
+        std::free(demangled);
+        auto colon = name.rfind("::");
+        return colon == std::string::npos ? name : name.substr(colon + 2);
+    }
+#endif
+    return mangled;
+}
+
+void Stats::end() {
+    assert(!running_.empty());
+    auto index = running_.back().first;
+    auto before = running_.back().second;
+    auto after = sample();
+    running_.pop_back();
+
+    // nodes are complete by now, so typeid sees the dynamic class
+    std::map<std::string, uint64_t> classes;
+    for (auto node : ast_nodes_)
+        ++classes[class_name(node)];
+    ast_nodes_.clear();
+
+    auto& phase = phases_[index];
+    phase.start_us    = std::chrono::duration<double, std::micro>(before.wall - start_).count();
+    phase.wall_ms     = std::chrono::duration<double, std::milli>(after.wall - before.wall).count();
+    phase.cpu_ms      = after.cpu_ms - before.cpu_ms;
+    phase.rss_kb      = after.rss_kb - before.rss_kb;
+    phase.allocations = after.allocations - before.allocations;
+    for (const auto& p : classes)
+        phase.counters.emplace_back("ast." + p.first, p.second);
+}
+
+auto Stats::current() -> Phase& {
+    if (!running_.empty())
+        return phases_[running_.back().first];
+    if (phases_.empty())
+        begin("<unnamed>"), end();
+    return phases_.back();
+}
+
+void Stats::count(const std::string& name, uint64_t n) {
+    auto& counters = current().counters;
+    auto i = std::find_if(counters.begin(), counters.end(), [&] (const std::pair<std::string, uint64_t>& p) { return p.first == name; });
+    if (i == counters.end())
+        counters.emplace_back(name, n);
+    else
+        i->second += n;
+}
+
+std::vector<std::vector<const thorin::Continuation*>> find_loops(const thorin::World& world) {
+    struct Info { unsigned index, lowlink; bool on_stack; };
+    struct Frame { thorin::Continuation* continuation; thorin::Continuations succs; size_t next; };
+
+    std::unordered_map<const thorin::Continuation*, Info> infos;
+    std::vector<const thorin::Continuation*> stack;
+    std::vector<Frame> frames; // Tarjan's algorithm without recursion, as worlds before cleanup can be deep
+    unsigned counter = 0;
+    std::vector<std::vector<const thorin::Continuation*>> loops;
+
+    auto push = [&] (thorin::Continuation* continuation) {
+        infos[continuation] = {counter, counter, true};
+        ++counter;
+        stack.push_back(continuation);
+        frames.push_back({continuation, continuation->succs(), 0});
+    };
+
+    for (auto root : world.continuations()) {
+        if (infos.count(root))
+            continue;
+
+        push(root);
+        while (!frames.empty()) {
+            auto& frame = frames.back();
+            if (frame.next != frame.succs.size()) {
+                auto succ = frame.succs[frame.next++];
+                auto i = infos.find(succ);
+                if (i == infos.end())
+                    push(succ);
+                else if (i->second.on_stack)
+                    infos[frame.continuation].lowlink = std::min(infos[frame.continuation].lowlink, i->second.index);
+                continue;
+            }
+
+            auto continuation = frame.continuation;
+            bool self_loop = std::find(frame.succs.begin(), frame.succs.end(), continuation) != frame.succs.end();
+            frames.pop_back();
+            auto info = infos[continuation];
+            if (!frames.empty()) {
+                auto& parent = infos[frames.back().continuation];
+                parent.lowlink = std::min(parent.lowlink, info.lowlink);
+            }
+
+            if (info.lowlink == info.index) {
+                std::vector<const thorin::Continuation*> scc;
+                const thorin::Continuation* member;
+                do {
+                    member = stack.back();
+                    stack.pop_back();
+                    infos[member].on_stack = false;
+                    scc.push_back(member);
+                } while (member != continuation);
+                if (scc.size() > 1 || self_loop)
+                    loops.push_back(std::move(scc));
+            }
+        }
+    }
+
+    return loops;
+}
+
+void Stats::count(const thorin::World& world) {
+    count("continuations", world.continuations().size());
+    count("primops", world.primops().size());
+
+    // what is left of the program: calls that were not inlined or specialized and functions that are still passed around as values
+    uint64_t calls = 0, closures = 0;
+    for (auto continuation : world.continuations()) {
+        if (!continuation->empty()) {
+            if (auto callee = continuation->callee()->isa_continuation()) {
+                if (!callee->is_intrinsic() && !callee->is_basicblock())
+                    ++calls;
+            }
+        }
+        if (!continuation->is_basicblock()) {
+            for (auto use : continuation->uses()) {
+                if (use.index() != 0 || !use->isa_continuation()) {
+                    ++closures;
+                    break;
+                }
+            }
+        }
+    }
+    count("calls", calls);
+    count("closures", closures);
+    count("loops", find_loops(world).size());
+}
+
+void Stats::write(std::ostream& os, Format format, bool counters) const {
+    switch (format) {
+        case Format::Text:  write_text (os, counters); break;
+        case Format::JSON:  write_json (os, counters); break;
+        case Format::Trace: write_trace(os, counters); break;
+    }
+}
+
+void Stats::write_text(std::ostream& os, bool counters) const {
+    Phase total;
+    total.name = "total";
+    for (const auto& phase : phases_) {
+        total.wall_ms     += phase.wall_ms;
+        total.cpu_ms      += phase.cpu_ms;
+        total.rss_kb      += phase.rss_kb;
+        total.allocations += phase.allocations;
+    }
+
+    auto flags = os.flags();
+    auto precision = os.precision();
+    auto line = [&] (const Phase& phase) {
+        os << std::left << std::setw(16) << phase.name << std::right << std::fixed << std::setprecision(3)
+           << std::setw(12) << phase.wall_ms
+           << std::setw(12) << phase.cpu_ms
+           << std::setw(12) << phase.rss_kb
+           << std::setw(12) << phase.allocations << std::endl;
+    };
+
+    os << std::left << std::setw(16) << "phase" << std::right
+       << std::setw(12) << "wall ms" << std::setw(12) << "cpu ms" << std::setw(12) << "rss KiB" << std::setw(12) << "allocs" << std::endl;
+    for (const auto& phase : phases_) {
+        line(phase);
+        if (counters) {
+            for (const auto& counter : phase.counters)
+                os << "    " << std::left << std::setw(24) << counter.first << std::right << std::setw(12) << counter.second << std::endl;
+        }
+    }
+    line(total);
+    os.flags(flags);
+    os.precision(precision);
+}
+
+std::ostream& json_quote(std::ostream& os, const std::string& str) {
+    static const char* hex = "0123456789abcdef";
+    os << '"';
+    for (char c : str) {
+        auto u = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\')
+            os << '\\' << c;
+        else if (u < 0x20)
+            os << "\\u00" << hex[u >> 4] << hex[u & 15];
+        else
+            os << c;
+    }
+    return os << '"';
+}
+
+static void write_counters(std::ostream& os, const Stats::Phase& phase) {
+    os << '{';
+    const char* sep = "";
+    for (const auto& counter : phase.counters) {
+        json_quote(os << sep, counter.first) << ": " << counter.second;
+        sep = ", ";
+    }
+    os << '}';
+}
+
+void Stats::write_json(std::ostream& os, bool counters) const {
+    os << "{\"phases\": [";
+    const char* sep = "\n";
+    for (const auto& phase : phases_) {
+        json_quote(os << sep << "    {\"name\": ", phase.name)
+            << ", \"wall_ms\": " << phase.wall_ms
+            << ", \"cpu_ms\": " << phase.cpu_ms
+            << ", \"rss_delta_kb\": " << phase.rss_kb
+            << ", \"allocations\": " << phase.allocations;
+        if (counters)
+            write_counters(os << ", \"counters\": ", phase);
+        os << '}';
+        sep = ",\n";
+    }
+    os << "\n]}" << std::endl;
+}
+
+/// See the "Trace Event Format" of Chrome's about:tracing; phases become complete events ("ph": "X") on a single thread.
+void Stats::write_trace(std::ostream& os, bool counters) const {
+    os << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    const char* sep = "\n";
+    for (const auto& phase : phases_) {
+        json_quote(os << sep << "    {\"name\": ", phase.name)
+            << ", \"cat\": \"impala\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1"
+            << ", \"ts\": " << phase.start_us
+            << ", \"dur\": " << 1000.0 * phase.wall_ms
+            << ", \"args\": {\"cpu_ms\": " << phase.cpu_ms
+            << ", \"rss_delta_kb\": " << phase.rss_kb
+            << ", \"allocations\": " << phase.allocations;
+        if (counters)
+            write_counters(os << ", \"counters\": ", phase);
+        os << "}}";
+        sep = ",\n";
+    }
+    os << "\n]}" << std::endl;
+}
+
+StatsScope::StatsScope(Stats* stats)
+    : prev_(session_state().stats)
+{
+    session_state().stats = stats;
+}
+
+StatsScope::~StatsScope() { session_state().stats = prev_; }
+
+PhaseTimer::PhaseTimer(const char* name)
+    : stats_(session_state().stats)
+{
+    if (stats_ != nullptr)
+        stats_->begin(name);
+}
+
+PhaseTimer::~PhaseTimer() {
+    if (stats_ != nullptr)
+        stats_->end();
+}
+
+void count(const std::string& name, uint64_t n) {
+    if (auto stats = session_state().stats)
+        stats->count(name, n);
+}
+
+}
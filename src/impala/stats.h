@@ -0,0 +1,111 @@
+#ifndef IMPALA_STATS_H
+#define IMPALA_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace thorin { class Continuation; class World; }
+
+namespace impala {
+
+class ASTNode;
+
+/**
+ * Number of calls to the global <tt>operator new</tt> so far.
+ * Only counts if the executable replaces <tt>operator new</tt> and bumps this counter - as impala's driver does.
+ */
+extern std::atomic<uint64_t> num_allocations;
+
+/**
+ * Collects wall time, CPU time, peak RSS growth and allocations per compiler phase, together with counters such as tokens or AST nodes.
+ * Install it in the current @c SessionState via @c StatsScope; @c PhaseTimer and @c count are no-ops otherwise.
+ */
+class Stats {
+public:
+    enum class Format { Text, JSON, Trace };
+
+    struct Phase {
+        std::string name;
+        double start_us = 0;   ///< Relative to the construction of the @c Stats.
+        double wall_ms = 0;
+        double cpu_ms = 0;
+        int64_t rss_kb = 0;    ///< Growth of the peak resident set size.
+        uint64_t allocations = 0;
+        std::vector<std::pair<std::string, uint64_t>> counters;
+    };
+
+    Stats();
+
+    void begin(const char* name);
+    void end();
+    /// Adds @p n to counter @p name of the innermost running - or else the last finished - phase.
+    void count(const std::string& name, uint64_t n);
+    /**
+     * Records the number of continuations and primops in @p world as well as what partial evaluation and optimization left of the program:
+     * residual @c calls of functions, @c closures - functions that are used as values - and @c loops in the control flow.
+     */
+    void count(const thorin::World& world);
+    /// Registers a newly created node; nodes are counted by class when the current phase ends.
+    void ast_node(const ASTNode* node) { ast_nodes_.push_back(node); }
+
+    const std::vector<Phase>& phases() const { return phases_; }
+    /// Writes all finished phases; counters are only included with @p counters.
+    void write(std::ostream&, Format, bool counters) const;
+
+private:
+    struct Sample {
+        std::chrono::steady_clock::time_point wall;
+        double cpu_ms;
+        int64_t rss_kb;
+        uint64_t allocations;
+    };
+
+    static Sample sample();
+    Phase& current();
+    void write_text(std::ostream&, bool counters) const;
+    void write_json(std::ostream&, bool counters) const;
+    void write_trace(std::ostream&, bool counters) const;
+
+    std::chrono::steady_clock::time_point start_;
+    std::vector<Phase> phases_;
+    std::vector<std::pair<size_t, Sample>> running_; ///< Index into @c phases_ and the sample taken at @c begin.
+    std::vector<const ASTNode*> ast_nodes_;
+};
+
+/// Installs @p stats - which may be @c nullptr - in the current @c SessionState for the lifetime of the scope.
+class StatsScope {
+public:
+    StatsScope(Stats* stats);
+    ~StatsScope();
+
+private:
+    Stats* prev_;
+};
+
+/// Measures the enclosing scope as phase @p name if a @c Stats is installed.
+class PhaseTimer {
+public:
+    PhaseTimer(const char* name);
+    ~PhaseTimer();
+
+private:
+    Stats* stats_;
+};
+
+/// Adds @p n to counter @p name if a @c Stats is installed.
+void count(const std::string& name, uint64_t n);
+
+/// The loops in the control flow of @p world: its strongly connected components of continuations that contain a cycle.
+std::vector<std::vector<const thorin::Continuation*>> find_loops(const thorin::World& world);
+
+/// Writes @p str as a JSON string literal; control characters become <tt>\\uXXXX</tt> escapes.
+std::ostream& json_quote(std::ostream& os, const std::string& str);
+
+}
+
+#endif
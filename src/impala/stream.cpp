@@ -5,7 +5,7 @@ namespace impala {
 
 using namespace thorin;
 
-Prec prec = Prec::Bottom;
+thread_local Prec prec = Prec::Bottom;
 
 /*
  * AST types
@@ -17,6 +17,8 @@ std::ostream& PtrASTType::stream(std::ostream& os) const {
     os << prefix();
     if (addr_space() != 0)
         os << '[' << addr_space() << ']';
+    if (align() != 0)
+        os << "#[align(" << align() << ")] ";
     return os << referenced_ast_type();
 }
 
@@ -139,6 +141,8 @@ std::ostream& ExternBlock::stream(std::ostream& os) const {
 }
 
 std::ostream& FnDecl::stream(std::ostream& os) const {
+    if (must_vectorize())
+        os << "#[must_vectorize] ";
     if (is_extern())
         os << "extern ";
     os << "fn ";
@@ -175,6 +179,8 @@ std::ostream& FieldDecl::stream(std::ostream& os) const {
 }
 
 std::ostream& StaticItem::stream(std::ostream& os) const {
+    if (align() != 0)
+        streamf(os, "#[align({})]", align()) << endl;
     streamf(os, "static {} {}: {}", is_mut() ? "mut " : "", identifier(), type() ? type()->to_string() : ast_type()->to_string());
     if (init())
         streamf(os, " = {}", init());
@@ -182,6 +188,8 @@ std::ostream& StaticItem::stream(std::ostream& os) const {
 }
 
 std::ostream& StructDecl::stream(std::ostream& os) const {
+    if (align() != 0)
+        streamf(os, "#[align({})]", align()) << endl;
     stream_ast_type_params(streamf(os, "{}struct {}", visibility().str(), symbol())) << " {" << up << endl;
     return stream_list(os, field_decls(), [&](const auto& field) { os << field.get(); }, "", "", ",", true) << down << endl << "}";
 }
@@ -451,10 +459,14 @@ std::ostream& IfExpr::stream(std::ostream& os) const {
 }
 
 std::ostream& WhileExpr::stream(std::ostream& os) const {
+    if (must_vectorize())
+        os << "#[must_vectorize] ";
     return streamf(os, "while {} {}", cond(), body());
 }
 
 std::ostream& ForExpr::stream(std::ostream& os) const {
+    if (must_vectorize())
+        os << "#[must_vectorize] ";
     stream_list(os << "for ", fn_expr()->params().skip_back(), [&](const auto& param) { os << param.get(); }) << " in ";
     return os << expr() << ' ' << fn_expr()->body();
 }
@@ -1,11 +1,13 @@
 #include "impala/symbol.h"
 
 #include <iomanip>
+#include <mutex>
 #include <sstream>
 
 namespace impala {
 
 Symbol::Table Symbol::table_;
+static std::mutex table_mutex;
 
 uint64_t StrHash::hash(const char* s) {
     uint64_t seed = thorin::hash_begin();
@@ -23,6 +25,7 @@ static const char* duplicate(const char* s) { return strdup(s); }
 #endif // _MSC_VER
 
 void Symbol::insert(const char* s) {
+    std::lock_guard<std::mutex> lock(table_mutex);
     auto i = table_.find(s);
     if (i == table_.end())
         i = table_.insert(duplicate(s)).first;
@@ -30,8 +33,10 @@ void Symbol::insert(const char* s) {
 }
 
 void Symbol::destroy() {
+    std::lock_guard<std::mutex> lock(table_mutex);
     for (auto s : table_)
         free((void*) const_cast<char*>(s));
+    table_.clear();
 }
 
 std::string Symbol::remove_quotation() const {
@@ -0,0 +1,168 @@
+#include "impala/vectorizereport.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include "impala/ast.h"
+#include "impala/impala.h"
+
+namespace impala {
+
+static bool before(unsigned line1, unsigned col1, unsigned line2, unsigned col2) {
+    return line1 < line2 || (line1 == line2 && col1 < col2);
+}
+
+/// Whether the position lies within @p outer; debug info may spell paths differently, so only file names are compared.
+static bool contains(const thorin::Location& outer, const std::string& filename, unsigned line, unsigned col) {
+    if (outer.filename() == nullptr || basename(outer.filename()) != basename(filename))
+        return false;
+    return !before(line, col, outer.front_line(), outer.front_col()) && !before(outer.back_line(), outer.back_col(), line, col);
+}
+
+static bool contains(const thorin::Location& outer, const thorin::Location& inner) {
+    return inner.filename() != nullptr && contains(outer, inner.filename(), inner.front_line(), inner.front_col());
+}
+
+void VectorizeReport::loop(const thorin::Location& location, const char* kind, bool must_vectorize) {
+    // generic code is emitted once per instance
+    for (const auto& loop : loops_) {
+        if (location.filename() != nullptr && contains(loop.location, location)
+                && loop.location.front_line() == location.front_line() && loop.location.front_col() == location.front_col())
+            return;
+    }
+    Loop loop;
+    loop.location = location;
+    loop.kind = kind;
+    loop.must_vectorize = must_vectorize;
+    loops_.push_back(loop);
+}
+
+void VectorizeReport::vectorized(const thorin::Location& location, const std::string& how) {
+    for (auto& loop : loops_) {
+        if (loop.location.front_line() == location.front_line() && loop.location.front_col() == location.front_col() && contains(loop.location, location)) {
+            loop.vectorized = true;
+            loop.how = how;
+        }
+    }
+}
+
+void VectorizeReport::must_vectorize(const FnDecl* fn_decl) { functions_.push_back(fn_decl->location()); }
+
+bool VectorizeReport::required(const Loop& loop) const {
+    if (loop.must_vectorize)
+        return true;
+    return std::any_of(functions_.begin(), functions_.end(), [&] (const thorin::Location& fn) { return contains(fn, loop.location); });
+}
+
+bool VectorizeReport::any_required() const {
+    return std::any_of(loops_.begin(), loops_.end(), [&] (const Loop& loop) { return required(loop); });
+}
+
+void VectorizeReport::remark(bool slp, Remark kind, const std::string& message, const std::vector<Position>& positions) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // loops nest, so the innermost loop around a position is the one that starts last
+    Loop* target = nullptr;
+    for (const auto& position : positions) {
+        Loop* innermost = nullptr;
+        for (auto& loop : loops_) {
+            if (!contains(loop.location, position.filename, position.line, position.col))
+                continue;
+            if (innermost == nullptr || before(innermost->location.front_line(), innermost->location.front_col(), loop.location.front_line(), loop.location.front_col()))
+                innermost = &loop;
+        }
+        if (innermost != nullptr && (target == nullptr || contains(innermost->location, target->location)))
+            target = innermost;
+    }
+    if (target == nullptr)
+        return;
+
+    if (slp) {
+        if (kind == Remark::Passed)
+            ++target->slp;
+        return;
+    }
+
+    target->seen = true;
+    switch (kind) {
+        case Remark::Passed:
+            target->vectorized = true;
+            target->how = message;
+            break;
+        case Remark::Missed:
+        case Remark::Analysis:
+            if (std::find(target->reasons.begin(), target->reasons.end(), message) == target->reasons.end())
+                target->reasons.push_back(message);
+            break;
+    }
+}
+
+void VectorizeReport::not_run(const std::string& reason) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    not_run_ = reason;
+}
+
+std::string VectorizeReport::reason(const Loop& loop) const {
+    if (!not_run_.empty())
+        return not_run_;
+    if (!loop.seen)
+        return "the loop vectorizer never saw it - partial evaluation or LLVM may have unrolled or removed it";
+
+    // the analysis says why, the missed remark merely that it did not happen
+    std::string result;
+    for (const auto& reason : loop.reasons) {
+        if (reason.find(':') == std::string::npos && loop.reasons.size() > 1)
+            continue;
+        result += result.empty() ? reason : "; " + reason;
+    }
+    return result.empty() ? "no reason given by LLVM" : result;
+}
+
+void VectorizeReport::write(std::ostream& os) const {
+    std::vector<const Loop*> loops;
+    for (const auto& loop : loops_)
+        loops.push_back(&loop);
+    std::stable_sort(loops.begin(), loops.end(), [] (const Loop* a, const Loop* b) {
+        return before(a->location.front_line(), a->location.front_col(), b->location.front_line(), b->location.front_col());
+    });
+
+    auto flags = os.flags();
+    os << std::left << std::setw(40) << "loop" << std::setw(8) << "kind" << std::setw(16) << "required" << "result" << std::endl;
+    for (auto loop : loops) {
+        std::ostringstream where;
+        where << (loop->location.filename() != nullptr ? loop->location.filename() : "<unknown>")
+              << ':' << loop->location.front_line() << ':' << loop->location.front_col();
+        os << std::left << std::setw(40) << where.str() << std::setw(8) << loop->kind
+           << std::setw(16) << (required(*loop) ? "must_vectorize" : "");
+        if (loop->vectorized)
+            os << loop->how;
+        else
+            os << "not vectorized: " << reason(*loop);
+        if (loop->slp != 0)
+            os << (loop->vectorized ? "; " : "; but ") << "SLP vectorized " << loop->slp << " tree" << (loop->slp == 1 ? "" : "s") << " in its body";
+        os << std::endl;
+    }
+    os.flags(flags);
+}
+
+bool VectorizeReport::check() const {
+    bool ok = true;
+    for (const auto& loop : loops_) {
+        if (required(loop) && !loop.vectorized && loop.slp == 0) {
+            error(loop.location, "{} loop is not vectorized: {}", loop.kind, reason(loop));
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+VectorizeReportScope::VectorizeReportScope(VectorizeReport* report)
+    : prev_(session_state().vectorize_report)
+{
+    session_state().vectorize_report = report;
+}
+
+VectorizeReportScope::~VectorizeReportScope() { session_state().vectorize_report = prev_; }
+
+}
@@ -0,0 +1,89 @@
+#ifndef IMPALA_VECTORIZEREPORT_H
+#define IMPALA_VECTORIZEREPORT_H
+
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "thorin/util/location.h"
+
+namespace impala {
+
+class FnDecl;
+
+/**
+ * Tells for each @c for and @c while loop of the program whether LLVM vectorized it - and why not.
+ * Emission registers the loops together with <tt>#[must_vectorize]</tt>; the back end feeds in the remarks of LLVM's loop and SLP vectorizers,
+ * which are mapped back to the loops through debug locations.
+ * A loop counts as vectorized if emission or the loop vectorizer vectorized it, or the SLP vectorizer vectorized code in its body.
+ * Install it in the current @c SessionState via @c VectorizeReportScope; emission registers nothing otherwise.
+ */
+class VectorizeReport {
+public:
+    enum class Remark { Passed, Missed, Analysis };
+
+    /// A source position as recorded in a debug location of the LLVM module.
+    struct Position {
+        std::string filename;
+        unsigned line;
+        unsigned col;
+    };
+
+    /// Registers a loop; @p kind is @c "for" or @c "while".
+    void loop(const thorin::Location& location, const char* kind, bool must_vectorize);
+    /// Records that emission vectorized the loop at @p location itself, as described by @p how;
+    /// a remark that the loop vectorizer vectorized it as well replaces @p how.
+    void vectorized(const thorin::Location& location, const std::string& how);
+    /// Registers a <tt>#[must_vectorize]</tt> function: each loop in it must be vectorized.
+    void must_vectorize(const FnDecl* fn_decl);
+    /// Whether any loop must be vectorized.
+    bool any_required() const;
+
+    /**
+     * Records a remark of the loop vectorizer - or with @p slp of the SLP vectorizer - about the code at @p positions.
+     * It is attributed to the outermost loop among the innermost loops of all @p positions. May be called concurrently.
+     */
+    void remark(bool slp, Remark kind, const std::string& message, const std::vector<Position>& positions);
+    /// Records that LLVM's vectorizers did not run at all because of @p reason. May be called concurrently.
+    void not_run(const std::string& reason);
+
+    /// Writes one line per loop: vectorized or not, and why.
+    void write(std::ostream&) const;
+    /// Reports an error at each loop that must be vectorized but was not; returns whether there was none.
+    bool check() const;
+
+private:
+    struct Loop {
+        thorin::Location location;
+        const char* kind;
+        bool must_vectorize;
+        bool seen = false;       ///< The loop vectorizer looked at it.
+        bool vectorized = false;
+        std::string how;         ///< What the loop vectorizer did - or else the SLP vectorizer.
+        std::vector<std::string> reasons;
+        size_t slp = 0;          ///< Number of SLP vectorized trees in the loop.
+    };
+
+    bool required(const Loop&) const;
+    std::string reason(const Loop&) const;
+
+    std::vector<Loop> loops_;
+    std::vector<thorin::Location> functions_; ///< Of the <tt>#[must_vectorize]</tt> functions.
+    std::string not_run_;
+    std::mutex mutex_;
+};
+
+/// Installs @p report - which may be @c nullptr - in the current @c SessionState for the lifetime of the scope.
+class VectorizeReportScope {
+public:
+    VectorizeReportScope(VectorizeReport* report);
+    ~VectorizeReportScope();
+
+private:
+    VectorizeReport* prev_;
+};
+
+}
+
+#endif
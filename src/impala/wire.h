@@ -0,0 +1,49 @@
+#ifndef IMPALA_WIRE_H
+#define IMPALA_WIRE_H
+
+// Blocking socket I/O shared by 'impala -server' and impala-client, which does not link against libimpala.
+// Both only exist on POSIX systems, so on Windows this header is empty.
+
+#ifndef _WIN32
+
+#include <cstddef>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // no such flag on macOS; serve ignores SIGPIPE instead
+#endif
+
+namespace impala {
+
+inline bool read_all(int fd, void* data, size_t size) {
+    auto p = static_cast<char*>(data);
+    while (size != 0) {
+        auto n = ::read(fd, p, size);
+        if (n <= 0)
+            return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+/// Fails instead of raising @c SIGPIPE if the other side has gone away.
+inline bool write_all(int fd, const void* data, size_t size) {
+    auto p = static_cast<const char*>(data);
+    while (size != 0) {
+        auto n = ::send(fd, p, size, MSG_NOSIGNAL);
+        if (n <= 0)
+            return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+}
+
+#endif
+
+#endif
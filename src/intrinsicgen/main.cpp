@@ -1,5 +1,7 @@
 #include <iostream>
+#include <map>
 
+#include <llvm/IR/DerivedTypes.h>
 #include <llvm/IR/Intrinsics.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/LLVMContext.h>
@@ -9,19 +11,58 @@
 #include "impala/impala.h"
 
 const impala::Type* llvm2impala(impala::TypeTable&, llvm::Type*);
+void emit(impala::TypeTable&, const std::string& llvm_name, const std::string& name, llvm::Type*);
+
+/// The element types an overloaded intrinsic is instantiated for.
+enum class Overload { Int, Float };
+
+/**
+ * The overloaded intrinsics that get concrete instantiations: one per scalar type of its kind and per @c simd of those with 2 to 16 lanes
+ * of at most 512 bits - e.g. <tt>llvm.ctpop.v4i32</tt> as @c ctpop_v4i32.
+ * Intrinsics this LLVM does not know are skipped.
+ */
+static const std::map<std::string, Overload> overloads = {
+    { "ctpop",    Overload::Int   },
+    { "ctlz",     Overload::Int   },
+    { "cttz",     Overload::Int   },
+    { "sadd_sat", Overload::Int   },
+    { "uadd_sat", Overload::Int   },
+    { "ssub_sat", Overload::Int   },
+    { "usub_sat", Overload::Int   },
+    { "fabs",     Overload::Float },
+    { "sqrt",     Overload::Float },
+    { "fma",      Overload::Float },
+    { "minnum",   Overload::Float },
+    { "maxnum",   Overload::Float },
+};
+
+static std::vector<llvm::Type*> instances(llvm::LLVMContext& context, Overload overload) {
+    std::vector<llvm::Type*> scalars;
+    if (overload == Overload::Int)
+        scalars = { llvm::Type::getInt8Ty(context), llvm::Type::getInt16Ty(context), llvm::Type::getInt32Ty(context), llvm::Type::getInt64Ty(context) };
+    else
+        scalars = { llvm::Type::getHalfTy(context), llvm::Type::getFloatTy(context), llvm::Type::getDoubleTy(context) };
+
+    auto result = scalars;
+    for (auto scalar : scalars) {
+        for (unsigned lanes = 2; lanes <= 16 && lanes * scalar->getPrimitiveSizeInBits() <= 512; lanes *= 2)
+            result.push_back(llvm::FixedVectorType::get(scalar, lanes));
+    }
+    return result;
+}
 
 int main() {
     impala::Init init("dummy");
     auto module = std::make_unique<impala::Module>("dummy.impala");
     check(init, module.get(), false);
 
-    auto& context = llvm::getGlobalContext();
+    llvm::LLVMContext context;
     int num = llvm::Intrinsic::num_intrinsics - 1;
 
     std::cout << "extern \"device\" {" << thorin::up;
     for (int i = 1; i != num; ++i) {
         auto id = (llvm::Intrinsic::ID) i;
-        std::string llvm_name = llvm::Intrinsic::getName(id);
+        std::string llvm_name = llvm::Intrinsic::getBaseName(id).str();
         // skip "experimental" intrinsics
         if (llvm_name.find("experimental")!=std::string::npos)
             continue;
@@ -31,25 +72,39 @@ int main() {
         std::transform(name.begin(), name.end(), name.begin(), [] (char c) { return c == '.' ? '_' : c; });
 
         if (llvm::Intrinsic::isOverloaded(id)) {
-            std::cout << thorin::endl;
-            std::cout << "// fn \"" << llvm_name << "\" " << name;
-            std::cout << " (...) -> (...); // is overloaded";
-        } else {
-            if (auto itype = llvm2impala(*init.typetable, llvm::Intrinsic::getType(context, id))) {
+            auto overload = overloads.find(name);
+            if (overload == overloads.end()) {
                 std::cout << thorin::endl;
-                auto fn = itype->as<impala::FnType>();
-                std::cout << "fn \"" << llvm_name << "\" " << name;
-                stream_list(std::cout, fn->ops().skip_back(), [&](const impala::Type* type) { std::cout << type; }, "(", ")");
-                if (fn->return_type()->isa<impala::NoRetType>())
-                    std::cout << " -> !;";
-                else
-                    std::cout << " -> " << fn->return_type() << ';';
+                std::cout << "// fn \"" << llvm_name << "\" " << name;
+                std::cout << " (...) -> (...); // is overloaded";
+                continue;
             }
+            for (auto type : instances(context, overload->second)) {
+                std::string instance = llvm::Intrinsic::getNameNoUnnamedTypes(id, type);
+                auto suffix = instance.substr(llvm_name.size());
+                std::transform(suffix.begin(), suffix.end(), suffix.begin(), [] (char c) { return c == '.' ? '_' : c; });
+                emit(*init.typetable, instance, name + suffix, llvm::Intrinsic::getType(context, id, type));
+            }
+        } else {
+            emit(*init.typetable, llvm_name, name, llvm::Intrinsic::getType(context, id));
         }
     }
     std::cout << thorin::down << thorin::endl << '}' << thorin::endl;
 }
 
+void emit(impala::TypeTable& tt, const std::string& llvm_name, const std::string& name, llvm::Type* type) {
+    if (auto itype = llvm2impala(tt, type)) {
+        std::cout << thorin::endl;
+        auto fn = itype->as<impala::FnType>();
+        std::cout << "fn \"" << llvm_name << "\" " << name;
+        stream_list(std::cout, fn->ops().skip_back(), [&](const impala::Type* type) { std::cout << type; }, "(", ")");
+        if (fn->return_type()->isa<impala::NoRetType>())
+            std::cout << " -> !;";
+        else
+            std::cout << " -> " << fn->return_type() << ';';
+    }
+}
+
 const impala::Type* llvm2impala(impala::TypeTable& tt, llvm::Type* type) {
     if (auto int_type = llvm::dyn_cast<llvm::IntegerType>(type)) {
         switch (int_type->getBitWidth()) {
@@ -66,6 +121,12 @@ const impala::Type* llvm2impala(impala::TypeTable& tt, llvm::Type* type) {
     if (type->isFloatTy())  return tt.type_f32();
     if (type->isDoubleTy()) return tt.type_f64();
 
+    if (auto vector_type = llvm::dyn_cast<llvm::FixedVectorType>(type)) {
+        if (auto elem_type = llvm2impala(tt, vector_type->getElementType()))
+            return tt.simd_type(elem_type, vector_type->getNumElements());
+        return nullptr;
+    }
+
     if (auto fn = llvm::dyn_cast<llvm::FunctionType>(type)) {
         std::vector<const impala::Type*> param_types(fn->getNumParams()+1);
         bool valid = true;
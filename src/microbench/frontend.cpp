@@ -0,0 +1,76 @@
+#include "microbench/frontend.h"
+
+#include <algorithm>
+#include <random>
+
+#include "thorin/type.h"
+
+#include "impala/emit.h"
+#include "impala/sema/infersema.h"
+#include "impala/sema/namesema.h"
+
+namespace impala {
+
+uint64_t microbench::union_find(size_t num_vars, size_t num_ops, uint64_t seed) {
+    InferSema sema;
+    std::mt19937_64 rng(seed);
+
+    std::vector<const Type*> vars;
+    for (size_t i = 0; i != num_vars; ++i)
+        vars.push_back(sema.unknown_type());
+    const Type* known[] = {
+        sema.type_i32(), sema.type_i64(), sema.type_f32(), sema.type_bool(),
+        sema.fn_type({sema.type_i32()}), sema.definite_array_type(sema.type_f32(), 4),
+    };
+
+    // find_type and constrain also replace each variable by its representative, as inference does with the types of the AST
+    uint64_t checksum = 0;
+    for (size_t op = 0; op != num_ops; ++op) {
+        auto r = rng() % 100;
+        auto i = size_t(rng() % num_vars);
+        if (r < 10) {
+            // pin a type variable that is still unknown
+            if (sema.find_type(vars[i])->isa<UnknownType>())
+                sema.constrain(vars[i], known[rng() % (sizeof(known) / sizeof(known[0]))]);
+            continue;
+        }
+
+        auto j = r < 80 ? std::min(i + 1 + size_t(rng() % 8), num_vars - 1) : size_t(rng() % num_vars);
+        if (sema.find_type(vars[i])->is_known() && sema.find_type(vars[j])->is_known() && sema.find_type(vars[i]) != sema.find_type(vars[j]))
+            continue; // would only produce an InferError
+        sema.constrain(vars[i], vars[j]);
+        checksum += sema.find_type(vars[i]) == sema.find_type(vars[j]);
+    }
+
+    return checksum + sema.num_unions() + sema.num_finds();
+}
+
+uint64_t microbench::name_scopes(const std::vector<const LocalDecl*>& decls, size_t depth, size_t rounds) {
+    uint64_t checksum = 0;
+    for (size_t round = 0; round != rounds; ++round) {
+        NameSema sema;
+        auto per_scope = (decls.size() + depth - 1) / depth;
+        for (size_t i = 0, e = decls.size(); i != e; ++i) {
+            if (i % per_scope == 0)
+                sema.push_scope();
+            sema.insert(decls[i]);
+            for (size_t j = i + 1 - std::min(i + 1, size_t(4)); j <= i; ++j)
+                checksum += sema.lookup(decls[j], decls[j]->symbol()) == decls[j];
+        }
+        for (size_t i = 0, e = (decls.size() + per_scope - 1) / per_scope; i != e; ++i)
+            sema.pop_scope();
+    }
+    return checksum;
+}
+
+uint64_t microbench::convert(thorin::World& world, const std::vector<const Type*>& types, size_t rounds) {
+    uint64_t checksum = 0;
+    for (size_t round = 0; round != rounds; ++round) {
+        CodeGen cg(world);
+        for (auto type : types)
+            checksum += cg.convert(type)->gid();
+    }
+    return checksum;
+}
+
+}
@@ -0,0 +1,36 @@
+#ifndef IMPALA_MICROBENCH_FRONTEND_H
+#define IMPALA_MICROBENCH_FRONTEND_H
+
+#include <cstdint>
+#include <vector>
+
+namespace thorin { class World; }
+
+namespace impala {
+
+class LocalDecl;
+class Type;
+
+/**
+ * Workloads for the front end's internal classes (@c InferSema, @c NameSema, @c CodeGen).
+ * Each one runs a fixed, seeded workload and returns a checksum so that the work cannot be optimized away.
+ */
+namespace microbench {
+
+/**
+ * Creates @p num_vars unknown types and performs @p num_ops unifications - mostly between neighbours, as inference of a function body does,
+ * some between distant types and some against known types - each followed by @c find%s on both sides.
+ */
+uint64_t union_find(size_t num_vars, size_t num_ops, uint64_t seed);
+
+/// Runs @p rounds of opening @p depth nested scopes, inserting @p decls spread over them, looking each one up and closing the scopes again.
+uint64_t name_scopes(const std::vector<const LocalDecl*>& decls, size_t depth, size_t rounds);
+
+/// Converts @p types to Thorin types @p rounds times, each time with a fresh @c CodeGen and thus an empty conversion cache.
+uint64_t convert(thorin::World& world, const std::vector<const Type*>& types, size_t rounds);
+
+}
+
+}
+
+#endif
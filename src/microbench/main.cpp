@@ -0,0 +1,266 @@
+// Microbenchmarks for the front end's hot data structures, each in isolation and with a fixed, seeded workload.
+// Every benchmark does the same amount of work on every run, so timings of different builds are directly comparable.
+// Usage: impala-microbench [-r <repeats>] [-s <scale>] [benchmark...]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "thorin/util/log.h"
+
+#include "impala/ast.h"
+#include "impala/impala.h"
+#include "impala/lexer.h"
+#include "impala/symbol.h"
+#include "impala/sema/typetable.h"
+
+#include "microbench/frontend.h"
+
+using namespace std;
+using namespace impala;
+
+static const char* bench_file = "<microbench>";
+static const uint64_t seed = 0x1badb002;
+
+/// Identifiers as they occur in programs: a few very frequent short names, keywords and a long tail of longer ones.
+static vector<string> vocabulary(size_t size) {
+    static const char* frequent[] = { "i", "j", "k", "n", "x", "y", "a", "b", "len", "res", "tmp", "acc", "body", "return", "int", "f32", "mut", "let", "fn" };
+    vector<string> words(begin(frequent), end(frequent));
+    static const char* stems[] = { "buffer", "index", "compute", "value", "width", "height", "pixel", "stride", "count", "offset", "result", "iter" };
+    for (size_t i = 0; words.size() < size; ++i)
+        words.push_back(string(stems[i % 12]) + (i % 3 == 0 ? "_" : "") + to_string(i));
+    return words;
+}
+
+/// Zipf-like sampling: low indices - the frequent names - are drawn far more often.
+static size_t skewed(mt19937_64& rng, size_t size) {
+    double u = double(rng() % 1000000) / 1000000.0;
+    return size_t(double(size) * u * u * u);
+}
+
+struct Benchmark {
+    const char* name;
+    const char* unit;
+    function<size_t(uint64_t& checksum)> run; ///< Returns the number of operations.
+};
+
+//------------------------------------------------------------------------------
+
+static Benchmark symbols(size_t scale) {
+    auto words = make_shared<vector<string>>(vocabulary(5000));
+    auto samples = make_shared<vector<size_t>>();
+    mt19937_64 rng(seed);
+    for (size_t i = 0, e = 1000000 * scale; i != e; ++i)
+        samples->push_back(skewed(rng, words->size()));
+
+    return {"symbol", "intern", [=] (uint64_t& checksum) {
+        for (auto i : *samples)
+            checksum += uintptr_t(Symbol((*words)[i]).str());
+        return samples->size();
+    }};
+}
+
+static Benchmark lexer(size_t scale) {
+    auto words = vocabulary(2000);
+    mt19937_64 rng(seed);
+    ostringstream os;
+    for (size_t line = 0, e = 20000 * scale; line != e; ++line) {
+        auto w = [&] { return words[skewed(rng, words.size())]; };
+        switch (rng() % 6) {
+            case 0: os << "    let mut " << w() << " = " << w() << "(" << w() << ", " << rng() % 1000 << ");\n"; break;
+            case 1: os << "    " << w() << " = " << w() << " * " << (rng() % 100) << ".5f + " << w() << "(" << w() << ");\n"; break;
+            case 2: os << "    if " << w() << " < " << w() << " && !" << w() << " { " << w() << " += 1; }\n"; break;
+            case 3: os << "    // " << w() << " " << w() << " " << w() << "\n"; break;
+            case 4: os << "fn " << w() << "(" << w() << ": &[f32], " << w() << ": i32) -> i64 {\n"; break;
+            case 5: os << "    print_string(\"" << w() << " " << w() << "\\n\"); }\n"; break;
+        }
+    }
+    auto source = make_shared<string>(os.str());
+
+    return {"lexer", "token", [=] (uint64_t& checksum) {
+        istringstream stream(*source);
+        Lexer lexer(stream, bench_file);
+        while (lexer.lex() != Token::Eof) {}
+        checksum += lexer.num_tokens();
+        return lexer.num_tokens();
+    }};
+}
+
+static Benchmark typetable(size_t scale) {
+    size_t num_ops = 200000 * scale;
+
+    return {"typetable", "type", [=] (uint64_t& checksum) {
+        TypeTable table;
+        mt19937_64 rng(seed);
+        vector<const Type*> pool = { table.type_i32(), table.type_i64(), table.type_f32(), table.type_f64(), table.type_bool(), table.type_u8() };
+        // keep the pool bounded so that later operations mostly hit existing types
+        auto pick = [&] { return pool[skewed(rng, min(pool.size(), size_t(512)))]; };
+
+        for (size_t op = 0; op != num_ops; ++op) {
+            const Type* type;
+            switch (rng() % 3) {
+                case 0: {
+                    vector<const Type*> params(1 + rng() % 4);
+                    for (auto& param : params)
+                        param = pick();
+                    type = table.fn_type(params);
+                    break;
+                }
+                case 1:  type = table.tuple_type({pick(), pick()}); break;
+                default: type = table.definite_array_type(pick(), 1 + rng() % 16); break;
+            }
+            if (pool.size() < 4096)
+                pool.push_back(type);
+            checksum += type->gid();
+        }
+        return num_ops;
+    }};
+}
+
+static Benchmark union_find(size_t scale) {
+    size_t num_ops = 500000 * scale;
+    return {"union_find", "unify", [=] (uint64_t& checksum) {
+        checksum += microbench::union_find(num_ops / 4, num_ops, seed);
+        return num_ops;
+    }};
+}
+
+/// A pool of types as sema encounters them: primitives, pointers, arrays and functions over those.
+static vector<const Type*> type_pool(TypeTable& table, size_t size) {
+    mt19937_64 rng(seed);
+    vector<const Type*> pool = { table.type_i32(), table.type_i64(), table.type_f32(), table.type_f64(), table.type_bool(), table.type_u8() };
+    while (pool.size() < size) {
+        auto pointee = pool[rng() % pool.size()];
+        switch (rng() % 6) {
+            case 0: pool.push_back(table.borrowed_ptr_type(pointee, rng() % 2, 0)); break;
+            case 1: pool.push_back(table.owned_ptr_type(pointee, 0)); break;
+            case 2: pool.push_back(table.definite_array_type(pointee, 1 + rng() % 8)); break;
+            case 3: pool.push_back(table.indefinite_array_type(pointee)); break;
+            case 4: pool.push_back(table.fn_type({pointee, pool[rng() % pool.size()]})); break;
+            case 5: pool.push_back(table.tuple_type({pointee, pool[rng() % pool.size()]})); break;
+        }
+    }
+    return pool;
+}
+
+static Benchmark subtype(size_t scale) {
+    auto table = make_shared<TypeTable>();
+    auto pool = make_shared<vector<const Type*>>(type_pool(*table, 2000));
+    auto pairs = make_shared<vector<pair<const Type*, const Type*>>>();
+    mt19937_64 rng(seed);
+    for (size_t i = 0, e = 500000 * scale; i != e; ++i) {
+        auto dst = (*pool)[rng() % pool->size()];
+        // most checks in practice compare a type against a similar one
+        auto src = rng() % 4 == 0 ? (*pool)[rng() % pool->size()] : dst;
+        if (auto ptr = src->isa<BorrowedPtrType>())
+            src = rng() % 2 ? table->owned_ptr_type(ptr->pointee(), 0) : src;
+        pairs->emplace_back(dst, src);
+    }
+
+    return {"is_subtype", "check", [table, pairs] (uint64_t& checksum) {
+        for (const auto& p : *pairs)
+            checksum += is_subtype(p.first, p.second);
+        return pairs->size();
+    }};
+}
+
+static Benchmark name_scopes(size_t scale) {
+    struct Decls {
+        vector<unique_ptr<const LocalDecl>> owned;
+        vector<const LocalDecl*> raw;
+    };
+
+    auto words = vocabulary(5000);
+    auto decls = make_shared<Decls>();
+    Location location(bench_file, 1, 1, 1, 1);
+    // consecutive decls never share a name, so scopes of up to words.size() decls are clash-free while outer names get shadowed
+    for (size_t i = 0, e = 20000; i != e; ++i) {
+        decls->owned.emplace_back(new LocalDecl(location, i, new Identifier(location, words[i % words.size()].c_str()), nullptr));
+        decls->raw.push_back(decls->owned.back().get());
+    }
+
+    return {"name_scopes", "decl", [=] (uint64_t& checksum) {
+        checksum += microbench::name_scopes(decls->raw, 16, scale);
+        return decls->raw.size() * scale;
+    }};
+}
+
+static Benchmark convert(size_t scale, Init& init) {
+    init.typetable.reset(new TypeTable());
+    auto pool = make_shared<vector<const Type*>>(type_pool(*init.typetable, 4000));
+    auto world = &init.world;
+
+    return {"convert", "type", [=] (uint64_t& checksum) {
+        checksum += microbench::convert(*world, *pool, 4 * scale);
+        return pool->size() * 4 * scale;
+    }};
+}
+
+//------------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    int num_repeats = 7;
+    size_t scale = 1;
+    vector<string> only;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+            num_repeats = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            scale = size_t(atoi(argv[++i]));
+        } else if (argv[i][0] == '-') {
+            cerr << "usage: " << argv[0] << " [-r <repeats>] [-s <scale>] [symbol|lexer|typetable|union_find|is_subtype|name_scopes|convert...]" << endl;
+            return EXIT_FAILURE;
+        } else
+            only.push_back(argv[i]);
+    }
+
+    if (num_repeats < 1 || scale < 1) {
+        cerr << "repeats and scale must be positive" << endl;
+        return EXIT_FAILURE;
+    }
+
+    thorin::Log::set(thorin::Log::Error, &cerr);
+    Init init("microbench");
+
+    vector<Benchmark> benchmarks = {
+        symbols(scale), lexer(scale), typetable(scale), union_find(scale), subtype(scale), name_scopes(scale), convert(scale, init)
+    };
+
+    cout << left << setw(14) << "benchmark" << right << setw(12) << "ops" << setw(14) << "median ns/op" << setw(12) << "min" << setw(12) << "max"
+         << setw(10) << "spread" << "  unit" << endl;
+    for (const auto& benchmark : benchmarks) {
+        if (!only.empty() && find(only.begin(), only.end(), benchmark.name) == only.end())
+            continue;
+
+        uint64_t checksum = 0;
+        benchmark.run(checksum); // warm-up
+        vector<double> ns_per_op;
+        size_t num_ops = 0;
+        for (int r = 0; r != num_repeats; ++r) {
+            auto start = chrono::steady_clock::now();
+            num_ops = benchmark.run(checksum);
+            auto ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+            ns_per_op.push_back(ns / double(num_ops));
+        }
+
+        sort(ns_per_op.begin(), ns_per_op.end());
+        auto median = ns_per_op[ns_per_op.size() / 2];
+        cout << left << setw(14) << benchmark.name << right << setw(12) << num_ops << fixed << setprecision(2)
+             << setw(14) << median << setw(12) << ns_per_op.front() << setw(12) << ns_per_op.back()
+             << setw(9) << 100.0 * (ns_per_op.back() - ns_per_op.front()) / median << "%  " << benchmark.unit
+             << "  (checksum " << hex << checksum % 0x10000 << dec << ")" << endl;
+    }
+
+    return EXIT_SUCCESS;
+}
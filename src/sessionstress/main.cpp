@@ -0,0 +1,99 @@
+// Compiles the given files in many concurrent CompilerSessions and checks that every session
+// produces exactly what a sequential reference compilation produced.
+// Usage: impala-sessionstress [-j <threads>] [-r <rounds>] file.impala...
+// Build with -fsanitize=thread to additionally catch unsynchronized accesses to shared state.
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "thorin/util/log.h"
+
+#include "impala/session.h"
+
+using namespace std;
+
+struct Source {
+    string filename;
+    string contents;
+};
+
+/// Everything observable about one compilation; two runs of the same source must yield equal signatures.
+static string signature(const Source& source) {
+    impala::CompilerSession session("stress");
+    bool ok = session.compile(source.contents, source.filename);
+
+    ostringstream os;
+    os << (ok ? "ok" : "failed") << ' '
+       << session.num_errors() << " errors " << session.num_warnings() << " warnings\n";
+    for (const auto& diag : session.diagnostics())
+        thorin::streamf(os, "{}: {}: {}\n", diag.location, diag.kind == impala::Diagnostic::Error ? "error" : "warning", diag.message);
+
+    if (ok) {
+        session.world().cleanup();
+        os << session.world().continuations().size() << " continuations "
+           << session.world().primops().size() << " primops\n";
+    }
+    return os.str();
+}
+
+int main(int argc, char** argv) {
+    int num_threads = int(thread::hardware_concurrency());
+    int num_rounds = 4;
+    vector<Source> sources;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+            num_threads = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+            num_rounds = atoi(argv[++i]);
+        } else {
+            ifstream file(argv[i]);
+            if (!file) {
+                cerr << "cannot open '" << argv[i] << "'" << endl;
+                return EXIT_FAILURE;
+            }
+            ostringstream contents;
+            contents << file.rdbuf();
+            sources.push_back({argv[i], contents.str()});
+        }
+    }
+
+    if (sources.empty() || num_threads < 1 || num_rounds < 1) {
+        cerr << "usage: " << argv[0] << " [-j <threads>] [-r <rounds>] file.impala..." << endl;
+        return EXIT_FAILURE;
+    }
+
+    thorin::Log::set(thorin::Log::Error, &cerr);
+
+    vector<string> expected;
+    for (const auto& source : sources)
+        expected.push_back(signature(source));
+
+    atomic<int> num_mismatches(0);
+    vector<thread> threads;
+    for (int t = 0; t != num_threads; ++t) {
+        threads.emplace_back([&, t] {
+            for (int r = 0; r != num_rounds; ++r) {
+                // start each thread at a different file so that different sources overlap in time
+                for (size_t i = 0, e = sources.size(); i != e; ++i) {
+                    size_t s = (i + t) % e;
+                    if (signature(sources[s]) != expected[s])
+                        ++num_mismatches;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    int total = num_threads * num_rounds * int(sources.size());
+    cout << total << " sessions on " << num_threads << " threads: " << num_mismatches << " mismatches" << endl;
+    return num_mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
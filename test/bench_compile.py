@@ -0,0 +1,213 @@
+#!/usr/bin/env python
+
+# Measures how long impala itself takes - per phase, via 'impala -time-passes' - on generated programs of growing size and on the test corpus.
+# Flags phases that grow super-linearly with the input and compares against a stored baseline.
+
+import argparse
+import glob
+import json
+import math
+import os
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+
+def find_exe(name):
+    exe = name + ".exe" if sys.platform == "win32" else name
+
+    for path in os.environ["PATH"].split(os.pathsep):
+        path = path.strip('"')
+        exe_path = os.path.join(path, exe)
+        if os.path.isfile(exe_path) and os.access(exe_path, os.X_OK):
+            return exe_path
+
+    return os.path.abspath(os.path.join("..", "build", "bin", exe))
+
+#-------------------------------------------------------------------------------
+# synthetic programs - each generator returns the source of a program that scales linearly in n
+
+def many_fns(n):
+    src = ["fn f0(x: int) -> int { x }\n"]
+    for i in range(1, n):
+        src.append("fn f{}(x: int) -> int {{ f{}(x) + {} }}\n".format(i, i - 1, i))
+    src.append("fn main(x: int) -> int {{ f{}(x) }}\n".format(n - 1))
+    return "".join(src)
+
+def huge_fn(n):
+    src = ["fn main(x: int) -> int {\n    let mut a = x;\n    let mut b = 1;\n"]
+    for i in range(n):
+        src.append("    a = a * 3 + b;\n    if a > {} {{ b = b + a % 7; }} else {{ b = b - 1; }}\n".format(i))
+    src.append("    a + b\n}\n")
+    return "".join(src)
+
+def generics(n):
+    src = ["fn g0[T](x: T, f: fn(T) -> T) -> T { f(x) }\n"]
+    for i in range(1, n):
+        src.append("fn g{}[T](x: T, f: fn(T) -> T) -> T {{ g{}(f(x), f) }}\n".format(i, i - 1))
+    src.append("fn main(x: int) -> int {{ g{}(x, |y: int| y + 1) }}\n".format(n - 1))
+    return "".join(src)
+
+def expr_chain(n):
+    terms = " + ".join("(x * {} - {})".format(i % 13 + 1, i % 7) for i in range(n))
+    return "fn main(x: int) -> int {{\n    {}\n}}\n".format(terms)
+
+def literal_table(n):
+    elems = ", ".join(str((i * 7919) % 1000) for i in range(n))
+    return "static table = [{}];\n\nfn main(x: int) -> int {{ table(x % {}) }}\n".format(elems, n)
+
+def partial_eval(n):
+    return """fn power(a: int, mut b: int) -> int {{
+    let mut result = 1;
+    while b != 0 {{
+        result = result * a + b;
+        --b;
+    }}
+    result
+}}
+
+fn main(x: int) -> int {{ @power(x, {}) }}
+""".format(n)
+
+# name -> (generator, n)
+GENERATORS = {
+    "many_fns":      (many_fns,      200),
+    "huge_fn":       (huge_fn,       200),
+    "generics":      (generics,       50),
+    "expr_chain":    (expr_chain,    200),
+    "literal_table": (literal_table, 2000),
+    "partial_eval":  (partial_eval,  100),
+}
+
+SCALES = [1, 2, 4, 8]
+
+#-------------------------------------------------------------------------------
+
+def compile_once(impala, flags, infile, workdir):
+    stats_file = os.path.join(workdir, "stats.json")
+    cmd = [impala] + flags + ["-time-passes", "-stats-format", "json", "-stats-file", stats_file, infile]
+    result = subprocess.run(cmd, cwd=workdir, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+    if result.returncode != 0:
+        raise RuntimeError("'{}' failed:\n{}".format(" ".join(cmd), result.stderr.decode()))
+    with open(stats_file) as f:
+        return json.load(f)["phases"]
+
+def measure(impala, flags, infile, repeats, workdir):
+    """Returns the per-phase medians of wall time, peak RSS growth and allocations over 'repeats' compilations."""
+    runs = [compile_once(impala, flags, infile, workdir) for _ in range(repeats)]
+    phases = {}
+    for run in runs:
+        for phase in run:
+            entry = phases.setdefault(phase["name"], {"wall_ms": [], "rss_delta_kb": [], "allocations": []})
+            for key in entry:
+                entry[key].append(phase[key])
+    result = {name: {key: statistics.median(values) for key, values in entry.items()} for name, entry in phases.items()}
+    result["total"] = {key: sum(phase[key] for phase in result.values()) for key in ("wall_ms", "rss_delta_kb", "allocations")}
+    return result
+
+def slope(sizes, times):
+    """Least-squares exponent k of time ~ size^k; 1 means linear."""
+    xs = [math.log(s) for s in sizes]
+    ys = [math.log(max(t, 1e-3)) for t in times]
+    mx, my = statistics.mean(xs), statistics.mean(ys)
+    return sum((x - mx) * (y - my) for x, y in zip(xs, ys)) / sum((x - mx) ** 2 for x in xs)
+
+def bench_generated(impala, flags, repeats, workdir, scale, only, max_exponent, min_ms):
+    results, warnings = {}, []
+    for name, (generator, n) in sorted(GENERATORS.items()):
+        if only and name not in only:
+            continue
+        sizes = [int(n * scale * s) for s in SCALES]
+        runs = []
+        for size in sizes:
+            infile = os.path.join(workdir, "{}_{}.impala".format(name, size))
+            with open(infile, "w") as f:
+                f.write(generator(size))
+            runs.append(measure(impala, flags, infile, repeats, workdir))
+            print("{:>14} n={:<7} {:10.2f} ms {:10d} KiB {:12d} allocs".format(
+                name, size, runs[-1]["total"]["wall_ms"], int(runs[-1]["total"]["rss_delta_kb"]), int(runs[-1]["total"]["allocations"])))
+
+        for phase in runs[-1]:
+            times = [run.get(phase, {}).get("wall_ms", 0) for run in runs]
+            if times[-1] < min_ms:
+                continue # too fast to fit anything but noise
+            k = slope(sizes, times)
+            if k > max_exponent:
+                warnings.append("{}: phase '{}' scales as n^{:.2f} ({:.2f} ms at n={} vs. {:.2f} ms at n={})".format(
+                    name, phase, k, times[0], sizes[0], times[-1], sizes[-1]))
+        results[name] = {str(size): run for size, run in zip(sizes, runs)}
+    return results, warnings
+
+def bench_corpus(impala, flags, repeats, workdir, dirs):
+    results = {}
+    for d in dirs:
+        for infile in sorted(glob.glob(os.path.join(d, "*.impala"))):
+            try:
+                results[os.path.relpath(infile)] = measure(impala, flags, os.path.abspath(infile), repeats, workdir)
+            except RuntimeError:
+                pass # not every test is meant to compile with these flags
+    total = sum(r["total"]["wall_ms"] for r in results.values())
+    print("{:>14} {} files {:10.2f} ms".format("corpus", len(results), total))
+    return results
+
+def compare(baseline, results, tolerance, min_ms):
+    """Yields a line for every total that got slower than the baseline by more than 'tolerance'."""
+    def walk(path, old, new):
+        if "total" in new and "total" in old:
+            before, after = old["total"]["wall_ms"], new["total"]["wall_ms"]
+            if after >= min_ms and after > before * (1 + tolerance):
+                yield "{}: {:.2f} ms -> {:.2f} ms (+{:.0f}%)".format(path, before, after, 100 * (after / before - 1) if before > 0 else float("inf"))
+            return
+        for key in new:
+            if key in old:
+                yield from walk(path + "/" + key if path else key, old[key], new[key])
+    return list(walk("", baseline, results))
+
+def main():
+    test_dir = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+    parser.add_argument('-i', '--impala',        nargs='?', help='path to impala',                                          default=find_exe("impala"), type=str)
+    parser.add_argument('-f', '--flags',         nargs='?', help='impala flags, e.g. "-emit-llvm -O3"',                     default="-emit-llvm",       type=str)
+    parser.add_argument('-r', '--repeats',       nargs='?', help='compilations per input; medians are reported',            default=3,                  type=int)
+    parser.add_argument('-s', '--scale',         nargs='?', help='multiplies the base size n of every generator',           default=1.0,                type=float)
+    parser.add_argument('-g', '--generators',    nargs='*', help='only run these generators: ' + ", ".join(sorted(GENERATORS)), default=[])
+    parser.add_argument('-c', '--corpus',        nargs='*', help='test directories whose programs are timed as well',
+                        default=[os.path.join(test_dir, d) for d in ("codegen", "codegen/benchmarks", "partial_eval", "sema/positive")])
+    parser.add_argument('-k', '--max-exponent',  nargs='?', help='flag phases that grow faster than n^k',                   default=1.3,                type=float)
+    parser.add_argument('-m', '--min-ms',        nargs='?', help='ignore phases and programs faster than this',             default=5.0,                type=float)
+    parser.add_argument('-o', '--output',        nargs='?', help='write results as JSON to this file',                      default=None,               type=str)
+    parser.add_argument('-b', '--baseline',      nargs='?', help='compare against the JSON results of an earlier run',      default=None,               type=str)
+    parser.add_argument('-t', '--tolerance',     nargs='?', help='relative slowdown against the baseline that is reported', default=0.10,               type=float)
+    args = parser.parse_args()
+
+    flags = args.flags.split()
+    workdir = tempfile.mkdtemp()
+    try:
+        generated, warnings = bench_generated(args.impala, flags, args.repeats, workdir, args.scale, args.generators, args.max_exponent, args.min_ms)
+        corpus = bench_corpus(args.impala, flags, args.repeats, workdir, args.corpus)
+    finally:
+        shutil.rmtree(workdir)
+
+    results = {"flags": args.flags, "generated": generated, "corpus": corpus}
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(results, f, indent=1, sort_keys=True)
+
+    for warning in warnings:
+        print("super-linear: " + warning)
+
+    regressions = []
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        if baseline.get("flags") != args.flags:
+            print("warning: baseline was recorded with flags '{}'".format(baseline.get("flags")))
+        regressions = compare({k: baseline.get(k, {}) for k in ("generated", "corpus")}, {"generated": generated, "corpus": corpus}, args.tolerance, args.min_ms)
+        for regression in regressions:
+            print("regression: " + regression)
+
+    sys.exit(1 if warnings or regressions else 0)
+
+if __name__ == '__main__':
+    main()
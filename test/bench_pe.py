@@ -0,0 +1,158 @@
+#!/usr/bin/env python
+
+# Measures the quality of partial evaluation: what is left of each program after Thorin's optimizations -
+# residual calls, loops and closures as counted by 'impala -stats' - together with code size and compile time.
+# Every program has an ideal that full specialization of its '@' annotations reaches; exceeding it is reported as a failure.
+
+import argparse
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+def find_exe(name):
+    exe = name + ".exe" if sys.platform == "win32" else name
+
+    for path in os.environ["PATH"].split(os.pathsep):
+        path = path.strip('"')
+        exe_path = os.path.join(path, exe)
+        if os.path.isfile(exe_path) and os.access(exe_path, os.X_OK):
+            return exe_path
+
+    return os.path.abspath(os.path.join("..", "build", "bin", exe))
+
+# program -> upper bounds on what may remain after optimization; metrics without a bound are only recorded
+IDEALS = {
+    "partial_eval/ackermann.impala":     {"calls": 0, "loops": 0, "closures": 0}, # @a(3, 3) folds to a constant
+    "partial_eval/array.impala":         {"calls": 0, "loops": 0, "closures": 0}, # @range(0, 3) is unrolled
+    "partial_eval/blocked_loop.impala":  {"calls": 0, "loops": 3, "closures": 0}, # one $range_step per level with a positive block size
+    "partial_eval/double_loop.impala":   {"calls": 0, "loops": 1, "closures": 0}, # only range(7, a) depends on the input
+    "partial_eval/dynamic_fun.impala":   {"loops": 0},
+    "partial_eval/logic_operator.impala":{"calls": 0, "loops": 0, "closures": 0},
+    "partial_eval/nested.impala":        {"calls": 0, "loops": 1, "closures": 0}, # the inner loop over b = 10 is unrolled
+    "partial_eval/nested_loop.impala":   {"calls": 0, "loops": 4, "closures": 0}, # one $range per unrolled region
+    "partial_eval/power.impala":         {"calls": 0, "loops": 0, "closures": 0},
+    "partial_eval/range.impala":         {"calls": 0, "loops": 1, "closures": 0}, # $ keeps the loop
+    "partial_eval/runblock.impala":      {"calls": 0, "loops": 0, "closures": 0},
+    "partial_eval/two_loops.impala":     {"calls": 0, "loops": 1, "closures": 0}, # the loop over b = 10 is unrolled
+    "partial_eval/unroll.impala":        {"calls": 0, "loops": 0, "closures": 0},
+    "codegen/partial_eval_bug.impala":   {"calls": 0, "loops": 0, "closures": 0},
+    "codegen/endless_mangling.impala":   {},                                      # must terminate; see --timeout
+}
+
+METRICS = ["continuations", "calls", "loops", "closures", "llvm_instructions", "compile_ms"]
+
+def llvm_instructions(ll_file):
+    """Counts the instructions in the function bodies of an LLVM module."""
+    count = 0
+    in_body = False
+    with open(ll_file) as f:
+        for line in f:
+            if line.startswith("define "):
+                in_body = True
+            elif line.startswith("}"):
+                in_body = False
+            elif in_body and re.match(r"\s+[%a-z]", line):
+                count += 1
+    return count
+
+def measure(impala, flags, infile, timeout, workdir):
+    stats_file = os.path.join(workdir, "stats.json")
+    cmd = [impala] + flags + ["-emit-llvm", "-stats", "-stats-format", "json", "-stats-file", stats_file, infile]
+    try:
+        result = subprocess.run(cmd, cwd=workdir, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, timeout=timeout)
+    except subprocess.TimeoutExpired:
+        raise RuntimeError("did not finish within {} s".format(timeout))
+    if result.returncode != 0:
+        raise RuntimeError("'{}' failed:\n{}".format(" ".join(cmd), result.stderr.decode()))
+
+    with open(stats_file) as f:
+        phases = json.load(f)["phases"]
+    # the counters of the last phase that looked at the world are the residual program
+    opt = [phase for phase in phases if phase["name"] == "opt"]
+    if not opt:
+        raise RuntimeError("no 'opt' phase in the -stats report; were Thorin optimizations disabled?")
+
+    counters = opt[-1].get("counters", {})
+    metrics = {metric: counters.get(metric, 0) for metric in ("continuations", "calls", "loops", "closures")}
+    metrics["compile_ms"] = sum(phase["wall_ms"] for phase in phases)
+    module = os.path.splitext(os.path.basename(infile))[0]
+    metrics["llvm_instructions"] = llvm_instructions(os.path.join(workdir, module + ".ll"))
+    return metrics
+
+def compare(baseline, results, tolerance, min_ms):
+    """Returns a line per metric that grew by more than 'tolerance' against the baseline."""
+    regressions = []
+    for name, new in sorted(results.items()):
+        old = baseline.get(name)
+        if old is None:
+            continue
+        for metric in METRICS:
+            before, after = old.get(metric), new.get(metric)
+            if before is None or after is None:
+                continue
+            if metric == "compile_ms" and after < min_ms:
+                continue
+            if after > before * (1 + tolerance):
+                regressions.append("{}: {} {} -> {}".format(name, metric, before, after))
+    return regressions
+
+def main():
+    test_dir = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+    parser.add_argument('programs',          nargs='*', help='programs to measure, relative to test/',                  default=sorted(IDEALS))
+    parser.add_argument('-i', '--impala',    nargs='?', help='path to impala',                                          default=find_exe("impala"), type=str)
+    parser.add_argument('-f', '--flags',     nargs='?', help='additional impala flags',                                  default="-O3",              type=str)
+    parser.add_argument('--timeout',         nargs='?', help='seconds after which a compilation counts as not terminating', default=60,              type=int)
+    parser.add_argument('-o', '--output',    nargs='?', help='write results as JSON to this file',                      default=None,               type=str)
+    parser.add_argument('-b', '--baseline',  nargs='?', help='compare against the JSON results of an earlier run',      default=None,               type=str)
+    parser.add_argument('-t', '--tolerance', nargs='?', help='relative growth against the baseline that is reported',   default=0.10,               type=float)
+    parser.add_argument('-m', '--min-ms',    nargs='?', help='ignore compile time changes of programs faster than this', default=20.0,              type=float)
+    args = parser.parse_args()
+
+    results, failures = {}, []
+    print("{:<36} {:>8} {:>6} {:>6} {:>9} {:>8} {:>10}".format("program", "conts", "calls", "loops", "closures", "llvm", "compile ms"))
+    workdir = tempfile.mkdtemp()
+    try:
+        for name in args.programs:
+            try:
+                m = measure(args.impala, args.flags.split(), os.path.join(test_dir, name), args.timeout, workdir)
+            except RuntimeError as e:
+                print("{:<36} FAILED: {}".format(name, e))
+                failures.append("{}: {}".format(name, e))
+                continue
+            results[name] = m
+
+            exceeded = ["{} {} > {}".format(metric, m[metric], bound) for metric, bound in sorted(IDEALS.get(name, {}).items()) if m[metric] > bound]
+            print("{:<36} {:>8} {:>6} {:>6} {:>9} {:>8} {:>10.2f}{}".format(
+                name, m["continuations"], m["calls"], m["loops"], m["closures"], m["llvm_instructions"], m["compile_ms"],
+                "  not fully specialized: " + ", ".join(exceeded) if exceeded else ""))
+            if exceeded:
+                failures.append("{}: {}".format(name, ", ".join(exceeded)))
+    finally:
+        shutil.rmtree(workdir)
+
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump({"flags": args.flags, "programs": results}, f, indent=1, sort_keys=True)
+
+    regressions = []
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        if baseline.get("flags") != args.flags:
+            print("warning: baseline was recorded with flags '{}'".format(baseline.get("flags")))
+        regressions = compare(baseline.get("programs", {}), results, args.tolerance, args.min_ms)
+        for regression in regressions:
+            print("regression: " + regression)
+
+    for failure in failures:
+        print("failure: " + failure)
+
+    sys.exit(1 if failures or regressions else 0)
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,71 @@
+#!/usr/bin/env python
+
+# Compares the latency of cold 'impala' invocations with requests to a resident 'impala -server'.
+
+import argparse
+import os
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+def find_exe(name):
+    exe = name + ".exe" if sys.platform == "win32" else name
+
+    for path in os.environ["PATH"].split(os.pathsep):
+        path = path.strip('"')
+        exe_path = os.path.join(path, exe)
+        if os.path.isfile(exe_path) and os.access(exe_path, os.X_OK):
+            return exe_path
+
+    return os.path.abspath(os.path.join("..", "build", "bin", exe))
+
+def measure(cmd, repeats):
+    times = []
+    for _ in range(repeats):
+        start = time.perf_counter()
+        result = subprocess.run(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+        times.append(time.perf_counter() - start)
+        if result.returncode != 0:
+            sys.exit("'{}' failed:\n{}".format(" ".join(cmd), result.stderr.decode()))
+    return times
+
+def report(name, times):
+    print("{:>8}: median {:8.2f} ms, min {:8.2f} ms, max {:8.2f} ms".format(
+        name, 1000 * statistics.median(times), 1000 * min(times), 1000 * max(times)))
+
+def main():
+    parser = argparse.ArgumentParser(formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+    parser.add_argument('files',           nargs='+', help='impala files to compile per request',            type=str)
+    parser.add_argument('-i', '--impala',  nargs='?', help='path to impala',                                 default=find_exe("impala"),        type=str)
+    parser.add_argument('-c', '--client',  nargs='?', help='path to impala-client',                          default=find_exe("impala-client"), type=str)
+    parser.add_argument('-r', '--repeats', nargs='?', help='number of compilations per mode',                default=20,                        type=int)
+    parser.add_argument('-f', '--flags',   nargs='?', help='impala flags, e.g. "-emit-llvm -O3"',            default="-emit-llvm",              type=str)
+    args = parser.parse_args()
+
+    flags = args.flags.split()
+    socket = os.path.join(tempfile.mkdtemp(), "impala.sock")
+    server = subprocess.Popen([args.impala, "-server", socket], stderr=subprocess.DEVNULL)
+    try:
+        for _ in range(100):
+            if os.path.exists(socket):
+                break
+            time.sleep(0.05)
+        else:
+            sys.exit("server did not come up on " + socket)
+
+        client = [args.client, "-socket", socket]
+        measure(client + flags + args.files, 1) # warm up source cache
+
+        cold   = measure([args.impala] + flags + args.files, args.repeats)
+        served = measure(client + flags + args.files, args.repeats)
+        report("cold", cold)
+        report("server", served)
+        print("speedup (median): {:.2f}x".format(statistics.median(cold) / statistics.median(served)))
+    finally:
+        subprocess.run([args.client, "-socket", socket, "-shutdown"], stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        server.wait(timeout=10)
+
+if __name__ == '__main__':
+    main()
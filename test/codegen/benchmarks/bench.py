@@ -0,0 +1,210 @@
+#!/usr/bin/env python
+
+# Builds the benchmarks of this directory in several configurations and times them.
+# Per benchmark and configuration it records impala's compile time, the binary size and the median and spread of the run time;
+# results can be written as JSON and compared against an earlier run.
+#
+# Run from test/ like run_tests.py, e.g.: codegen/benchmarks/bench.py -O 2 3 --thorin both -o results.json
+# With --threads the parallel variants run once per number of worker threads, e.g. --threads 1 2 4 8 to measure their scaling.
+
+import argparse
+import json
+import os
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+TEST_DIR  = os.path.dirname(os.path.dirname(BENCH_DIR))
+LIB_C     = os.path.join(TEST_DIR, "infrastructure", "lib.c")
+
+sys.path.insert(0, TEST_DIR)
+sys.path.insert(0, BENCH_DIR)
+import tests as benchmark_tests # the same arguments and inputs the correctness tests use
+
+def find_exe(name):
+    exe = name + ".exe" if sys.platform == "win32" else name
+
+    for path in os.environ["PATH"].split(os.pathsep):
+        path = path.strip('"')
+        exe_path = os.path.join(path, exe)
+        if os.path.isfile(exe_path) and os.access(exe_path, os.X_OK):
+            return exe_path
+
+    return os.path.abspath(os.path.join(TEST_DIR, "..", "build", "bin", exe))
+
+def benchmarks():
+    """Yields (name, source, args, input) for each benchmark."""
+    for src in sorted(os.listdir(BENCH_DIR)):
+        if not src.endswith(".impala"):
+            continue
+        name = os.path.splitext(src)[0]
+        args = benchmark_tests.args.get("codegen/benchmarks/" + src, [])
+        input_file = benchmark_tests.inputs.get(src)
+        if input_file is not None:
+            input_file = os.path.join(TEST_DIR, input_file)
+        yield name, os.path.join(BENCH_DIR, src), args, input_file
+
+def check_call(cmd, cwd):
+    result = subprocess.run(cmd, cwd=cwd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    if result.returncode != 0:
+        raise RuntimeError("'{}' failed:\n{}".format(" ".join(cmd), result.stdout.decode(errors="replace")))
+
+def build(impala, src, opt, thorin, workdir):
+    """Returns (compile seconds, executable) for one configuration."""
+    name = os.path.splitext(os.path.basename(src))[0]
+    flags = ["-O{}".format(opt), "-emit-llvm"] + ([] if thorin else ["-noopt"])
+    start = time.perf_counter()
+    check_call([impala] + flags + [src], workdir)
+    compile_time = time.perf_counter() - start
+
+    exe = os.path.join(workdir, name)
+    check_call(["clang", "-O{}".format(opt), LIB_C, name + ".ll", "-L", "/opt/local/lib", "-lm", "-lpcre", "-lgmp", "-lpthread", "-s", "-o", exe], workdir)
+    return compile_time, exe
+
+def run(exe, args, input_file, cpu, workdir, threads=None):
+    cmd = [exe] + args
+    env = dict(os.environ, ANYDSL_NUM_THREADS=str(threads)) if threads is not None else None
+    if cpu is not None and shutil.which("taskset"):
+        cmd = ["taskset", "-c", str(cpu)] + cmd
+    stdin = open(input_file, "rb") if input_file else subprocess.DEVNULL
+    try:
+        start = time.perf_counter()
+        result = subprocess.run(cmd, cwd=workdir, env=env, stdin=stdin, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        elapsed = time.perf_counter() - start
+    finally:
+        if input_file:
+            stdin.close()
+    if result.returncode != 0:
+        raise RuntimeError("'{}' returned {}:\n{}".format(" ".join(cmd), result.returncode, result.stderr.decode(errors="replace")))
+    return elapsed, result.stdout
+
+def expected_output(name):
+    path = os.path.join(BENCH_DIR, name + ".output")
+    if not os.path.exists(path) and benchmark_tests.variant_of(name) is not None:
+        path = os.path.join(BENCH_DIR, benchmark_tests.variant_of(name) + ".output")
+    if not os.path.exists(path):
+        return None
+    with open(path, "rb") as f:
+        return f.read()
+
+def bench(impala, name, src, args, input_file, opt, thorin, warmup, repeats, cpu, threads=None):
+    if name.endswith("_par"):
+        cpu = None # pinning the multi-core variants to a single CPU would serialize them
+    workdir = tempfile.mkdtemp()
+    try:
+        compile_time, exe = build(impala, src, opt, thorin, workdir)
+
+        # the first run doubles as a correctness check
+        _, output = run(exe, args, input_file, cpu, workdir, threads)
+        # some benchmarks write their result to a file instead of stdout
+        output_file = benchmark_tests.compare_files.get(name + ".impala")
+        if output_file is not None:
+            with open(os.path.join(workdir, output_file), "rb") as f:
+                output = f.read()
+        expected = expected_output(name)
+        if expected is not None and output != expected:
+            raise RuntimeError("{}: output differs from {}.output".format(name, name))
+
+        for _ in range(warmup):
+            run(exe, args, input_file, cpu, workdir, threads)
+        times = [run(exe, args, input_file, cpu, workdir, threads)[0] for _ in range(repeats)]
+
+        median = statistics.median(times)
+        return {
+            "compile_s":   compile_time,
+            "size_bytes":  os.path.getsize(exe),
+            "median_s":    median,
+            "min_s":       min(times),
+            "max_s":       max(times),
+            "stdev_s":     statistics.stdev(times) if len(times) > 1 else 0.0,
+            "spread":      (max(times) - min(times)) / median if median > 0 else 0.0,
+            "times_s":     times,
+        }
+    finally:
+        shutil.rmtree(workdir)
+
+def compare(baseline, results, thresholds):
+    """Returns a line per metric that regressed by more than its threshold."""
+    regressions = []
+    for config, benches in sorted(results.items()):
+        for name, new in sorted(benches.items()):
+            old = baseline.get(config, {}).get(name)
+            if old is None:
+                continue
+            for metric, threshold in thresholds.items():
+                if old[metric] > 0 and new[metric] > old[metric] * (1 + threshold):
+                    regressions.append("{} {}: {} {:.4g} -> {:.4g} (+{:.1f}%, threshold {:.0f}%)".format(
+                        config, name, metric, old[metric], new[metric], 100 * (new[metric] / old[metric] - 1), 100 * threshold))
+    return regressions
+
+def main():
+    names = [name for name, _, _, _ in benchmarks()]
+    parser = argparse.ArgumentParser(formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+    parser.add_argument('benchmarks',          nargs='*', help='benchmarks to run: ' + ", ".join(names),           default=names)
+    parser.add_argument('-i', '--impala',      nargs='?', help='path to impala',                                    default=find_exe("impala"), type=str)
+    parser.add_argument('-O', '--opt',         nargs='+', help='optimization levels passed to impala and clang',    default=[3],                type=int, choices=[0, 1, 2, 3])
+    parser.add_argument('-t', '--thorin',      nargs='?', help='with Thorin optimizations, without them or both',  default="on",               choices=["on", "off", "both"])
+    parser.add_argument('-w', '--warmup',      nargs='?', help='untimed runs before measuring',                     default=1,                  type=int)
+    parser.add_argument('-r', '--repeats',     nargs='?', help='timed runs per benchmark and configuration',        default=5,                  type=int)
+    parser.add_argument('-c', '--cpu',         nargs='?', help='pin runs to this CPU via taskset; -1 disables',     default=0,                  type=int)
+    parser.add_argument('-j', '--threads',     nargs='+', help='worker threads to run the *_par benchmarks with',   default=None,               type=int)
+    parser.add_argument('-o', '--output',      nargs='?', help='write results as JSON to this file',                default=None,               type=str)
+    parser.add_argument('-b', '--baseline',    nargs='?', help='compare against the JSON results of an earlier run', default=None,              type=str)
+    parser.add_argument('--runtime-threshold', nargs='?', help='relative run time regression that is reported',    default=0.05,               type=float)
+    parser.add_argument('--compile-threshold', nargs='?', help='relative compile time regression that is reported', default=0.10,              type=float)
+    parser.add_argument('--size-threshold',    nargs='?', help='relative binary size regression that is reported',  default=0.02,               type=float)
+    args = parser.parse_args()
+
+    unknown = set(args.benchmarks) - set(names)
+    if unknown:
+        sys.exit("unknown benchmarks: " + ", ".join(sorted(unknown)))
+
+    thorin = {"on": [True], "off": [False], "both": [True, False]}[args.thorin]
+    cpu = args.cpu if args.cpu >= 0 else None
+
+    results = {}
+    failed = False
+    print("{:<20} {:<12} {:>10} {:>10} {:>10} {:>8}".format("config", "benchmark", "compile s", "size KiB", "median s", "spread"))
+    for opt in args.opt:
+        for with_thorin in thorin:
+            config = "O{}{}".format(opt, "" if with_thorin else "-noopt")
+            results[config] = {}
+            for name, src, bench_args, input_file in benchmarks():
+                if name not in args.benchmarks:
+                    continue
+                if input_file is not None and not os.path.exists(input_file):
+                    print("{:<20} {:<12} skipped: missing input {}".format(config, name, os.path.relpath(input_file, TEST_DIR)))
+                    continue
+                for threads in (args.threads or [None]) if name.endswith("_par") else [None]:
+                    key = name if threads is None else "{}-j{}".format(name, threads)
+                    try:
+                        r = bench(args.impala, name, src, bench_args, input_file, opt, with_thorin, args.warmup, args.repeats, cpu, threads)
+                    except RuntimeError as e:
+                        print("{:<20} {:<12} FAILED: {}".format(config, key, e))
+                        failed = True
+                        continue
+                    results[config][key] = r
+                    print("{:<20} {:<12} {:>10.3f} {:>10.1f} {:>10.3f} {:>7.1f}%".format(
+                        config, key, r["compile_s"], r["size_bytes"] / 1024.0, r["median_s"], 100 * r["spread"]))
+
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(results, f, indent=1, sort_keys=True)
+
+    regressions = []
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        thresholds = {"median_s": args.runtime_threshold, "compile_s": args.compile_threshold, "size_bytes": args.size_threshold}
+        regressions = compare(baseline, results, thresholds)
+        for regression in regressions:
+            print("regression: " + regression)
+
+    sys.exit(1 if failed or regressions else 0)
+
+if __name__ == '__main__':
+    main()
@@ -2,6 +2,8 @@
 tests.py for codegen/benchmarks
 """
 
+import os
+
 # import the test infrastructure
 from infrastructure.tests import make_invoke_tests
 
@@ -11,15 +13,25 @@ optionals = [
 
 args = {
     "codegen/benchmarks/aobench.impala" : [],
+    "codegen/benchmarks/aobench_par.impala" : [],
+    "codegen/benchmarks/aobench_simd.impala" : [],
     "codegen/benchmarks/fannkuch.impala" : ["10"],
+    "codegen/benchmarks/fannkuch_par.impala" : ["10"],
     "codegen/benchmarks/fasta.impala" : ["500000"],
     "codegen/benchmarks/mandelbrot.impala" : ["3000"],
+    "codegen/benchmarks/mandelbrot_par.impala" : ["3000"],
+    "codegen/benchmarks/mandelbrot_simd.impala" : ["3000"],
     "codegen/benchmarks/meteor.impala" : ["2098"],
     "codegen/benchmarks/nbody.impala" : ["6000000"],
+    "codegen/benchmarks/nbody_par.impala" : ["50000"],
+    "codegen/benchmarks/nbody_simd.impala" : ["6000000"],
     "codegen/benchmarks/pidigits.impala" : ["10000"],
+    "codegen/benchmarks/reduce_par.impala" : ["50000000"],
     "codegen/benchmarks/regex.impala" : [],
     "codegen/benchmarks/reverse.impala" : [],
     "codegen/benchmarks/spectral.impala" : ["1800"],
+    "codegen/benchmarks/spectral_par.impala" : ["1800"],
+    "codegen/benchmarks/spectral_simd.impala" : ["1800"],
 }
 
 inputs = {
@@ -27,12 +39,29 @@ inputs = {
     "reverse.impala" : "codegen/benchmarks/input_reverse.txt",
 }
 
+compare_files = {
+    "aobench.impala" : "ao.ppm",
+    "aobench_par.impala" : "ao.ppm",
+    "aobench_simd.impala" : "ao.ppm",
+}
+
+# parallel and SIMD variants must print exactly what the program they are derived from does
+VARIANT_SUFFIXES = ["_par", "_simd"]
+
+def variant_of(name):
+    """Returns the name of the sequential benchmark 'name' is a variant of, or None."""
+    base = os.path.splitext(os.path.basename(name))[0]
+    for suffix in VARIANT_SUFFIXES:
+        if base.endswith(suffix):
+            return base[:-len(suffix)]
+    return None
+
 def allTests():
     """
     This function returns a list of tests.
     """
-    tests = make_invoke_tests("codegen/benchmarks", [], True, {"aobench.impala" : "ao.ppm"}, inputs)
-    
+    tests = make_invoke_tests("codegen/benchmarks", [], True, compare_files, inputs)
+
     # mark optionals
     for test in tests:
         if test.getName() in optionals:
@@ -41,6 +70,8 @@ def allTests():
         if test.getName() in args:
             test.args = args[test.getName()]
 
+        base = variant_of(test.getName())
+        if test.output_file is None and base is not None:
+            test.output_file = base + ".output"
 
-    
     return tests
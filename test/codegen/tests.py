@@ -36,7 +36,15 @@ def allTests():
       "codegen/while_true.impala",
     ]
 
+    # what LLVM's optimizations make of the emitted code is what these check
+    options = {
+      "codegen/aliasing.impala"     : ["-O3"],
+      "codegen/simd_folding.impala" : ["-O3"],
+    }
+
     tests = make_invoke_tests("codegen")
+    for test in tests:
+        test.options = options.get(test.getName(), []) + test.options
     tests += get_tests_from_dir("codegen/benchmarks")
     tests += get_tests_from_dir("codegen/inline_asm")
 
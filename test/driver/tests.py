@@ -0,0 +1,151 @@
+"""
+tests.py for the reports of the impala driver
+"""
+
+import json, re
+
+# import the test infrastructure
+from infrastructure.tests import make_tests
+
+# command line options of each test besides its source file
+options = {
+    "driver/cost_report.impala"           : ["-cost-report"],
+    "driver/pe_over_budget.impala"        : ["-emit-llvm", "-pe-report", "-pe-max-size", "1"],
+    "driver/pe_report.impala"             : ["-emit-llvm", "-pe-report", "-pe-max-specializations", "4"],
+    "driver/pe_runaway.impala"            : ["-emit-llvm", "-pe-max-time", "5000"],
+    "driver/remarks_alloc_in_loop.impala" : ["-remarks", "-remarks-filter", "alloc-in-loop"],
+    "driver/remarks_closure.impala"       : ["-remarks", "-remarks-filter", "closure"],
+    "driver/remarks_mem2reg.impala"       : ["-remarks", "-remarks-filter", "mem2reg"],
+    "driver/remarks_specialize.impala"    : ["-remarks", "-remarks-filter", "specialize"],
+    "driver/stats_json.impala"            : ["-stats", "-stats-format", "json"],
+    "driver/stats_trace.impala"           : ["-time-passes", "-stats-format", "trace"],
+    "driver/time_passes.impala"           : ["-time-passes"],
+    "driver/vectorize_for.impala"         : ["-O3", "-vectorize-report"],
+}
+
+# tests the driver has to reject
+negatives = ["driver/pe_runaway.impala"]
+
+# compiler timeouts in seconds of tests that take longer than the default on purpose
+timeouts = {
+    "driver/pe_runaway.impala" : 60.0,
+}
+
+FRONT_END = ["parse", "name_analysis", "type_inference", "type_analysis"]
+
+def expect(cond, msg):
+    if not cond:
+        raise AssertionError(msg)
+
+def is_number(x):
+    return isinstance(x, (int, float)) and not isinstance(x, bool) and x >= 0
+
+def check_stats_json(output):
+    report = json.loads(output)
+    phases = report["phases"]
+    expect([p["name"] for p in phases][:len(FRONT_END)] == FRONT_END, "front-end phases missing or out of order")
+    for phase in phases:
+        for key in ["wall_ms", "cpu_ms", "allocations"]:
+            expect(is_number(phase[key]), "'%s' of phase '%s' is not a number" % (key, phase["name"]))
+        expect(isinstance(phase["rss_delta_kb"], (int, float)), "'rss_delta_kb' of phase '%s' is not a number" % phase["name"])
+        counters = phase["counters"]
+        expect(all(isinstance(v, int) and v >= 0 for v in counters.values()), "bad counters in phase '%s'" % phase["name"])
+    expect(phases[0]["counters"].get("tokens", 0) > 0, "parse does not count tokens")
+
+def check_stats_trace(output):
+    report = json.loads(output)
+    events = report["traceEvents"]
+    expect([e["name"] for e in events][:len(FRONT_END)] == FRONT_END, "front-end phases missing or out of order")
+    for event in events:
+        expect(event["ph"] == "X" and event["cat"] == "impala", "'%s' is not a complete event" % event["name"])
+        expect(is_number(event["ts"]) and is_number(event["dur"]), "'%s' has no timestamp or duration" % event["name"])
+        expect("counters" not in event["args"], "-time-passes reports counters")
+
+def check_time_passes(output):
+    lines = output.splitlines()
+    expect(lines[0].split() == ["phase", "wall", "ms", "cpu", "ms", "rss", "KiB", "allocs"], "bad header")
+    row = re.compile(r"^(\w+) +(\d+\.\d{3}) +(\d+\.\d{3}) +(-?\d+) +(\d+)$")
+    names = []
+    for line in lines[1:]:
+        m = row.match(line)
+        expect(m is not None, "bad row '%s'" % line)
+        names.append(m.group(1))
+    expect(names[:len(FRONT_END)] == FRONT_END and names[-1] == "total", "phases missing or out of order")
+
+def check_cost_report(output):
+    lines = output.splitlines()
+    expect(lines[0].split() == ["location", "function", "infer", "ms", "check", "ms", "emit", "ms", "total", "ms", "defs", "llvm"], "bad header")
+    row = re.compile(r"^(\S+) +(\w+) +(\d+\.\d{3}) +(\d+\.\d{3}) +(\d+\.\d{3}) +(\d+\.\d{3}) +(\d+) +(\d+)$")
+    rows = {}
+    for line in lines[1:-1]:
+        m = row.match(line)
+        expect(m is not None, "bad row '%s'" % line)
+        infer, check, emit, total = [float(m.group(i)) for i in range(3, 7)]
+        expect(abs(infer + check + emit - total) < 0.01, "total of '%s' is not the sum of its phases" % m.group(2))
+        rows[m.group(1)] = (m.group(2), int(m.group(7)), int(m.group(8)))
+    # rows are sorted by time, so only their set is pinned
+    expect(sorted(rows) == ["cost_report.impala:1", "cost_report.impala:15", "cost_report.impala:5"], "unexpected functions %s" % sorted(rows))
+    expect(rows["cost_report.impala:15"][0] == "main" and rows["cost_report.impala:15"][1] > 0, "no defs attributed to main")
+    expect(rows["cost_report.impala:15"][2] > 0, "no LLVM instructions attributed to main")
+    expect(re.match(r"^<unattributed> +\d+ +\d+$", lines[-1]) is not None, "bad last row '%s'" % lines[-1])
+
+def check_pe_report(output):
+    lines = output.splitlines()
+    expect(lines[0].split() == ["annotation", "callee", "specialized", "specializations", "defs"], "bad header")
+    expect(len(lines) == 3, "not one row per annotation")
+    row = lines[1].split()
+    expect(row[:3] == ["pe_report.impala:11:5", "power", "yes"], "bad row '%s'" % lines[1])
+    expect(all(field.isdigit() for field in row[3:]) and len(row) == 5, "bad counts in row '%s'" % lines[1])
+    # within the budget, the first trial compilation is the only one
+    expect(re.match(r"^residual program: \d+ defs after 1 trial compilation$", lines[2]) is not None, "bad last line '%s'" % lines[2])
+
+def check_pe_over_budget(output):
+    # no program fits into one def: the only annotation is residualized after the first trial and the second confirms it cannot do better
+    warning = r"^pe_over_budget\.impala:11 col \d+ - \d+: warning: partial evaluation leaves a program of \d+ defs, more than the budget of 1; residualizing instead of specializing$"
+    expect(re.search(warning, output, re.M) is not None, "no warning about the residualized annotation")
+    lines = [line for line in output.splitlines() if not re.match(warning, line)]
+    expect(lines[0].split() == ["annotation", "callee", "specialized", "specializations", "defs"], "bad header")
+    expect(lines[1].split()[:3] == ["pe_over_budget.impala:11:5", "power", "residualized"], "bad row '%s'" % lines[1])
+    expect(re.match(r"^residual program: \d+ defs after 2 trial compilations$", lines[2]) is not None, "bad last line '%s'" % lines[2])
+
+def check_pe_runaway(output):
+    # the optimizer never finishes, so a trial runs out of time however fast the machine is; the budget only has to end well
+    # before the test's timeout, and the compiler gives up rather than running the compilation itself
+    expect(re.search(r"partial evaluation does not finish within the budget of \d+ ms; giving up after \d+ trial compilations?$", output, re.M) is not None,
+           "runaway compilation not cut off")
+
+def check_vectorize_for(output):
+    lines = output.splitlines()
+    expect(lines[0].split() == ["loop", "kind", "required", "result"], "bad header")
+    rows = [line for line in lines[1:] if line.startswith("vectorize_for.impala:7:")]
+    expect(len(rows) == 1, "no row for the loop over vectorize")
+    # the front end vectorizes the body itself; the loop vectorizer may interleave the kernel loop on top of that
+    result = rows[0].split(None, 2)[2]
+    expect(not result.startswith("not vectorized"), "the kernel is scalar code: '%s'" % result)
+
+# reports that vary between runs or LLVM versions - timings, vectorizer results - are validated here instead of pinned in a .output file;
+# the others, such as the -remarks of each kind, are compared to the .output file next to their source
+checks = {
+    "driver/cost_report.impala"           : check_cost_report,
+    "driver/pe_over_budget.impala"        : check_pe_over_budget,
+    "driver/pe_report.impala"             : check_pe_report,
+    "driver/pe_runaway.impala"            : check_pe_runaway,
+    "driver/stats_json.impala"            : check_stats_json,
+    "driver/stats_trace.impala"           : check_stats_trace,
+    "driver/time_passes.impala"           : check_time_passes,
+    "driver/vectorize_for.impala"         : check_vectorize_for,
+}
+
+def allTests():
+    """
+    This function returns a list of tests.
+    """
+    tests = make_tests("driver", True)
+
+    for test in tests:
+        test.options = options.get(test.getName(), [])
+        test.check = checks.get(test.getName())
+        test.positive = test.getName() not in negatives
+        test.timeout = timeouts.get(test.getName())
+
+    return tests
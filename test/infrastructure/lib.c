@@ -1,5 +1,16 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+// only for sysconf - the read and write below are the test runtime's own
+#define read posix_read
+#define write posix_write
+#include <unistd.h>
+#undef read
+#undef write
 
 void print_char(char c) {
    printf("%c\n", (int)c);
@@ -98,3 +109,374 @@ void* impala_realloc(void* ptr, int size) {
 void impala_memmove(char* dest, const char* src, int size) {
     __builtin_memmove(dest, src, size);
 }
+
+// parallel, spawn and sync - the runtime functions Thorin lowers these intrinsics to
+//
+// A work-stealing pool: each worker owns a Chase-Lev deque of tasks, pushing and taking at its bottom while idle workers steal from its top
+// (Le et al., "Correct and Efficient Work-Stealing for Weak Memory Models", PPoPP 2013).
+// Threads outside the pool submit through a locked queue. A thread that waits for tasks - the caller of parallel or sync - runs tasks meanwhile.
+// The pool starts on first use with ANYDSL_NUM_THREADS workers or one per core; the calling thread counts as one of them.
+typedef void (*parallel_body)(void*, int32_t, int32_t);
+typedef void (*spawn_body)(void*);
+
+struct task {
+    void (*run)(struct task*);
+    atomic_int* pending;         // decremented when the task is done
+    struct task* next;           // in the queue of submitted tasks
+    void* fun;
+    void* args;
+    int32_t lower, upper, chunks; // the range of a parallel task and into how many chunks it is cut
+};
+
+struct deque_array {
+    int64_t size;
+    struct deque_array* prev;    // thieves may still read an array that was outgrown, so it is kept
+    _Atomic(struct task*) tasks[];
+};
+
+struct deque {
+    atomic_llong top, bottom;
+    _Atomic(struct deque_array*) array;
+    char padding[64];            // keeps the deques of different workers off one cache line
+};
+
+static struct deque_array* deque_array_create(int64_t size, struct deque_array* prev) {
+    struct deque_array* a = malloc(sizeof(struct deque_array) + size * sizeof(struct task*));
+    a->size = size;
+    a->prev = prev;
+    return a;
+}
+
+// by the owner only
+static void deque_push(struct deque* d, struct task* t) {
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    int64_t top = atomic_load_explicit(&d->top, memory_order_acquire);
+    struct deque_array* a = atomic_load_explicit(&d->array, memory_order_relaxed);
+    if (b - top > a->size - 1) {
+        struct deque_array* grown = deque_array_create(2 * a->size, a);
+        for (int64_t i = top; i != b; ++i)
+            atomic_store_explicit(&grown->tasks[i % grown->size], atomic_load_explicit(&a->tasks[i % a->size], memory_order_relaxed), memory_order_relaxed);
+        atomic_store_explicit(&d->array, grown, memory_order_release);
+        a = grown;
+    }
+    atomic_store_explicit(&a->tasks[b % a->size], t, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+}
+
+// by the owner only
+static struct task* deque_take(struct deque* d) {
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    struct deque_array* a = atomic_load_explicit(&d->array, memory_order_relaxed);
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t top = atomic_load_explicit(&d->top, memory_order_relaxed);
+    struct task* t = NULL;
+    if (top <= b) {
+        t = atomic_load_explicit(&a->tasks[b % a->size], memory_order_relaxed);
+        if (top == b) {
+            // the last task: race against thieves
+            if (!atomic_compare_exchange_strong_explicit(&d->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+                t = NULL;
+            atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        }
+    } else {
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    }
+    return t;
+}
+
+// by any thread
+static struct task* deque_steal(struct deque* d) {
+    int64_t top = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+    if (top >= b)
+        return NULL;
+    struct deque_array* a = atomic_load_explicit(&d->array, memory_order_acquire);
+    struct task* t = atomic_load_explicit(&a->tasks[top % a->size], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+        return NULL;
+    return t;
+}
+
+static struct {
+    pthread_once_t once;
+    int32_t num_workers;
+    struct deque* deques;
+
+    pthread_mutex_t mutex;       // guards the submitted tasks and sleeping
+    pthread_cond_t wake;
+    struct task* submitted_head;
+    struct task* submitted_tail;
+    atomic_int num_submitted;
+    atomic_uint_fast64_t epoch;  // counts new tasks, so that workers do not sleep through one
+    atomic_int num_sleeping;
+} pool = { PTHREAD_ONCE_INIT, 0, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, NULL, 0, 0, 0 };
+
+static _Thread_local int32_t worker_id = -1;
+
+static void pool_notify(void) {
+    atomic_fetch_add(&pool.epoch, 1);
+    if (atomic_load(&pool.num_sleeping) != 0) {
+        pthread_mutex_lock(&pool.mutex);
+        pthread_cond_broadcast(&pool.wake);
+        pthread_mutex_unlock(&pool.mutex);
+    }
+}
+
+static void pool_push(struct task* t) {
+    if (worker_id >= 0) {
+        deque_push(&pool.deques[worker_id], t);
+    } else {
+        t->next = NULL;
+        pthread_mutex_lock(&pool.mutex);
+        if (pool.submitted_tail != NULL)
+            pool.submitted_tail->next = t;
+        else
+            pool.submitted_head = t;
+        pool.submitted_tail = t;
+        atomic_fetch_add(&pool.num_submitted, 1);
+        pthread_mutex_unlock(&pool.mutex);
+    }
+    pool_notify();
+}
+
+static struct task* pool_find(uint32_t* seed) {
+    struct task* t = NULL;
+    if (worker_id >= 0 && (t = deque_take(&pool.deques[worker_id])) != NULL)
+        return t;
+
+    if (atomic_load(&pool.num_submitted) != 0) {
+        pthread_mutex_lock(&pool.mutex);
+        if ((t = pool.submitted_head) != NULL) {
+            pool.submitted_head = t->next;
+            if (pool.submitted_head == NULL)
+                pool.submitted_tail = NULL;
+            atomic_fetch_sub(&pool.num_submitted, 1);
+        }
+        pthread_mutex_unlock(&pool.mutex);
+        if (t != NULL)
+            return t;
+    }
+
+    // start at a random victim so that thieves spread out
+    *seed = *seed * 1103515245 + 12345;
+    int32_t first = (*seed >> 16) % pool.num_workers;
+    for (int32_t i = 0; i != pool.num_workers; ++i) {
+        int32_t victim = (first + i) % pool.num_workers;
+        if (victim != worker_id && (t = deque_steal(&pool.deques[victim])) != NULL)
+            return t;
+    }
+    return NULL;
+}
+
+static void task_run(struct task* t) {
+    atomic_int* pending = t->pending;
+    t->run(t);
+    free(t);
+    atomic_fetch_sub_explicit(pending, 1, memory_order_release);
+}
+
+static void* worker_main(void* p) {
+    worker_id = (int32_t)(intptr_t)p;
+    uint32_t seed = worker_id;
+    int failed = 0;
+    while (1) {
+        uint_fast64_t epoch = atomic_load(&pool.epoch);
+        struct task* t = pool_find(&seed);
+        if (t != NULL) {
+            task_run(t);
+            failed = 0;
+        } else if (++failed < 64) {
+            sched_yield();
+        } else {
+            pthread_mutex_lock(&pool.mutex);
+            atomic_fetch_add(&pool.num_sleeping, 1);
+            if (atomic_load(&pool.epoch) == epoch)
+                pthread_cond_wait(&pool.wake, &pool.mutex);
+            atomic_fetch_sub(&pool.num_sleeping, 1);
+            pthread_mutex_unlock(&pool.mutex);
+            failed = 0;
+        }
+    }
+    return NULL;
+}
+
+static void pool_start(void) {
+    const char* env = getenv("ANYDSL_NUM_THREADS");
+    long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    pool.num_workers = env != NULL && atoi(env) > 0 ? atoi(env) : num_cpus > 0 ? (int) num_cpus : 1;
+    pool.deques = calloc(pool.num_workers, sizeof(struct deque));
+    for (int32_t i = 0; i != pool.num_workers; ++i)
+        atomic_store(&pool.deques[i].array, deque_array_create(64, NULL));
+
+    // the thread that starts the pool is worker 0
+    worker_id = 0;
+    for (int32_t i = 1; i != pool.num_workers; ++i) {
+        pthread_t thread;
+        pthread_create(&thread, NULL, worker_main, (void*)(intptr_t)i);
+        pthread_detach(thread);
+    }
+}
+
+// runs tasks until *pending drops to 0
+static void pool_wait(atomic_int* pending) {
+    uint32_t seed = worker_id + 1;
+    while (atomic_load_explicit(pending, memory_order_acquire) != 0) {
+        struct task* t = pool_find(&seed);
+        if (t != NULL)
+            task_run(t);
+        else
+            sched_yield();
+    }
+}
+
+// splits off the upper half of the chunks as long as there is more than one - the halves go to the deque, where idle workers steal the largest
+static void run_parallel_task(struct task* t) {
+    while (t->chunks > 1) {
+        int32_t half = t->chunks / 2;
+        int32_t middle = t->upper - (int32_t)(((int64_t)t->upper - t->lower) * half / t->chunks);
+        struct task* upper = malloc(sizeof(struct task));
+        *upper = *t;
+        upper->lower = middle;
+        upper->chunks = half;
+        atomic_fetch_add_explicit(t->pending, 1, memory_order_relaxed);
+        pool_push(upper);
+        t->upper = middle;
+        t->chunks -= half;
+    }
+    ((parallel_body)t->fun)(t->args, t->lower, t->upper);
+}
+
+// num_threads bounds the parallelism of the loop: [lower, upper) is cut into that many chunks, so at most as many threads run its body.
+// 0 means the whole pool; then each worker gets a few chunks, which balances uneven iterations.
+void anydsl_parallel_for(int32_t num_threads, int32_t lower, int32_t upper, void* args, void* fun) {
+    int64_t n = (int64_t)upper - lower;
+    if (n <= 0)
+        return;
+    pthread_once(&pool.once, pool_start);
+    int64_t chunks = num_threads > 0 ? num_threads : 4 * (int64_t)pool.num_workers;
+
+    atomic_int pending = 1;
+    struct task* t = malloc(sizeof(struct task));
+    t->run = run_parallel_task;
+    t->pending = &pending;
+    t->fun = fun;
+    t->args = args;
+    t->lower = lower;
+    t->upper = upper;
+    t->chunks = (int32_t)(chunks < n ? chunks : n);
+    task_run(t);
+    pool_wait(&pending);
+}
+
+// a spawned task stays known by its id until it is synced; then the id is free for the next spawn
+static pthread_mutex_t spawned_mutex = PTHREAD_MUTEX_INITIALIZER;
+static atomic_int** spawned_tasks = NULL;
+static int32_t num_spawned_tasks = 0;
+static int32_t* free_ids = NULL;
+static int32_t num_free_ids = 0;
+
+static void run_spawned_task(struct task* t) { ((spawn_body)t->fun)(t->args); }
+
+int32_t anydsl_spawn_thread(void* args, void* fun) {
+    pthread_once(&pool.once, pool_start);
+    atomic_int* pending = malloc(sizeof(atomic_int));
+    atomic_init(pending, 1);
+
+    pthread_mutex_lock(&spawned_mutex);
+    int32_t id;
+    if (num_free_ids != 0) {
+        id = free_ids[--num_free_ids];
+    } else {
+        id = num_spawned_tasks++;
+        spawned_tasks = realloc(spawned_tasks, num_spawned_tasks * sizeof(atomic_int*));
+        free_ids = realloc(free_ids, num_spawned_tasks * sizeof(int32_t));
+    }
+    spawned_tasks[id] = pending;
+    pthread_mutex_unlock(&spawned_mutex);
+
+    struct task* t = malloc(sizeof(struct task));
+    t->run = run_spawned_task;
+    t->pending = pending;
+    t->fun = fun;
+    t->args = args;
+    pool_push(t);
+    return id;
+}
+
+void anydsl_sync_thread(int32_t id) {
+    pthread_mutex_lock(&spawned_mutex);
+    atomic_int* pending = id >= 0 && id < num_spawned_tasks ? spawned_tasks[id] : NULL;
+    if (pending != NULL) {
+        spawned_tasks[id] = NULL;
+        free_ids[num_free_ids++] = id;
+    }
+    pthread_mutex_unlock(&spawned_mutex);
+    if (pending == NULL)
+        return;
+    pool_wait(pending);
+    free(pending);
+}
+
+// atomic accesses with memory orderings - what the front end calls where Thorin's own atomic and cmpxchg, which are seq_cst, do not do
+//
+// Orderings come numbered as by LLVM (2 relaxed, 4 acquire, 5 release, 6 acq_rel, 7 seq_cst) and values as unsigned integers of their size.
+// Once inlined - see -link-bitcode - the orderings are constants and each helper folds to the single instruction it wraps.
+static int atomic_order(uint32_t order) {
+    switch (order) {
+        case 2:  return __ATOMIC_RELAXED;
+        case 4:  return __ATOMIC_ACQUIRE;
+        case 5:  return __ATOMIC_RELEASE;
+        case 6:  return __ATOMIC_ACQ_REL;
+        default: return __ATOMIC_SEQ_CST;
+    }
+}
+
+// a failed cmpxchg only loads: it drops the release half of the ordering
+static int failure_order(uint32_t order) {
+    return order == 5 ? __ATOMIC_RELAXED : order == 6 ? __ATOMIC_ACQUIRE : atomic_order(order);
+}
+
+// op as numbered by LLVM's atomicrmw; max and min compare signed, umax and umin unsigned
+#define IMPALA_ATOMICS(N) \
+    uint##N##_t impala_atomic_load_##N(uint##N##_t* p, uint32_t order) { \
+        return __atomic_load_n(p, atomic_order(order)); \
+    } \
+    void impala_atomic_store_##N(uint##N##_t* p, uint##N##_t v, uint32_t order) { \
+        __atomic_store_n(p, v, atomic_order(order)); \
+    } \
+    uint##N##_t impala_atomic_rmw_##N(uint32_t op, uint##N##_t* p, uint##N##_t v, uint32_t order) { \
+        int mo = atomic_order(order); \
+        switch (op) { \
+            case 0: return __atomic_exchange_n(p, v, mo); \
+            case 1: return __atomic_fetch_add(p, v, mo); \
+            case 2: return __atomic_fetch_sub(p, v, mo); \
+            case 3: return __atomic_fetch_and(p, v, mo); \
+            case 4: return __atomic_fetch_nand(p, v, mo); \
+            case 5: return __atomic_fetch_or(p, v, mo); \
+            case 6: return __atomic_fetch_xor(p, v, mo); \
+        } \
+        uint##N##_t old = __atomic_load_n(p, __ATOMIC_RELAXED); \
+        for (;;) { \
+            int keep = op == 7 ? (int##N##_t) old >= (int##N##_t) v : op == 8 ? (int##N##_t) old <= (int##N##_t) v : op == 9 ? old >= v : old <= v; \
+            if (__atomic_compare_exchange_n(p, &old, keep ? old : v, 1, mo, failure_order(order))) \
+                return old; \
+        } \
+    } \
+    bool impala_cmpxchg_##N(uint##N##_t* p, uint##N##_t* expected, uint##N##_t desired, uint32_t success, uint32_t failure) { \
+        return __atomic_compare_exchange_n(p, expected, desired, 0, atomic_order(success), failure_order(failure)); \
+    } \
+    bool impala_cmpxchg_weak_##N(uint##N##_t* p, uint##N##_t* expected, uint##N##_t desired, uint32_t success, uint32_t failure) { \
+        return __atomic_compare_exchange_n(p, expected, desired, 1, atomic_order(success), failure_order(failure)); \
+    }
+
+IMPALA_ATOMICS(8)
+IMPALA_ATOMICS(16)
+IMPALA_ATOMICS(32)
+IMPALA_ATOMICS(64)
+
+void impala_fence(uint32_t order) {
+    __atomic_thread_fence(atomic_order(order));
+}
@@ -5,7 +5,7 @@ Created on 8 Dec 2013
 '''
 
 from __future__ import absolute_import
-import sys, os, difflib, shutil, imp, tempfile
+import sys, os, re, difflib, shutil, imp, tempfile
 from .timed_process import CompileProcess, RuntimeProcess
 from .valgrindxml import ValgrindXML
 import traceback
@@ -106,6 +106,10 @@ class CompilerOutputTest(Test):
     srcfile = ""
     options = ""
     result = None
+    # if set, called with the decoded output instead of comparing it to 'result' - for output that varies between runs
+    check = None
+    # if set, the compiler timeout in seconds instead of CompileProcess.timeout
+    timeout = None
 
     def __init__(self, positive, base, src, res, options=[]):
         super(CompilerOutputTest, self).__init__(base, src, options)
@@ -114,7 +118,7 @@ class CompilerOutputTest(Test):
 
     def invoke(self, gEx):
         execCmd = [gEx] + self.options + [self.srcfile]
-        p = CompileProcess(execCmd, self.basedir)
+        p = CompileProcess(execCmd, self.basedir, self.timeout)
         p.execute()
         return self.checkBasics(p) and self.checkOutput(p)
 
@@ -126,6 +130,16 @@ class CompilerOutputTest(Test):
             print
             return False
 
+        if self.check is not None:
+            try:
+                self.check(output.decode('utf-8'))
+            except Exception as e:
+                print("[FAIL] "+os.path.join(self.basedir, self.srcfile))
+                print("  %s" % e)
+                print("Output: "+output.decode('utf-8', 'replace'))
+                return False
+            return True
+
         if self.result is None:
             return True
 
@@ -145,6 +159,10 @@ class InvokeTest(Test):
     args = None
 
     LIB_C = os.path.join(os.path.dirname(__file__), "lib.c")
+    LIB_SO = os.path.join(tempfile.gettempdir(), "impala_test_lib.so")
+
+    # if set, tests are executed in process via 'impala -run' instead of being compiled and linked externally
+    jit = False
 
     def __init__(self, base, src, output_file, options=[], benchmarks=False, compare=None, input_file=None):
         super(InvokeTest, self).__init__(base, src, options+["-emit-llvm"])
@@ -167,13 +185,40 @@ class InvokeTest(Test):
         yield [gEx] + self.options + [os.path.join(self.basedir, self.srcfile)]
         if(self.benchmarks):
             yield ["clang", "-O3", InvokeTest.LIB_C, "-c"]
-            yield ["clang", "-O3", "lib.o", self.ll_file, "-L", "/opt/local/lib", "-lm", "-lpcre", "-lgmp", "-s", "-o", self.exe_file]
+            yield ["clang", "-O3", "lib.o", self.ll_file, "-L", "/opt/local/lib", "-lm", "-lpcre", "-lgmp", "-lpthread", "-s", "-o", self.exe_file]
         else:
             yield ["llc", "-o", self.s_file, self.ll_file]
-            yield ["cc", "-o", self.exe_file, self.s_file, InvokeTest.LIB_C]
+            yield ["cc", "-o", self.exe_file, self.s_file, InvokeTest.LIB_C, "-lpthread"]
+
 
+    def invokeJit(self, gEx):
+        # benchmarks also need the libraries they call into; dlsym on lib.so searches its dependencies
+        lib_so = InvokeTest.LIB_SO.replace(".so", "_bench.so") if self.benchmarks else InvokeTest.LIB_SO
+        if not os.path.exists(lib_so) or os.path.getmtime(lib_so) < os.path.getmtime(InvokeTest.LIB_C):
+            libs = ["-L", "/opt/local/lib", "-Wl,--no-as-needed", "-lm", "-lpcre", "-lgmp", "-lpthread"] if self.benchmarks else ["-lm", "-lpthread"]
+            p = CompileProcess(["cc", "-O2", "-shared", "-fPIC", "-o", lib_so, InvokeTest.LIB_C] + libs, ".")
+            p.execute()
+            if not (self.checkBasics(p) and self.compilationSuccess(p)):
+                return False
+
+        options = [o for o in self.options if o != "-emit-llvm"]
+        if self.benchmarks:
+            options.append("-O3")
+        cmd = [gEx] + options + ["-run", "-load", lib_so, os.path.join(self.basedir, self.srcfile), "--"]
+        if self.args is not None:
+            cmd.extend(self.args)
+
+        p = RuntimeProcess(cmd, ".", CompileProcess.timeout + RuntimeProcess.timeout)
+        if self.input_file is not None:
+            p.setInput(self.input_file)
+        p.execute()
+        return self.checkBasics(p) and self.checkOutput(p)
 
     def invoke(self, gEx):
+        # the JIT does not leave the emitted LLVM IR behind, so tests with CHECK-LL lines take the compiled path
+        if InvokeTest.jit and not self.llvmChecks():
+            return self.invokeJit(gEx)
+
         # if any tmp file already exists do not touch it and fail
         #for tmp in self.tmp_files:
         #    if os.path.exists(tmp):
@@ -183,11 +228,13 @@ class InvokeTest(Test):
         #        return False
 
         try:
-            for phase in self.compilePhases(gEx):
+            for i, phase in enumerate(self.compilePhases(gEx)):
                 p = CompileProcess(phase, ".")
                 p.execute()
                 if not (self.checkBasics(p) and self.compilationSuccess(p)):
                     return False
+                if i == 0 and not self.checkLLVM():
+                    return False
 
             # run executable
             if self.args is None:
@@ -226,6 +273,27 @@ class InvokeTest(Test):
                         return diff_output(f.read(), g.read())
         return True
 
+    def llvmChecks(self):
+        """The regexes of the '// CHECK-LL: <regex>' lines of the source."""
+        with open(os.path.join(self.basedir, self.srcfile)) as f:
+            return [line.split("CHECK-LL:", 1)[1].strip() for line in f if line.lstrip().startswith("// CHECK-LL:")]
+
+    def checkLLVM(self):
+        """Each '// CHECK-LL: <regex>' line of the source must match somewhere in the emitted LLVM IR."""
+        checks = self.llvmChecks()
+        if not checks:
+            return True
+
+        with open(self.ll_file) as f:
+            ll = f.read()
+        for check in checks:
+            if re.search(check, ll) is None:
+                print("[FAIL] "+os.path.join(self.basedir, self.srcfile))
+                print("  No match for '%s' in %s" % (check, self.ll_file))
+                print
+                return False
+        return True
+
     def cleanup(self, file):
         if os.path.exists(file):
             os.remove(file)
@@ -13,6 +13,8 @@ Command line options:
  -r, --runtime-timeout <floating point value in seconds>
                          Default is 5.0
  -L, --valgrind   Use valgrind to check for memory leaks during testing
+ -j, --jit        Run codegen tests in process via 'impala -run' instead of llc/cc,
+                  except those with CHECK-LL lines, which need the emitted LLVM IR
 """
 
 import infrastructure.tests
@@ -61,7 +63,7 @@ def main():
     
     # get cmd file
     try:
-        opts, args = getopt.getopt(sys.argv[1:], "he:t:r:L", ["help", "executable", "compiler-timeout", "runtime-timeout", "valgrind"])
+        opts, args = getopt.getopt(sys.argv[1:], "he:t:r:Lj", ["help", "executable", "compiler-timeout", "runtime-timeout", "valgrind", "jit"])
     except getopt.error as msg:
         print(msg)
         sys.exit(2)
@@ -79,6 +81,8 @@ def main():
             RuntimeProcess.timeout = float(a)
         if o in ("-L", "--valgrind"):
             valgrind = True
+        if o in ("-j", "--jit"):
+            infrastructure.tests.InvokeTest.jit = True
 
     if len(args) > 1:
         print("You specified too many arguments.")